@@ -1,24 +1,68 @@
 #pragma once
+#include <memory>
+#include <vector>
+#include "audio_ring.h"
+#include "state_io.h"
 #include "types.h"
 
 namespace nes {
 
 // NES 2A03 audio processing unit: two pulse channels, triangle, noise, and a
-// frame sequencer. Clocked once per CPU cycle; produces mono float samples into
-// an internal ring buffer that the front-end drains for WebAudio playback.
-// (DMC is not synthesized; its registers are accepted as no-ops.)
+// frame sequencer, advanced in CPU cycles. Output is band-limited step
+// synthesis: whenever the mixed level changes, the delta is spread over a few
+// output samples with a windowed-sinc step. Mono float samples are integrated
+// from those in blocks on the emulating thread and queued in an AudioRing,
+// which the front-end (WebAudio, or an audio callback on its own thread)
+// drains. (DMC is not synthesized; its registers are accepted as no-ops.)
 class APU {
  public:
   APU();
 
   void reset();
+  // Channel and sequencer state. Loading starts a fresh sample stream, like
+  // set_synthesis(); queued samples stay queued.
+  void io_state(StateIO& s);
   void clock();                       // advance one CPU cycle
+  // Advance `cycles` CPU cycles; same result as clock() in a loop, but skips
+  // straight over the stretches in which no timer or sequencer step fires.
+  void run(u32 cycles);
+  // Queue every finished sample. run() does this before it returns; clock()
+  // only queues in blocks.
+  void flush();
+
+  // With synthesis off no samples are made (available() stays 0) and run()
+  // only stops at frame-sequencer steps, moving the channel timers forward
+  // arithmetically; length counters and $4015 stay exact. Turning it back on
+  // starts a fresh sample stream. Kept across reset(); on by default.
+  void set_synthesis(bool enabled);
+  bool synthesis() const;
+
+  // Set the sample stream aside while the machine runs frames nobody will
+  // hear (run-ahead): none are made until resume_stream(), which picks the
+  // stream up exactly where it was. Resume only once the machine is back in
+  // the state it was paused in (Bus::load_state), so the levels line up.
+  void pause_stream();
+  void resume_stream();
+
+  // Output rate in samples per second (8000-96000; 44100 by default) and the
+  // queue's capacity in samples, which bounds latency. Starts a fresh stream
+  // with an empty queue, so set it before a consumer thread starts draining.
+  void set_output(u32 sample_rate, u32 capacity);
+  u32 sample_rate() const;
+
   void write(u16 address, u8 value);  // $4000-$4017 register write
   u8 read_status() const;             // $4015 read
 
+  // Consumer side: these touch only the queue, so one thread other than the
+  // emulating one may call them -- but Bus::get_apu() runs the APU, so that
+  // thread must reach the queue through Bus::audio_queue() instead.
   // Drain up to `max` queued samples into `out`; returns the count written.
   int drain(float* out, int max);
-  int available() const;
+  int available() const;  // queued samples
+  u32 capacity() const;
+  u64 overruns() const;   // samples dropped because the queue was full
+  u64 underruns() const;  // drains that found the queue empty
+  AudioRing& queue() { return *_ring; }
 
  private:
   // --- envelope (pulse + noise) ---
@@ -27,6 +71,7 @@ class APU {
     u8 volume = 0, decay = 0, divider = 0;
     void clock();
     u8 output() const { return constant ? volume : decay; }
+    void io_state(StateIO& s);
   };
 
   // --- pulse channel ---
@@ -46,6 +91,7 @@ class APU {
     u16 target_period() const;
     bool muted() const;
     u8 output() const;
+    void io_state(StateIO& s);
   };
 
   // --- triangle ---
@@ -57,6 +103,7 @@ class APU {
     u8 step = 0;
     void clock_timer();
     u8 output() const;
+    void io_state(StateIO& s);
   };
 
   // --- noise ---
@@ -66,12 +113,18 @@ class APU {
     u8 length = 0;
     Envelope env;
     void clock_timer();
+    void shift_lfsr();
     u8 output() const;
+    void io_state(StateIO& s);
   };
 
   void clock_quarter_frame();  // envelopes + triangle linear counter
   void clock_half_frame();     // length counters + sweeps
-  float mix() const;
+  void clock_frame_step();     // the sequencer step due at _frame_next
+  u32 quiet_cycles() const;    // cycles before the next timer/sequencer event
+  void skip(u32 cycles);       // advance that many event-free cycles
+  void fast_forward(u32 cycles);  // timers only, no sequencer step due
+  void update_level();         // re-mix; emit a step if the level moved
 
   Pulse _pulse1, _pulse2;
   Triangle _triangle;
@@ -79,16 +132,36 @@ class APU {
 
   u32 _frame_cycles = 0;  // CPU cycles into the current frame sequence
   u8 _frame_mode = 0;     // 0 = 4-step, 1 = 5-step
+  u8 _frame_step = 0;     // index of the next sequencer step
+  u32 _frame_next = 0;    // _frame_cycles value at which it is due
   bool _apu_cycle = false;  // pulse/noise timers tick every other CPU cycle
 
-  // sample generation
-  double _sample_accum = 0.0;
-  float _hp_prev_in = 0.0f, _hp_prev_out = 0.0f;  // DC-blocking high-pass
+  // Sample generation. _buf holds each level change as a band-limited
+  // impulse; the running sum of it is the output. Samples before _pos are
+  // final, and are queued once FLUSH_AT of them have built up.
+  static constexpr int FLUSH_AT = 1024;
+  static constexpr int BUFFER = FLUSH_AT + 2048 + 16;  // + one skip() at 96kHz + the kernel
+  int staged() const { return static_cast<int>(_pos >> 32); }
+  void clear_samples();
 
-  static constexpr int RING = 8192;
-  float _ring[RING] = {0};
-  int _ring_w = 0, _ring_r = 0;
-  void push_sample(float s);
+  bool _synthesis = true;
+  u32 _sample_rate = 0;
+  u64 _sample_step = 0;  // output samples per CPU cycle, 32.32 fixed point
+  float _hp_coeff = 0.0f;
+  u64 _pos = 0;        // 32.32 fixed-point output sample of the current cycle
+  float _level = 0.0f;  // pulse_table/tnd_table mix of the channel outputs
+  float _sum = 0.0f;
+  float _hp_prev_in = 0.0f, _hp_prev_out = 0.0f;  // DC-blocking high-pass
+  float _buf[BUFFER] = {0};
+  float _block[BUFFER];  // samples on their way into _ring
+  // pause_stream()'s copy of the generation state above.
+  struct Paused {
+    bool synthesis = false;
+    u64 pos = 0;
+    float level = 0.0f, sum = 0.0f, hp_prev_in = 0.0f, hp_prev_out = 0.0f;
+    std::vector<float> buf;
+  } _paused;
+  std::unique_ptr<AudioRing> _ring;
 };
 
 }  // namespace nes
@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <vector>
+#include "types.h"
+
+namespace nes {
+
+// Single-producer / single-consumer sample queue between the emulation thread
+// (push) and an audio callback (pop), lock-free: each side owns one index and
+// publishes it with a release store that the other side reads with acquire.
+// Neither side ever blocks or waits; a push that does not fit drops the excess
+// (counted as overrun) and a pop that finds the ring empty counts an underrun.
+// A short pop is not one: hosts that drain whatever is queued ask for more
+// than they expect. They can steer their resampling ratio from
+// size()/capacity() and the counters instead of hearing drops.
+class AudioRing {
+ public:
+  explicit AudioRing(u32 capacity = 8192);  // rounded up to a power of two
+
+  // Producer side. Returns how many samples fit.
+  u32 push(const float* samples, u32 count);
+
+  // Consumer side. Returns how many samples were copied into `out`.
+  u32 pop(float* out, u32 max);
+
+  // Either side.
+  u32 size() const;
+  u32 capacity() const { return _mask + 1; }
+  u64 overruns() const { return _overruns.load(std::memory_order_relaxed); }  // samples dropped
+  u64 underruns() const { return _underruns.load(std::memory_order_relaxed); }  // pops that found it empty
+
+ private:
+  std::vector<float> _data;
+  u32 _mask;
+  // Free-running indices (wrap at 2^32; size is their difference), kept on
+  // separate cache lines so the two threads don't false-share.
+  alignas(64) std::atomic<u32> _write{0};  // next slot the producer fills
+  alignas(64) std::atomic<u32> _read{0};   // next slot the consumer takes
+  std::atomic<u64> _overruns{0};
+  std::atomic<u64> _underruns{0};
+};
+
+}  // namespace nes
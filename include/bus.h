@@ -6,6 +6,7 @@
 #include "controller.h"
 #include "cpu.h"
 #include "ppu.h"
+#include "scheduler.h"
 #include "types.h"
 
 namespace nes {
@@ -15,28 +16,90 @@ class Bus {
   ~Bus() = default;
 
  public:
-  void cpu_write(u16 address, u8 data);
-  u8 cpu_read(u16 address) const;
+  // RAM (and its mirrors), PRG-RAM, and the mapped PRG-ROM banks are a single
+  // page-table lookup; everything else goes through the device handlers.
+  void cpu_write(u16 address, u8 data) {
+    if (u8* page = _write_pages[address >> 10]) {
+      page[address & 0x3FF] = data;
+    } else {
+      io_write(address, data);
+    }
+  }
+  u8 cpu_read(u16 address) const {
+    const u8* page = _read_pages[address >> 10];
+    return page ? page[address & 0x3FF] : io_read(address);
+  }
 
  public:
   void clock();
+  // One whole instruction (plus any DMA stall or interrupt entry it runs
+  // into), i.e. clock() until the CPU's remaining cycles drain. Returns the
+  // cycles taken. In catch-up mode (the default) the CPU runs ahead and the
+  // PPU/APU are only advanced when the CPU touches them or a precomputed
+  // NMI / mapper IRQ / frame deadline is reached; the result is bit-identical
+  // to lockstep. Call sync() before inspecting the PPU or APU directly.
+  int step();
+  void sync();  // bring the PPU and APU up to the CPU's clock
+  void set_catch_up(bool enabled);
+  bool catch_up() const;
   void reset();
+
+  // Snapshots: a flat, fixed-layout image of the whole machine -- CPU, RAM,
+  // DMA stall, controllers, PPU, APU channels and the cartridge's mapper
+  // registers and RAM -- a few tens of KB of memcpy either way.
+  // state_size() is fixed for a given cartridge; load_state() returns false
+  // and leaves the machine as it was if `data` is not a snapshot of that
+  // size from a cartridge of the same board and bank counts.
+  size_t state_size();
+  void save_state(u8* out);
+  bool load_state(const u8* data, size_t size);
+
   CPU& get_cpu();
   PPU& get_ppu();
+  // The APU is lazy in both modes: it runs only on register access and here,
+  // so this catches it up first.
   APU& get_apu();
+  // The APU's sample queue, without catching anything up: the one call an
+  // audio thread may make while another thread emulates (pop, size and the
+  // counters only).
+  AudioRing& audio_queue();
   void insert_cartridge(const std::shared_ptr<Cartridge>& cartridge);
   // Latch controller button state. port 0 = player 1 ($4016), 1 = player 2.
   void set_controller(int port, u8 buttons);
 
+ private:
+  void io_write(u16 address, u8 data);
+  u8 io_read(u16 address) const;
+  void map_pages();  // rebuild the page tables (new cartridge / bank switch)
+  void sync_ppu() const;
+  void sync_apu() const;
+  void schedule_events();  // repost every deadline from the PPU/mapper state
+  void run_events();       // end of a deadline cycle: catch up, poll NMI/IRQ
+  void poll_irq();
+  void io_state(StateIO& s);
+
  private:
   static constexpr size_t _CPU_RAM_SIZE = 2 * 1024;  // 2KB
-  u32 _sys_clock = 0;
+  static constexpr size_t _PAGES = 64;               // 1KB pages of CPU space
+  u64 _sys_clock = 0;
   int _dma_stall = 0;  // CPU cycles remaining stalled by an OAM ($4014) DMA
+  bool _catch_up = true;
+  // Catch-up state: cycles the PPU/APU have been clocked through, and when
+  // the next NMI / mapper IRQ / frame wrap lands.
+  // mutable: register reads on the const path may need to catch up first.
+  mutable u64 _ppu_clock = 0;
+  mutable u64 _apu_clock = 0;
+  mutable bool _events_dirty = true;  // a write may have moved a deadline
+  Scheduler _scheduler;
+  bool _irq_line = false;  // mapper IRQ level, refreshed when it can change
   CPU _cpu;
-  PPU _ppu;
-  APU _apu;
+  mutable PPU _ppu;
+  mutable APU _apu;
   std::shared_ptr<Cartridge> _cartridge;
   std::array<u8, _CPU_RAM_SIZE> _ram{0};
   mutable Controller _pad[2];  // mutable: serial reads shift on a const read path
+  // Host pointers per 1KB CPU page; nullptr = use io_read/io_write.
+  std::array<const u8*, _PAGES> _read_pages{};
+  std::array<u8*, _PAGES> _write_pages{};
 };
 }  // namespace nes
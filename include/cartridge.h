@@ -2,13 +2,16 @@
 #include <memory>
 #include <string>
 #include <vector>
+#include "chr_cache.h"
 #include "mapper.h"
 #include "types.h"
 
 namespace nes {
 class Cartridge {
  public:
-  enum class MirrorMode { HORIZONTAL, VERTICAL, SINGLE_LO, SINGLE_HI };
+  // FOUR_SCREEN: the board carries 2KB of extra VRAM, so each of the four
+  // logical nametables is its own page and mapper mirroring is ignored.
+  enum class MirrorMode { HORIZONTAL, VERTICAL, SINGLE_LO, SINGLE_HI, FOUR_SCREEN };
 
   std::vector<u8> _prg_memory;
   std::vector<u8> _chr_memory;
@@ -22,28 +25,71 @@ class Cartridge {
  private:
   MirrorMode _mirror = MirrorMode::HORIZONTAL;
   bool _chr_is_ram = false;
-  Cartridge() = default;  // used by from_ines
+  // Decoded CHR tiles: shared with every cart holding the same CHR-ROM, or
+  // this cart's own copy (_chr_ram_tiles) kept current by ppu_write().
+  std::shared_ptr<const ChrCache> _chr_cache;
+  ChrCache* _chr_ram_tiles = nullptr;
+  // A clone() reads PRG-ROM and CHR-ROM from the cartridge it was cloned
+  // from (its own vectors stay empty) instead of copying them.
+  std::shared_ptr<const Cartridge> _rom;
+  Cartridge() = default;  // used by from_ines and clone
+  void build_chr_cache();
+  const std::vector<u8>& prg_rom() const { return _rom ? _rom->_prg_memory : _prg_memory; }
 
  public:
   Cartridge(const std::string& file);
   virtual ~Cartridge() = default;
 
-  // In-memory iNES factory. out_status: 0 ok, 1 bad-header, 2 unsupported-mapper,
-  // 3 four-screen-unsupported. Supports mappers 0,1,2,3,4. Returns nullptr on error.
+  // In-memory iNES factory. out_status: 0 ok, 1 bad-header, 2 unsupported-mapper.
+  // Supports mappers 0,1,2,3,4. Returns nullptr on error.
   static std::shared_ptr<Cartridge> from_ines(const std::vector<u8>& bytes,
                                               int& out_status);
 
+  // An independent cartridge in the same state as `source`: its own mapper,
+  // PRG-RAM and CHR-RAM, sharing the read-only PRG-ROM, CHR-ROM and decoded
+  // tiles. For cartridges built by from_ines or from a file (a subclass
+  // overriding the IO is copied as a plain Cartridge).
+  static std::shared_ptr<Cartridge> clone(const std::shared_ptr<const Cartridge>& source);
+
   // Current mirroring, honoring a mapper override (MMC1/MMC3) over the header.
+  // Mapper register writes can change it; the PPU caches it (see
+  // PPU::update_mirroring).
   MirrorMode mirror_mode() const;
 
   // MMC3 scanline IRQ plumbing (no-ops for other mappers).
   void signal_scanline();
   bool irq_pending() const;
   void irq_clear();
+  int scanlines_until_irq() const;  // see Mapper::scanlines_until_irq
+
+  // Mapper registers, PRG-RAM and CHR-RAM (CHR-ROM and PRG-ROM are the
+  // image itself and are not included).
+  void io_state(StateIO& s);
 
   virtual bool cpu_read(u16 address, u8& data) const;
   virtual bool ppu_read(u16 address, u8& data) const;
   virtual bool cpu_write(u16 address, u8 value);
   virtual bool ppu_write(u16 address, u8 value);
+
+  // Host memory behind the 1KB CPU page containing `address` (PRG-RAM, or the
+  // PRG-ROM bank currently mapped there), or nullptr if accesses must go
+  // through cpu_read/cpu_write. The Bus caches these and re-asks after mapper
+  // register writes, so a subclass overriding the IO above must override
+  // these too.
+  virtual const u8* cpu_read_page(u16 address) const;
+  virtual u8* cpu_write_page(u16 address);
+
+  // The 8 decoded pixels (see ChrCache::row) of the pattern row at PPU
+  // address `address` in $0000-$1FFF through the current CHR banks, or
+  // nullptr if there is no cache (CHR filled in after construction, as test
+  // doubles do) and the caller must decode ppu_read() bytes itself.
+  const u8* chr_row(u16 address, bool flip) const {
+    return _chr_cache ? _chr_cache->row(_mapper->chr_offset(address), flip) : nullptr;
+  }
+  const ChrCache* chr_cache() const { return _chr_cache.get(); }
+  // CHR-ROM or CHR-RAM bytes; use this rather than _chr_memory, which is
+  // empty in a clone of a CHR-ROM cartridge.
+  const std::vector<u8>& chr_memory() const { return _rom && !_chr_is_ram ? _rom->_chr_memory : _chr_memory; }
+  bool chr_is_ram() const { return _chr_is_ram; }
 };
 };  // namespace nes
@@ -0,0 +1,44 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "types.h"
+
+namespace nes {
+
+// CHR pattern data pre-decoded into "chunky" pixels: every 16-byte tile
+// becomes 8 rows of 8 two-bit pixel values (0..3), plus a horizontally
+// flipped copy for sprites, so the renderer indexes a byte per pixel instead
+// of slicing two bitplanes. Rows are addressed by CHR offset, the same
+// offset Mapper::chr_offset() produces.
+class ChrCache {
+ public:
+  explicit ChrCache(const std::vector<u8>& chr);
+
+  // The decoded tiles for a CHR-ROM image, shared by every cartridge loaded
+  // from the same CHR bytes (so many environments running one game decode it
+  // once). The returned cache is never written.
+  static std::shared_ptr<const ChrCache> shared(const std::vector<u8>& chr);
+
+  // 8 pixels of the pattern row whose low-plane byte is at CHR `offset`
+  // (left to right, or right to left when `flip`), or nullptr if the row is
+  // outside the CHR image.
+  const u8* row(u32 offset, bool flip) const {
+    const u32 tile = offset >> 4;
+    if (tile >= _tiles) return nullptr;
+    return &_pixels[(((tile << 1) | (flip ? 1u : 0u)) << 6) | ((offset & 7u) << 3)];
+  }
+
+  // Re-decode the row holding CHR byte `offset` after a CHR-RAM write.
+  void update(const std::vector<u8>& chr, u32 offset);
+
+  u32 tiles() const { return _tiles; }
+
+ private:
+  void decode_row(const std::vector<u8>& chr, u32 tile, u32 row);
+
+  u32 _tiles = 0;
+  std::vector<u8> _pixels;  // [tile][flip][row][col]
+  std::vector<u8> _source;  // CHR-ROM bytes, to match shared() lookups
+};
+
+}  // namespace nes
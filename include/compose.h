@@ -0,0 +1,46 @@
+#pragma once
+#include "types.h"
+
+namespace nes {
+
+// Final pixel composition for one 256-pixel scanline. The PPU resolves the
+// background and sprite passes into palette-RAM indices, and a kernel merges
+// them in bulk:
+//   bg        background index, 0 where the background is transparent
+//             (pixel value 0, left-8px mask, or background disabled)
+//   spr_any   index of the lowest-OAM opaque sprite pixel, 0 if none; bit 7
+//             set where that pixel is sprite 0 (and x != 255)
+//   spr_front the same, counting only sprites in front of the background
+// Opaque background shows spr_front if any, else itself; transparent
+// background shows spr_any if any, else the backdrop (index 0). Each index is
+// mapped through `colors` (32 NES colour indices, one per palette-RAM byte)
+// into `out`. Returns true on a sprite-0 hit: a bit-7 pixel over opaque
+// background.
+using ComposeFn = bool (*)(const u8* bg, const u8* spr_any, const u8* spr_front,
+                           const u8* colors, u8* out);
+
+// Expand `count` colour indices through a u32 table (one entry per index
+// value that can occur) -- the deferred RGBA/BGRA pass of the framebuffer.
+using ExpandFn = void (*)(const u8* indices, int count, const u32* table, u32* out);
+
+// Portable reference kernels.
+bool compose_line_scalar(const u8* bg, const u8* spr_any, const u8* spr_front,
+                         const u8* colors, u8* out);
+void expand_pixels_scalar(const u8* indices, int count, const u32* table, u32* out);
+
+// The fastest kernels this CPU supports (AVX2, SSE2 or WASM SIMD128, else
+// the scalar ones), picked once at startup.
+bool compose_line(const u8* bg, const u8* spr_any, const u8* spr_front,
+                  const u8* colors, u8* out);
+void expand_pixels(const u8* indices, int count, const u32* table, u32* out);
+const char* compose_kernel_name();
+
+// Every kernel set usable on this CPU, scalar first (for cross-checking).
+struct ComposeKernel {
+  const char* name;
+  ComposeFn fn;
+  ExpandFn expand;
+};
+int compose_kernels(ComposeKernel* out, int max);
+
+}  // namespace nes
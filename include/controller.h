@@ -1,4 +1,5 @@
 #pragma once
+#include "state_io.h"
 #include "types.h"
 
 namespace nes {
@@ -37,6 +38,12 @@ class Controller {
     _strobe = 0;
   }
 
+  void io_state(StateIO& s) {
+    s.field(_state);
+    s.field(_shift);
+    s.field(_strobe);
+  }
+
  private:
   u8 _state = 0;
   u8 _shift = 0;
@@ -1,8 +1,19 @@
 #pragma once
 #include <array>
 #include <cstddef>
+#include "state_io.h"
 #include "types.h"
 
+// Interpreter core used by CPU::clock(). 1 (default) selects the switch-
+// dispatched core; 0 falls back to the pointer-to-member _instruction_table.
+// CMake sets this from the NES_CPU_SWITCH_DISPATCH option.
+#ifndef NES_CPU_SWITCH_DISPATCH
+#define NES_CPU_SWITCH_DISPATCH 1
+#endif
+
+// Forward-declare the cross-check fixture (see friend declaration below).
+class CPUTestDispatch;
+
 namespace nes {
 class Bus;
 class CPU {
@@ -43,6 +54,12 @@ class CPU {
   static constexpr size_t INSTRUCTION_TABLE_SIZE = 256;
   std::array<Instruction, INSTRUCTION_TABLE_SIZE> _instruction_table;
 
+  // Decode + execute instructions and set _cycles. Both cores are always
+  // compiled so tests can cross-check them; clock() and run() pick one at
+  // build time. execute_switch() runs until cycle_budget cycles are used.
+  void execute_table();
+  int execute_switch(int cycle_budget);
+
   // Flag operations
   void update_zero_and_negative_flags(const u8 value);
 
@@ -164,6 +181,16 @@ class CPU {
   // Core methods
   void clock();
   void reset();
+  void io_state(StateIO& s);  // registers and the cycles still owed
+  // Instruction-granular execution: run whole instructions back to back until
+  // at least cycle_budget cycles are consumed and return the cycles used (the
+  // last instruction may overshoot). Cycles still owed by a part-clocked
+  // instruction or an interrupt entry are counted first. Interrupts are not
+  // polled; the caller advances the other chips by the result and delivers
+  // NMI/IRQ between calls.
+  int run(int cycle_budget);
+  int step_instruction();  // run(1): finish the current instruction or execute the next
+  void skip_cycles(u8 cycles);  // let idle cycles elapse in bulk (<= get_remaining_cycles())
   void trigger_nmi();  // Non-maskable interrupt entry: push PC+status, jump to $FFFA/$FFFB.
   bool trigger_irq();  // Maskable interrupt via $FFFE/$FFFF. Returns false (no-op) if I set.
 
@@ -187,6 +214,8 @@ class CPU {
   // Memory access methods
   u8 read_byte(u16 address);
   void write_byte(const u16 address, const u8 value);
+
+  friend class ::CPUTestDispatch;
 };
 
 }  // namespace nes
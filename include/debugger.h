@@ -70,6 +70,9 @@ class Debugger {
   // Statistics
   u64 get_instruction_count() const;
   u64 get_cycle_count() const;
+  // Scanlines the PPU left as they were (inputs unchanged) vs. redrew.
+  u64 get_lines_reused() const;
+  u64 get_lines_drawn() const;
 
   // Disassembly methods
   DisassembledInstruction disassemble_instruction(u16 address) const;
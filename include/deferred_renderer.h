@@ -0,0 +1,88 @@
+#pragma once
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "scanline.h"
+#include "types.h"
+
+namespace nes {
+
+// Draws whole frames after the fact. While the PPU runs a frame it hands over
+// each visible line's ScanlineState (with the side effects -- sprite
+// overflow, the sprite-0 hit pre-pass, scrolling -- already applied); the
+// renderer repoints it at copies of whatever memory it reads, taking a new
+// copy only when the PPU reports that memory changed. After line 239 the
+// frame is rasterized on worker threads, split by lines, while emulation
+// carries on into vblank and the next frame; collect() waits for it.
+class DeferredRenderer {
+ public:
+  // Change counters for the memory a line reads; a new copy is taken when
+  // one differs from the last line's.
+  struct Versions {
+    u32 vram = 0;  // nametables + palette
+    u32 oam = 0;
+    u32 chr = 0;   // CHR-RAM
+  };
+
+  explicit DeferredRenderer(u32 threads);
+  ~DeferredRenderer();
+  DeferredRenderer(const DeferredRenderer&) = delete;
+  DeferredRenderer& operator=(const DeferredRenderer&) = delete;
+
+  u32 threads() const { return _threads; }
+
+  // Record `line` of the current frame. Line 0 starts a new frame; lines of
+  // a frame whose start was missed are refused (false) and must be drawn
+  // directly. `chr_ram`: s.chr.bytes is writable CHR and must be copied.
+  bool record(u16 line, const ScanlineState& s, const Versions& versions, bool chr_ram);
+  // After line 239 was recorded: start drawing the frame. A frame still in
+  // flight is finished first (and superseded).
+  void submit();
+  // Wait for the submitted frame and copy its 256*240 colour indices to
+  // `out`. Returns false, leaving `out` alone, if nothing was submitted
+  // since the last collect().
+  bool collect(u8* out);
+  // Drop the frame being recorded (the machine it describes was replaced);
+  // record() refuses lines until the next line 0.
+  void cancel();
+
+ private:
+  struct Frame {
+    std::array<ScanlineState, 240> lines;
+    // Copies the lines point into. Slots are reused frame to frame; deque
+    // keeps them in place as it grows.
+    std::deque<std::array<u8, 4 * 1024 + 32>> vram;  // 4 nametable pages + palette
+    std::deque<std::array<u8, 256>> oam;
+    std::deque<std::vector<u8>> chr;
+    size_t vram_used = 0, oam_used = 0, chr_used = 0;
+  };
+
+  void rasterize(const Frame& frame, u32 part);  // lines of worker `part`
+  void worker(u32 part);
+  void wait();
+
+  u32 _threads;
+  Frame _frames[2];  // recording, and the one being drawn
+  Frame* _recording = &_frames[0];
+  Frame* _drawing = &_frames[1];
+  bool _open = false;     // line 0 of the current frame was recorded
+  bool _pending = false;  // a submitted frame hasn't been collected
+  Versions _seen;
+  const u8* _seen_pages[5] = {};  // nametables, then palette
+  const u8* _seen_oam = nullptr;
+  const u8* _seen_chr = nullptr;
+  std::array<u8, 256 * 240> _pixels{};
+
+  std::vector<std::thread> _workers;
+  std::mutex _mutex;
+  std::condition_variable _wake;  // workers: a new frame (or stop)
+  std::condition_variable _done;  // collect(): the last part finished
+  u64 _job = 0;
+  u32 _busy = 0;
+  bool _stop = false;
+};
+
+}  // namespace nes
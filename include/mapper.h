@@ -1,28 +1,76 @@
 #pragma once
+#include <memory>
+#include "state_io.h"
 #include "types.h"
 
 namespace nes {
 
 // Address-translation + bank-switching interface implemented per cartridge
-// board. Reads return a flat offset into the cartridge's PRG/CHR memory; writes
-// to $8000-$FFFF are usually mapper-register writes that update bank state and
-// return false (no PRG-ROM byte is written).
+// board. Each board keeps bank offset tables -- one PRG entry per 8KB window
+// of $8000-$FFFF and one CHR entry per 1KB window of $0000-$1FFF -- and
+// refreshes them only when a register write changes bank state, so
+// translating an address is a shift, an index and an add with no virtual
+// call. Writes to $8000-$FFFF are usually mapper-register writes that update
+// bank state and return false (no PRG-ROM byte is written).
 class Mapper {
+ public:
+  // Concrete board behind this interface. The supported boards are `final`, so
+  // hot paths can switch on this and call them directly (see visit_board in
+  // cartridge.cpp); OTHER falls back to the virtual calls.
+  enum class Board : u8 { OTHER, NROM, MMC1, UXROM, CNROM, MMC3 };
+  Board board() const { return _board; }
+
  protected:
+  Board _board = Board::OTHER;
   u8 _prg_banks = 0;  // 16KB PRG-ROM banks
   u8 _chr_banks = 0;  // 8KB CHR-ROM banks (0 => CHR-RAM)
 
+  u32 _prg_map[4] = {};  // PRG offset of $8000/$A000/$C000/$E000
+  u32 _chr_map[8] = {};  // CHR offset of each 1KB window
+
+  // Table fill helpers; `slot` counts windows of the given size.
+  void map_prg_8k(int slot, u32 offset) { _prg_map[slot] = offset; }
+  void map_prg_16k(int slot, u32 offset) {
+    map_prg_8k(slot * 2, offset);
+    map_prg_8k(slot * 2 + 1, offset + 0x2000);
+  }
+  void map_prg_32k(u32 offset) {
+    map_prg_16k(0, offset);
+    map_prg_16k(1, offset + 0x4000);
+  }
+  void map_chr_1k(int slot, u32 offset) { _chr_map[slot] = offset; }
+  void map_chr_4k(int slot, u32 offset) {
+    for (int i = 0; i < 4; i++) map_chr_1k(slot * 4 + i, offset + i * 0x0400u);
+  }
+  void map_chr_8k(u32 offset) {
+    map_chr_4k(0, offset);
+    map_chr_4k(1, offset + 0x1000);
+  }
+
  public:
   Mapper(u8 prg_banks, u8 chr_banks);
   virtual ~Mapper() = default;
 
+  // PRG-ROM offset of a CPU address in $8000-$FFFF / CHR offset of a PPU
+  // address in $0000-$1FFF. Callers range-check the address and the result.
+  u32 prg_offset(u16 address) const { return _prg_map[(address >> 13) & 0x03] + (address & 0x1FFF); }
+  u32 chr_offset(u16 address) const { return _chr_map[(address >> 10) & 0x07] + (address & 0x03FF); }
+
   // Map a CPU address to a PRG-ROM offset. Returns false if not handled.
-  virtual bool cpu_read(u16 address, u32& mapped) const = 0;
+  bool cpu_read(u16 address, u32& mapped) const {
+    if (address < 0x8000) return false;
+    mapped = prg_offset(address);
+    return true;
+  }
   // Handle a CPU write. Register writes update bank state and return false;
   // returns true (+offset) only when the write targets writable PRG-ROM.
   virtual bool cpu_write(u16 address, u8 value, u32& mapped) = 0;
   // Map a PPU address ($0000-$1FFF) to a CHR offset.
-  virtual bool ppu_read(u16 address, u32& mapped) const = 0;
+  bool ppu_read(u16 address, u32& mapped) const {
+    if (address > 0x1FFF) return false;
+    mapped = chr_offset(address);
+    return true;
+  }
   virtual bool ppu_write(u16 address, u32& mapped) = 0;
 
   // Dynamic nametable mirroring: -1 = use the iNES header value; otherwise
@@ -33,6 +81,15 @@ class Mapper {
   virtual void scanline() {}  // pulse once per rendered scanline
   virtual bool irq_pending() const { return false; }
   virtual void irq_clear() {}
+  // Scanline pulses until the one that raises the IRQ (1 = the next pulse),
+  // or 0 if none can while the registers stay as they are.
+  virtual int scanlines_until_irq() const { return 0; }
+
+  // Bank tables, plus each board's registers (boards extend this).
+  virtual void io_state(StateIO& s);
+
+  // An independent copy of this board, registers and all.
+  virtual std::shared_ptr<Mapper> clone() const = 0;
 };
 
 }  // namespace nes
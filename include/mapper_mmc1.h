@@ -6,18 +6,24 @@ namespace nes {
 // MMC1 (mapper 1): a 5-bit serial shift register loads one of four internal
 // registers (control, CHR bank 0/1, PRG bank). Supports switchable 16/32KB PRG,
 // 4/8KB CHR, and software-controlled mirroring.
-class MapperMMC1 : public Mapper {
+class MapperMMC1 final : public Mapper {
  public:
   MapperMMC1(u8 prg_banks, u8 chr_banks);
   ~MapperMMC1() override = default;
 
-  bool cpu_read(u16 address, u32& mapped) const override;
   bool cpu_write(u16 address, u8 value, u32& mapped) override;
-  bool ppu_read(u16 address, u32& mapped) const override;
   bool ppu_write(u16 address, u32& mapped) override;
-  int mirror() const override;
+  void io_state(StateIO& s) override;
+  std::shared_ptr<Mapper> clone() const override { return std::make_shared<MapperMMC1>(*this); }
+  int mirror() const override {
+    // Control bits 0-1: 0 single-lo, 1 single-hi, 2 vertical, 3 horizontal.
+    static constexpr int MODES[4] = {2 /*single lo*/, 3 /*single hi*/, 1 /*vertical*/, 0 /*horizontal*/};
+    return MODES[_control & 0x03];
+  }
 
  private:
+  void update_banks();  // recompute the PRG/CHR tables from the registers
+
   u8 _shift = 0x10;   // serial load register (bit4 marks 5th write)
   u8 _control = 0x0C; // power-on: PRG mode 3 (fix last bank at $C000)
   u8 _chr0 = 0;
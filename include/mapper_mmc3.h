@@ -6,23 +6,33 @@ namespace nes {
 // MMC3 (mapper 4): eight bank registers driving 8KB PRG and 1/2KB CHR windows,
 // software mirroring, and a scanline IRQ counter clocked once per rendered
 // line. PRG window modes and CHR A12 inversion are selectable.
-class MapperMMC3 : public Mapper {
+class MapperMMC3 final : public Mapper {
  public:
   MapperMMC3(u8 prg_banks, u8 chr_banks);
   ~MapperMMC3() override = default;
 
-  bool cpu_read(u16 address, u32& mapped) const override;
   bool cpu_write(u16 address, u8 value, u32& mapped) override;
-  bool ppu_read(u16 address, u32& mapped) const override;
   bool ppu_write(u16 address, u32& mapped) override;
-  int mirror() const override;
+  void io_state(StateIO& s) override;
+  std::shared_ptr<Mapper> clone() const override { return std::make_shared<MapperMMC3>(*this); }
+  // Defined inline so the Cartridge's static board dispatch can inline them.
+  int mirror() const override { return _mirror == 0 ? 1 /*vertical*/ : 0 /*horizontal*/; }
 
-  void scanline() override;
-  bool irq_pending() const override;
-  void irq_clear() override;
+  void scanline() override {
+    if (_irq_counter == 0 || _irq_reload) {
+      _irq_counter = _irq_latch;
+      _irq_reload = false;
+    } else {
+      _irq_counter--;
+    }
+    if (_irq_counter == 0 && _irq_enabled) _irq_pending = true;
+  }
+  bool irq_pending() const override { return _irq_pending; }
+  void irq_clear() override { _irq_pending = false; }
+  int scanlines_until_irq() const override;
 
  private:
-  u32 chr_bank_1k(int region) const;  // resolve a 1KB CHR region (0..7)
+  void update_banks();  // recompute the PRG/CHR tables from R0-R7 + modes
 
   u8 _bank_select = 0;  // $8000: target reg + PRG/CHR modes
   u8 _regs[8] = {0};    // R0..R7
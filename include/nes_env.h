@@ -1,8 +1,8 @@
 // nes_env.h - a small, stable C ABI over the emulator core.
 //
-// One opaque NesEnv handle is one independent NES. Handles share no global state,
-// so you can run many of them in parallel (one per thread or process) for RL
-// throughput. The ABI is plain C so it loads cleanly from Python via ctypes, or
+// One opaque NesEnv handle is one independent NES. Handles share no mutable
+// state (only the read-only decoded CHR-ROM tiles of a common game), so you can
+// run many of them in parallel (one per thread or process) for RL throughput. The ABI is plain C so it loads cleanly from Python via ctypes, or
 // from any other language. No C++ exception is allowed to cross the boundary.
 //
 // Button bit layout matches the controller hardware:
@@ -34,7 +34,8 @@ NES_API void    nes_destroy(NesEnv* e);
 NES_API int nes_load(NesEnv* e, const uint8_t* rom, int len);
 
 // Power-on reboot of the loaded ROM. Fully deterministic: the same ROM always
-// resets to the same state.
+// resets to the same state. It restores a snapshot taken by nes_load (see
+// nes_save_state), so it is a memcpy, not a reload of the cartridge.
 NES_API void nes_reset(NesEnv* e);
 
 // Set player 1's buttons and advance exactly one video frame. Returns the frame
@@ -45,10 +46,91 @@ NES_API int nes_step(NesEnv* e, uint8_t p1_buttons);
 NES_API void nes_set_controller(NesEnv* e, int port, uint8_t buttons);
 
 // The current frame as 256*240 RGBA bytes. The pointer is valid until the next
-// step/reset. Use nes_framebuffer_size() for the length (245760).
+// step/reset. Use nes_framebuffer_size() for the length (245760). The core keeps
+// the frame as colour indices and converts it here, only when asked.
 NES_API const uint8_t* nes_framebuffer(NesEnv* e);
 NES_API int            nes_framebuffer_size(NesEnv* e);
 
+// The current frame as 256*240 NES colour indices (0..63; 64 where nothing has
+// been drawn since reset). No conversion; valid until the next step/reset.
+NES_API const uint8_t* nes_framebuffer_indices(NesEnv* e);
+
+// Convert the current frame into `out` as NES_FORMAT_RGBA/BGRA (4 bytes per
+// pixel) or NES_FORMAT_RGB24 (3). Returns the number of bytes written, or 0 for
+// an unknown format.
+#define NES_FORMAT_RGBA  0
+#define NES_FORMAT_BGRA  1
+#define NES_FORMAT_RGB24 2
+NES_API int nes_framebuffer_convert(NesEnv* e, int format, uint8_t* out);
+
+// Choose which frames are drawn: 1 = every frame (default), 0 = none (RAM-only
+// agents), N = only frames after which nes_frame_count() is a multiple of N.
+// Skipped frames leave the framebuffer as it was, but everything the game can
+// observe (sprite-0 hit, sprite overflow, scanline IRQs) still happens, so the
+// emulation is identical at any setting. Kept across nes_load/nes_reset.
+NES_API void nes_set_render_interval(NesEnv* e, int every_n);
+
+// Draw frames on `threads` worker threads after the PPU finishes them, in the
+// background while the next frame is emulated; 0 (default) draws scanlines as
+// they happen. The output is identical; framebuffer reads wait for a frame
+// still being drawn. Kept across nes_load/nes_reset.
+NES_API void nes_set_render_threads(NesEnv* e, int threads);
+
+// Snapshots of the whole machine (CPU, RAM, PPU, APU channels, mapper
+// registers, PRG-RAM and CHR-RAM) as a flat binary blob, for search-based
+// agents that branch from a state many times. nes_state_size() is fixed for a
+// loaded ROM (0 with none). nes_save_state() writes that many bytes into buf;
+// nes_load_state() restores them, after which stepping reproduces exactly what
+// followed the save. A snapshot loads only into an env running the same
+// kind of cartridge (board and bank counts); the ROM bytes themselves are not
+// in it. Both return 0 on success, 1 if buf/len don't fit or the snapshot is
+// not from a compatible cartridge (the machine is then left untouched).
+NES_API int nes_state_size(NesEnv* e);
+NES_API int nes_save_state(NesEnv* e, uint8_t* buf, int len);
+NES_API int nes_load_state(NesEnv* e, const uint8_t* buf, int len);
+
+// Forking, for tree search. nes_clone() returns a new handle in exactly the
+// state of src (NULL if src has no ROM or on failure); stepping both with the
+// same inputs gives the same frames. nes_copy_into() makes an existing dst a
+// copy of src, switching dst to src's ROM if it runs another one, and returns
+// 0 on success. Only the machine state (the nes_state_size() bytes) is
+// copied; ROM, decoded tiles and the power-on snapshot are shared. A clone
+// takes src's render interval but draws inline (see nes_set_render_threads).
+// Reusing a pool of handles with nes_copy_into avoids the allocation.
+NES_API NesEnv* nes_clone(NesEnv* src);
+NES_API int nes_copy_into(NesEnv* dst, NesEnv* src);
+
+// Rewind. nes_rewind_enable() starts keeping a history of the last frames in
+// a ring of budget_bytes, which it never grows past (0 turns rewind off and
+// frees it): from then on every nes_step records the frame, as a delta against
+// the frame before and in full every keyframe_interval frames. A frame costs a
+// few hundred bytes to a few KB, so a few MB hold a minute or so. nes_rewind()
+// goes back `frames` recorded frames (60 per second of play; clamped to the
+// oldest one held), drops the newer ones and returns how many frames it went
+// back, or -1 with no history. nes_rewind_depth() is the number of frames
+// held, the current one included. nes_load and nes_copy_into clear the
+// history.
+NES_API int nes_rewind_enable(NesEnv* e, int budget_bytes, int keyframe_interval);
+NES_API int nes_rewind(NesEnv* e, int frames);
+NES_API int nes_rewind_depth(NesEnv* e);
+
+// Audio, off by default: agents rarely listen, and nothing is synthesized
+// until nes_set_audio_output() turns it on at sample_rate (8000-96000, e.g.
+// 44100 or the device's 48000) with a queue of `capacity` samples; a
+// sample_rate of 0 turns it off again. Returns 0, or 1 for bad arguments. It
+// starts an empty queue, so call it before anyone drains; clones start with
+// audio off. Each step then queues that frame's mono float samples and
+// nes_audio_drain() copies up to max of them into out, returning the count.
+// The drain and the counters touch only the queue, so one other thread (an
+// audio callback) may call them while this handle steps. A host steers its
+// resampling from the fill level and the counters.
+NES_API int nes_set_audio_output(NesEnv* e, int sample_rate, int capacity);
+NES_API int nes_audio_drain(NesEnv* e, float* out, int max);
+NES_API int nes_audio_available(NesEnv* e);        // queued samples
+NES_API int nes_audio_capacity(NesEnv* e);         // queue size in samples
+NES_API uint64_t nes_audio_overruns(NesEnv* e);    // samples dropped, queue full
+NES_API uint64_t nes_audio_underruns(NesEnv* e);   // drains that found it empty
+
 // Copy the 2 KB of CPU work RAM ($0000-$07FF) into out (must hold 2048 bytes).
 NES_API void nes_get_ram(NesEnv* e, uint8_t* out_2048);
 
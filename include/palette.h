@@ -11,4 +11,20 @@ extern const u32 NES_PALETTE[64];
 // Returns the RGBA color for a 6-bit NES color index (index masked to 0..63).
 u32 palette_rgba(u8 index);
 
+// Index the PPU leaves in pixels it has not drawn since reset; it converts to
+// all-zero bytes in every format.
+constexpr u8 BLANK_PIXEL = 0x40;
+
+// Host pixel layouts the indexed framebuffer converts to.
+enum class PixelFormat : u8 { RGBA, BGRA, RGB24 };
+constexpr int pixel_format_bytes(PixelFormat f) { return f == PixelFormat::RGB24 ? 3 : 4; }
+
+// 256-entry u32 lookup (one per index byte; BLANK_PIXEL and up are zero) for
+// the 4-byte formats, suitable for expand_pixels() in compose.h.
+const u32* pixel_table(PixelFormat format);
+
+// Convert `count` NES colour indices (0..63 or BLANK_PIXEL) to `format`,
+// writing count * pixel_format_bytes(format) bytes to `out`.
+void convert_pixels(const u8* indices, int count, PixelFormat format, u8* out);
+
 }  // namespace nes
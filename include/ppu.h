@@ -1,7 +1,10 @@
 #pragma once
 #include <array>
 #include <memory>
+#include <vector>
 #include "cartridge.h"
+#include "scanline.h"
+#include "state_io.h"
 #include "types.h"
 
 // Forward-declare the test fixture so that `friend class ::PPUTestLoopy;`
@@ -10,14 +13,23 @@
 class PPUTestLoopy;
 
 namespace nes {
+class DeferredRenderer;
+
 class PPU {
  public:
   PPU();
-  ~PPU() = default;
+  ~PPU();
+  PPU(PPU&&) noexcept;
+  PPU& operator=(PPU&&) noexcept;
 
  public:
   void insert_cartridge(const std::shared_ptr<Cartridge>& c);
   void reset();
+  // Registers, memories, beam position and the frame drawn so far; loading
+  // drops every cache built from the old contents, except the reuse keys of
+  // lines it leaves unchanged. Cartridge mirroring is not included: call
+  // update_mirroring() once the cartridge is loaded too.
+  void io_state(StateIO& s);
 
   u8 cpu_read(u16 reg) const;  // reg already masked to 0..7 by the Bus
   void cpu_write(u16 reg, u8 value);
@@ -25,11 +37,26 @@ class PPU {
   void ppu_write(u16 addr, u8 value);
 
   void clock();        // advance ONE dot
+  // Same as `dots` clock() calls, but jumps straight between the dots where
+  // the current scanline does something (render, scroll, flags, mapper pulse).
+  void run(u32 dots);
   bool take_nmi();     // returns _nmi_pending and clears it
+  // Dots until the clock() that raises NMI / delivers the n-th mapper scanline
+  // pulse / starts a new frame (1 = the very next dot; 0 = NMI disabled or no
+  // pulses while rendering is off). Only register writes can move these, so
+  // the Bus schedules its deadlines from them and lets the PPU lag until then.
+  u32 dots_until_nmi() const;
+  u32 dots_until_scanline_pulse(u32 n) const;
+  u32 dots_until_frame_end() const;
 
   u32 frame_count() const;
   u16 scanline() const;
   u16 dot() const;
+  // The frame as 256*240 NES colour indices (BLANK_PIXEL where nothing has
+  // been drawn since reset). framebuffer() converts it to RGBA on demand.
+  // With render threads, this is the last frame whose drawing finished
+  // (waiting for it if need be).
+  const u8* pixels() const;
   const u32* framebuffer() const;  // 256*240 RGBA
 
   u8 reg_status() const;
@@ -37,8 +64,33 @@ class PPU {
   u8 reg_mask() const;
   u16 vram_addr() const;
 
+  // Which frames get drawn: 1 = every frame (the default), 0 = none, N = only
+  // those that end with frame_count() a multiple of N. Undrawn frames leave
+  // pixels() as it was but keep every effect the CPU can see -- sprite-0 hit,
+  // sprite overflow, scrolling and mapper scanline pulses -- so emulation is
+  // identical either way. Survives reset().
+  void set_render_interval(u32 every_n);
+  u32 render_interval() const { return _render_interval; }
+
+  // 0 (the default) draws each visible line when the PPU reaches it. N > 0
+  // only records what each line needs and draws the whole frame on N worker
+  // threads after line 239, while emulation carries on (see
+  // DeferredRenderer); the sprite-0 hit comes from a hit-only pre-pass, so
+  // the CPU sees the same flags either way. Survives reset().
+  void set_render_threads(u32 threads);
+
+  // Lines drawn inline are memoized: a line whose inputs (scanline_key) match
+  // the last time it was drawn is left as it is. Counts since reset().
+  u64 lines_reused() const;
+  u64 lines_drawn() const;
+
+  // Re-read the cartridge's mirroring into the nametable page map. The Bus
+  // calls this after every mapper register write; code that writes mapper
+  // registers on the cartridge directly must call it too.
+  void update_mirroring();
+
   void render_pattern_table(int table, int palette, u32* out) const;  // out = 128*128 RGBA
-  const u8* nametable_ram() const;  // 2048 bytes (&_name[0][0])
+  const u8* nametable_ram() const;  // 2048 bytes (&_name[0][0]); 4096 with four-screen
   const u8* palette_ram() const;    // 32 bytes
 
   // Object Attribute Memory (sprites). oam_write() advances OAMADDR (used by
@@ -50,8 +102,17 @@ class PPU {
 
  private:
   u16 nt_index(u16 addr, u16& offset) const;  // returns table; sets offset
+  u32 dots_until(u32 frame_pos) const;        // 1..one frame, to scanline*341+dot
   void render_scanline(u16 line);
-  void render_sprites(u16 line, const u8* bg_pix);  // overlay sprites onto line
+  // What drawing `line` reads, from the live registers and memory; evaluates
+  // the line's sprites (setting overflow).
+  void capture_line(u16 line, ScanlineState& s);
+  int evaluate_sprites(u16 line, u8* found);  // up to 8 OAM indices; sets overflow
+  void index_sprites(u8 sprite_height);       // rebuild _line_sprites from OAM
+  void collect_frame() const;  // take a finished deferred frame into _pixels
+  // 8 pixel values (0..3) of the pattern row at `addr`: the cartridge's
+  // decoded tile cache when it has one, else decoded into `scratch`.
+  const u8* pattern_row(u16 addr, bool flip, u8* scratch) const;
 
   // loopy scroll helpers
   void inc_coarse_x();
@@ -62,7 +123,8 @@ class PPU {
  private:
   std::shared_ptr<Cartridge> _cartridge;
 
-  u8 _name[2][1024];  // nametable VRAM
+  u8 _name[4][1024];  // nametable VRAM; pages 2-3 are a four-screen board's
+  u8 _nt_map[4] = {0, 0, 1, 1};  // _name page behind $2000/$2400/$2800/$2C00
   u8 _palette[32];    // palette RAM
 
   u8 _ctrl = 0;
@@ -70,6 +132,11 @@ class PPU {
   mutable u8 _status = 0;
   u8 _oam_addr = 0;
   u8 _oam[256] = {};  // 64 sprites x 4 bytes (Y, tile, attr, X)
+  // Per visible line, the first 9 sprites that cover it (OAM order), built
+  // for sprites of _sprite_index_height rows; 0 = OAM changed since.
+  u8 _line_sprites[240][9] = {};
+  u8 _line_sprite_count[240] = {};
+  u8 _sprite_index_height = 0;
   mutable u8 _data_buffer = 0;
 
   mutable u16 _v = 0;  // current VRAM address (15 bit)
@@ -81,8 +148,22 @@ class PPU {
   u16 _dot = 0;
   u32 _frame = 0;
   bool _nmi_pending = false;
-
-  std::array<u32, 256 * 240> _framebuffer{};
+  u32 _render_interval = 1;
+  std::unique_ptr<DeferredRenderer> _deferred;  // null: draw lines inline
+  // Bumped on every write, so recorded frames know when to copy memory again.
+  u32 _vram_version = 0;  // nametables + palette
+  u32 _oam_version = 0;
+  u32 _chr_version = 0;
+  // What each line of _pixels was last drawn from (length 0: unknown).
+  std::array<std::array<u8, SCANLINE_KEY_BYTES>, 240> _line_keys{};
+  mutable std::array<u8, 240> _line_key_size{};
+  std::array<bool, 240> _line_hit{};  // the sprite-0 hit that drawing found
+  u64 _lines_reused = 0;
+  u64 _lines_drawn = 0;
+
+  mutable std::array<u8, 256 * 240> _pixels{};
+  mutable std::vector<u32> _framebuffer;  // RGBA copy of _pixels, allocated on first use
+  mutable bool _framebuffer_stale = true;
 
   friend class ::PPUTestLoopy;
 };
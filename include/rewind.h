@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+#include <vector>
+#include "types.h"
+
+namespace nes {
+
+class Bus;
+
+// Rewind history: one machine snapshot per push(), kept as XOR/RLE deltas in
+// a ring of fixed size, so the memory used never grows past the budget and
+// the oldest frames fall off the end.
+//
+// Every keyframe_interval pushes (or when a delta would have to evict its
+// own keyframe) the snapshot is stored whole, run-length coded; the pushes in
+// between store only what changed since the previous push. Changes are found
+// a 256-byte page at a time -- unchanged pages (most of RAM, the nametables,
+// CHR-RAM and the framebuffer of a still screen) are skipped with one memcmp
+// -- and the changed pages are coded as runs of XOR bytes. A frame is
+// restored by decoding its keyframe and applying the deltas after it, so
+// evicting a keyframe evicts the deltas that depend on it.
+class Rewind {
+ public:
+  explicit Rewind(size_t budget_bytes = 8 << 20, u32 keyframe_interval = 60);
+
+  // Record the machine as it is now (call once per frame). Returns false if
+  // not even a keyframe fits in the budget; the history is then empty.
+  bool push(Bus& bus);
+
+  // Restore the state recorded `frames` pushes before the newest (0 = the
+  // newest), clamped to the oldest one held, and forget the newer ones so
+  // play continues from there. Returns how many frames it went back, or -1 if
+  // there is no history.
+  int rewind(Bus& bus, u32 frames);
+
+  u32 depth() const { return static_cast<u32>(_entries.size()); }  // frames held
+  size_t used() const;                                             // bytes of the ring in use
+  size_t budget() const { return _ring.size(); }
+  void clear();
+
+ private:
+  struct Entry {
+    size_t offset;  // in _ring
+    size_t size;
+    bool key;  // coded against zeros rather than the previous push
+  };
+
+  bool place(bool key);
+  void evict_front();
+
+  std::vector<u8> _ring;
+  u32 _interval;
+  std::deque<Entry> _entries;  // oldest first; the front is always a keyframe
+  size_t _tail = 0;            // where the next record goes
+  u32 _since_key = 0;          // deltas after the newest keyframe
+  std::vector<u8> _prev;       // the newest pushed state, decoded
+  std::vector<u8> _cur;        // scratch: the state being pushed
+  std::vector<u8> _code;       // scratch: its coded record
+};
+
+}  // namespace nes
@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include "types.h"
+
+namespace nes {
+
+class Bus;
+
+// Run-ahead hides the frames of lag between a button press and the picture
+// that most games have built in (they read the pad during one frame and draw
+// the result in a later one). After each real frame, run() saves the
+// machine, emulates frames() more with the same input -- drawing only the
+// last and making no sound -- keeps that last picture to show, then restores
+// the machine to the real frame. What the game computes is untouched; only
+// the picture is frames() frames ahead of it.
+class RunAhead {
+ public:
+  void set_frames(u32 frames);
+  u32 frames() const { return _frames; }
+
+  // Call after each real frame. No-op (and nothing to show) with frames() 0.
+  void run(Bus& bus);
+
+  // The picture from the last run(), 256*240 RGBA, until discard() -- call
+  // that when the machine changes some other way (loads, rewinds, steps).
+  bool shown() const { return _shown; }
+  const u32* framebuffer() const { return _frame.data(); }
+  void discard() { _shown = false; }
+
+ private:
+  u32 _frames = 0;
+  bool _shown = false;
+  std::vector<u8> _state;  // the real frame, restored after the speculative ones
+  std::vector<u32> _frame;
+};
+
+}  // namespace nes
@@ -0,0 +1,55 @@
+#pragma once
+#include "chr_cache.h"
+#include "types.h"
+
+namespace nes {
+
+// Where a line's pattern rows come from: the cartridge's decoded tile cache
+// when it has one, else the raw CHR bytes, through the mapper's 1KB CHR bank
+// offsets as they were when the line was captured.
+struct ChrView {
+  const ChrCache* cache = nullptr;
+  const u8* bytes = nullptr;  // nullptr: no cartridge, every row is blank
+  u32 size = 0;
+  u32 map[8] = {};  // Mapper::chr_offset() of each 1KB window
+
+  // 8 pixel values (0..3) of the pattern row at `addr` ($0000-$1FFF); see
+  // ChrCache::row. Decodes into `scratch` when there is no cache.
+  const u8* row(u16 addr, bool flip, u8* scratch) const;
+};
+
+// Everything drawing one visible scanline reads. The PPU captures one from
+// its live state at dot 256; a DeferredRenderer keeps one per line, pointing
+// at its own copies, to draw the frame later.
+struct ScanlineState {
+  u16 v = 0;  // loopy v before the line's coarse-X walk
+  u8 x = 0;   // fine X
+  u8 ctrl = 0;
+  u8 mask = 0;
+  u8 sprite_count = 0;
+  u8 sprites[8] = {};  // in-range OAM indices, in OAM order
+  const u8* nametables[4] = {};  // page behind $2000/$2400/$2800/$2C00
+  const u8* palette = nullptr;   // 32 bytes of palette RAM
+  const u8* oam = nullptr;       // 256 bytes
+  ChrView chr;
+};
+
+// Draw visible line `line` as 256 NES colour indices; returns true on a
+// sprite-0 hit.
+bool draw_scanline(const ScanlineState& s, u16 line, u8* out);
+
+// Upper bound on scanline_key()'s length.
+constexpr int SCANLINE_KEY_BYTES = 208;
+
+// Pack every input draw_scanline() reads for this line -- scroll, control
+// bits, the nametable and attribute bytes the background walk touches, the
+// palette, the line's sprites, and the CHR banks (plus `chr_version`, bumped
+// on CHR-RAM writes) -- into `key`; returns its length. Equal keys draw equal
+// lines.
+int scanline_key(const ScanlineState& s, u32 chr_version, u8* key);
+
+// Whether `line` has a sprite-0 hit, without drawing it: only sprite 0's
+// pixels are tested against the background under them.
+bool sprite_zero_hit(const ScanlineState& s, u16 line);
+
+}  // namespace nes
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include "types.h"
+
+namespace nes {
+
+// Timestamped deadlines for the Bus's catch-up loop: a tiny indexed min-heap
+// keyed by absolute CPU cycle, holding at most one pending entry per event
+// kind. Components post when their next interrupt-relevant moment will be
+// (re-posting moves it), and the Bus only stops to poll when the master
+// clock reaches next_deadline().
+class Scheduler {
+ public:
+  enum Event : u8 {
+    VBLANK_NMI,  // PPU raises NMI at (241, 1)
+    MAPPER_IRQ,  // scanline pulse that takes the MMC3 counter to 0
+    FRAME_END,   // PPU wraps to (0, 0); run_frame() watches the count
+    EVENT_COUNT
+  };
+  static constexpr u64 NEVER = UINT64_MAX;
+
+  Scheduler() { clear(); }
+
+  // Post `event` for the end of CPU cycle `cycle`, replacing any pending one.
+  void schedule(Event event, u64 cycle) {
+    if (_pos[event] == NONE) {
+      _pos[event] = _size;
+      _heap[_size++] = event;
+    }
+    _when[event] = cycle;
+    sift_up(_pos[event]);
+    sift_down(_pos[event]);
+  }
+
+  void cancel(Event event) {
+    const u8 pos = _pos[event];
+    if (pos == NONE) return;
+    _pos[event] = NONE;
+    if (pos == --_size) return;
+    const u8 moved = _heap[_size];  // refill the hole with the last entry
+    _heap[pos] = moved;
+    _pos[moved] = pos;
+    sift_up(pos);
+    sift_down(_pos[moved]);
+  }
+
+  void clear() {
+    for (u8& p : _pos) p = NONE;
+    _size = 0;
+  }
+
+  bool pending(Event event) const { return _pos[event] != NONE; }
+  u64 when(Event event) const { return pending(event) ? _when[event] : NEVER; }
+  u64 next_deadline() const { return _size ? _when[_heap[0]] : NEVER; }
+
+  // Remove the earliest event if it is due by `cycle`; returns false if not.
+  bool pop_due(u64 cycle, Event& event) {
+    if (_size == 0 || _when[_heap[0]] > cycle) return false;
+    event = static_cast<Event>(_heap[0]);
+    cancel(event);
+    return true;
+  }
+
+ private:
+  static constexpr u8 NONE = 0xFF;
+
+  bool earlier(u8 a, u8 b) const { return _when[_heap[a]] < _when[_heap[b]]; }
+  void swap(u8 a, u8 b) {
+    const u8 t = _heap[a];
+    _heap[a] = _heap[b];
+    _heap[b] = t;
+    _pos[_heap[a]] = a;
+    _pos[_heap[b]] = b;
+  }
+  void sift_up(u8 pos) {
+    while (pos > 0 && earlier(pos, (pos - 1) / 2)) {
+      swap(pos, (pos - 1) / 2);
+      pos = (pos - 1) / 2;
+    }
+  }
+  void sift_down(u8 pos) {
+    while (true) {
+      u8 min = pos;
+      const u8 l = 2 * pos + 1, r = 2 * pos + 2;
+      if (l < _size && earlier(l, min)) min = l;
+      if (r < _size && earlier(r, min)) min = r;
+      if (min == pos) return;
+      swap(pos, min);
+      pos = min;
+    }
+  }
+
+  u64 _when[EVENT_COUNT] = {};
+  u8 _heap[EVENT_COUNT] = {};  // event ids, heap-ordered by _when
+  u8 _pos[EVENT_COUNT];  // heap index per event, NONE if not pending
+  u8 _size = 0;
+};
+
+}  // namespace nes
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "types.h"
+
+namespace nes {
+
+// Walks a machine snapshot. Each component lists its state once, in order, in
+// an io_state(StateIO&) method; the same walk measures the snapshot (SIZE),
+// copies every field out (SAVE) or copies it back (LOAD). Fields are raw
+// bytes at fixed offsets -- no tags, no lengths -- so a snapshot is only
+// valid for a machine of the same layout (same cartridge board and RAM
+// sizes), which Bus::load_state checks before walking.
+class StateIO {
+ public:
+  enum class Mode { SIZE, SAVE, LOAD };
+
+  explicit StateIO(Mode mode, u8* data = nullptr) : _mode(mode), _data(data) {}
+
+  template <typename T>
+  void field(T& value) {
+    static_assert(std::is_trivially_copyable<T>::value, "snapshot fields are copied as raw bytes");
+    // No padding, whose bytes are unspecified: equal machines must give equal
+    // snapshots. List a struct's members one by one instead.
+    static_assert(std::has_unique_object_representations<T>::value, "snapshot fields must not contain padding");
+    bytes(&value, sizeof(T));
+  }
+
+  void bytes(void* data, size_t size) {
+    if (_mode == Mode::SAVE) {
+      std::memcpy(_data + _size, data, size);
+    } else if (_mode == Mode::LOAD) {
+      std::memcpy(data, _data + _size, size);
+    }
+    _size += size;
+  }
+
+  // LOAD: the next `size` bytes of the snapshot, for fields that want to
+  // compare before copying.
+  const u8* take(size_t size) {
+    const u8* at = _data + _size;
+    _size += size;
+    return at;
+  }
+
+  bool loading() const { return _mode == Mode::LOAD; }
+  size_t size() const { return _size; }
+
+ private:
+  Mode _mode;
+  u8* _data;
+  size_t _size = 0;
+};
+
+}  // namespace nes
@@ -26,12 +26,13 @@ from stable_baselines3.common.vec_env import DummyVecEnv, SubprocVecEnv
 from nesenv.gymnasium_env import SmbGymEnv
 
 
-def make_env(rom_path: str, frameskip: int):
-    """A picklable env factory (SB3 vectorises by calling these)."""
+def make_env(rom_path: str, frameskip: int, checkpoint_dir: Path):
+    """A picklable env factory (SB3 vectorises by calling these). The envs share
+    one on-disk boot checkpoint, so only the first of them emulates the boot."""
 
     def thunk():
         rom = open(rom_path, "rb").read()
-        return SmbGymEnv(rom, frameskip=frameskip, obs="ram")
+        return SmbGymEnv(rom, frameskip=frameskip, obs="ram", checkpoint_dir=str(checkpoint_dir))
 
     return thunk
 
@@ -86,7 +87,7 @@ def main() -> int:
     out = Path(args.out)
     out.mkdir(parents=True, exist_ok=True)
 
-    factories = [make_env(args.rom, args.frameskip) for _ in range(args.n_envs)]
+    factories = [make_env(args.rom, args.frameskip, out / "checkpoints") for _ in range(args.n_envs)]
     vec = SubprocVecEnv(factories) if args.subproc else DummyVecEnv(factories)
 
     model = PPO("MlpPolicy", vec, n_steps=512, batch_size=256, verbose=1)
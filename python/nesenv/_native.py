@@ -58,10 +58,44 @@ lib.nes_reset.argtypes = [ctypes.c_void_p]
 lib.nes_step.argtypes = [ctypes.c_void_p, ctypes.c_ubyte]
 lib.nes_step.restype = ctypes.c_int
 lib.nes_set_controller.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_ubyte]
+lib.nes_set_render_interval.argtypes = [ctypes.c_void_p, ctypes.c_int]
+lib.nes_set_render_threads.argtypes = [ctypes.c_void_p, ctypes.c_int]
 lib.nes_framebuffer.argtypes = [ctypes.c_void_p]
 lib.nes_framebuffer.restype = ctypes.POINTER(ctypes.c_ubyte)
 lib.nes_framebuffer_size.argtypes = [ctypes.c_void_p]
 lib.nes_framebuffer_size.restype = ctypes.c_int
+lib.nes_framebuffer_indices.argtypes = [ctypes.c_void_p]
+lib.nes_framebuffer_indices.restype = ctypes.POINTER(ctypes.c_ubyte)
+lib.nes_framebuffer_convert.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.POINTER(ctypes.c_ubyte)]
+lib.nes_framebuffer_convert.restype = ctypes.c_int
+lib.nes_state_size.argtypes = [ctypes.c_void_p]
+lib.nes_state_size.restype = ctypes.c_int
+lib.nes_save_state.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_ubyte), ctypes.c_int]
+lib.nes_save_state.restype = ctypes.c_int
+lib.nes_load_state.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_ubyte), ctypes.c_int]
+lib.nes_load_state.restype = ctypes.c_int
+lib.nes_clone.argtypes = [ctypes.c_void_p]
+lib.nes_clone.restype = ctypes.c_void_p
+lib.nes_copy_into.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+lib.nes_copy_into.restype = ctypes.c_int
+lib.nes_rewind_enable.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_int]
+lib.nes_rewind_enable.restype = ctypes.c_int
+lib.nes_rewind.argtypes = [ctypes.c_void_p, ctypes.c_int]
+lib.nes_rewind.restype = ctypes.c_int
+lib.nes_rewind_depth.argtypes = [ctypes.c_void_p]
+lib.nes_rewind_depth.restype = ctypes.c_int
+lib.nes_set_audio_output.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_int]
+lib.nes_set_audio_output.restype = ctypes.c_int
+lib.nes_audio_drain.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_float), ctypes.c_int]
+lib.nes_audio_drain.restype = ctypes.c_int
+lib.nes_audio_available.argtypes = [ctypes.c_void_p]
+lib.nes_audio_available.restype = ctypes.c_int
+lib.nes_audio_capacity.argtypes = [ctypes.c_void_p]
+lib.nes_audio_capacity.restype = ctypes.c_int
+lib.nes_audio_overruns.argtypes = [ctypes.c_void_p]
+lib.nes_audio_overruns.restype = ctypes.c_uint64
+lib.nes_audio_underruns.argtypes = [ctypes.c_void_p]
+lib.nes_audio_underruns.restype = ctypes.c_uint64
 lib.nes_get_ram.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_ubyte)]
 lib.nes_peek.argtypes = [ctypes.c_void_p, ctypes.c_ushort]
 lib.nes_peek.restype = ctypes.c_ubyte
@@ -0,0 +1,116 @@
+"""Post-boot checkpoints: boot a game to a named point once, then start every
+episode from a snapshot of that point instead of emulating the boot again.
+
+A checkpoint is reached by a power-on reset, a fixed input prefix, and then idle
+frames until a predicate holds (e.g. SMB's OperMode == 1). The core is
+deterministic, so the ROM, the prefix and the name of the predicate identify the
+checkpoint; with a cache directory it is written there under those keys, and
+later processes read it back instead of booting at all.
+
+File layout (little-endian):
+    0   b"NESCKPT1"
+    8   uint32 input_len
+    12  uint32 state_len
+    16  input bytes (every controller byte from power-on to the checkpoint)
+    16+input_len  state bytes (Nes.save_state())
+"""
+
+from __future__ import annotations
+
+import hashlib
+import os
+import struct
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Callable
+
+from .core import Nes
+
+_MAGIC = b"NESCKPT1"
+
+
+@dataclass
+class Checkpoint:
+    name: str
+    inputs: bytes
+    state: bytes
+
+
+def capture(
+    rom: bytes,
+    name: str,
+    prefix: bytes,
+    until: Callable[[Nes], bool] | None = None,
+    max_frames: int = 0,
+) -> Checkpoint:
+    """Boot `rom`, apply `prefix`, then step idle frames (at most `max_frames`)
+    until `until(nes)` is true. Runs on a scratch Nes that draws every frame, so
+    the snapshot's framebuffer is valid whatever the caller's render setting."""
+    nes = Nes()
+    nes.load(rom)
+    inputs = bytearray(prefix)
+    for mask in prefix:
+        nes.step(mask)
+    if until is not None:
+        for _ in range(max_frames):
+            if until(nes):
+                break
+            nes.step(0)
+            inputs.append(0)
+    return Checkpoint(name=name, inputs=bytes(inputs), state=nes.save_state())
+
+
+def cache_path(cache_dir: str | Path, rom: bytes, name: str, prefix: bytes) -> Path:
+    rom_key = hashlib.sha256(rom).hexdigest()[:16]
+    point_key = hashlib.sha256(name.encode() + b"\0" + bytes(prefix)).hexdigest()[:16]
+    return Path(cache_dir) / f"{rom_key}-{point_key}.nesckpt"
+
+
+def write_checkpoint(path: str | Path, cp: Checkpoint) -> None:
+    # Write-then-rename, so a process reading the cache never sees half a file.
+    tmp = Path(f"{path}.{os.getpid()}.tmp")
+    with open(tmp, "wb") as f:
+        f.write(_MAGIC)
+        f.write(struct.pack("<II", len(cp.inputs), len(cp.state)))
+        f.write(cp.inputs)
+        f.write(cp.state)
+    os.replace(tmp, path)
+
+
+def read_checkpoint(path: str | Path, name: str) -> Checkpoint:
+    with open(path, "rb") as f:
+        blob = f.read()
+    if len(blob) < 16 or blob[:8] != _MAGIC:
+        raise ValueError("not a checkpoint file")
+    input_len, state_len = struct.unpack_from("<II", blob, 8)
+    inputs = blob[16 : 16 + input_len]
+    state = blob[16 + input_len : 16 + input_len + state_len]
+    if len(inputs) != input_len or len(state) != state_len:
+        raise ValueError("checkpoint is truncated")
+    return Checkpoint(name=name, inputs=inputs, state=state)
+
+
+def load_or_capture(
+    nes: Nes,
+    rom: bytes,
+    name: str,
+    prefix: bytes,
+    until: Callable[[Nes], bool] | None = None,
+    max_frames: int = 0,
+    cache_dir: str | Path | None = None,
+) -> Checkpoint:
+    """The checkpoint from `cache_dir` if one is there and `nes` (loaded with
+    `rom`) accepts it, else a fresh capture(), which is then cached."""
+    path = cache_path(cache_dir, rom, name, prefix) if cache_dir is not None else None
+    if path is not None and path.exists():
+        try:
+            cp = read_checkpoint(path, name)
+            nes.load_state(cp.state)  # rejects files from another core version
+            return cp
+        except ValueError:
+            pass
+    cp = capture(rom, name, prefix, until, max_frames)
+    if path is not None:
+        path.parent.mkdir(parents=True, exist_ok=True)
+        write_checkpoint(path, cp)
+    return cp
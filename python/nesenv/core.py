@@ -7,11 +7,18 @@ the same inputs always produce the same frames, on any machine.
 from __future__ import annotations
 
 import ctypes
+from array import array
 
 from ._native import lib
 
 RAM_SIZE = 0x0800
 FRAMEBUFFER_SIZE = 256 * 240 * 4
+PIXELS = 256 * 240
+
+# Pixel formats for framebuffer_as() (nes_env.h NES_FORMAT_*).
+RGBA = 0
+BGRA = 1
+RGB24 = 2
 
 # Controller button bits (match the hardware shift order).
 A = 0x01
@@ -54,6 +61,89 @@ class Nes:
         """Set player 1's buttons and advance one frame. Returns the frame reason."""
         return lib.nes_step(self._h, buttons & 0xFF)
 
+    def set_render_interval(self, every_n: int) -> None:
+        """Draw every frame (1), none (0), or only every Nth. Game logic is unaffected."""
+        if every_n < 0:
+            raise ValueError("every_n must be >= 0")
+        lib.nes_set_render_interval(self._h, every_n)
+
+    def set_render_threads(self, threads: int) -> None:
+        """Draw finished frames on `threads` background threads (0 = inline). Same pixels."""
+        if threads < 0:
+            raise ValueError("threads must be >= 0")
+        lib.nes_set_render_threads(self._h, threads)
+
+    def save_state(self) -> bytes:
+        """A snapshot of the whole machine, for load_state() on this or a same-ROM Nes."""
+        n = lib.nes_state_size(self._h)
+        if n == 0:
+            raise RuntimeError("no ROM loaded")
+        buf = (ctypes.c_ubyte * n)()
+        if lib.nes_save_state(self._h, buf, n) != 0:
+            raise RuntimeError("nes_save_state failed")
+        return bytes(buf)
+
+    def load_state(self, state: bytes) -> None:
+        """Restore a save_state() snapshot; stepping then replays exactly as after the save."""
+        buf = (ctypes.c_ubyte * len(state)).from_buffer_copy(state)
+        if lib.nes_load_state(self._h, buf, len(state)) != 0:
+            raise ValueError("snapshot does not match the loaded ROM")
+
+    def clone(self) -> "Nes":
+        """A new, independent Nes in exactly this state (ROM shared, not copied)."""
+        h = lib.nes_clone(self._h)
+        if not h:
+            raise RuntimeError("nes_clone failed (no ROM loaded?)")
+        other = Nes.__new__(Nes)
+        other._h = h
+        return other
+
+    def copy_from(self, other: "Nes") -> None:
+        """Become a copy of `other`, reusing this handle (cheaper than clone())."""
+        if lib.nes_copy_into(self._h, other._h) != 0:
+            raise RuntimeError("nes_copy_into failed (no ROM loaded?)")
+
+    def enable_rewind(self, budget_bytes: int = 8 << 20, keyframe_interval: int = 60) -> None:
+        """Record every step() in a rewind ring of at most `budget_bytes` (0 turns it off)."""
+        if lib.nes_rewind_enable(self._h, budget_bytes, keyframe_interval) != 0:
+            raise RuntimeError("nes_rewind_enable failed")
+
+    def rewind(self, frames: int) -> int:
+        """Go back `frames` recorded frames (60 per second); returns how many it went back."""
+        n = lib.nes_rewind(self._h, frames)
+        if n < 0:
+            raise RuntimeError("no rewind history (call enable_rewind first)")
+        return n
+
+    def rewind_depth(self) -> int:
+        """Frames held in the rewind ring, the current one included."""
+        return lib.nes_rewind_depth(self._h)
+
+    def set_audio_output(self, sample_rate: int = 44100, capacity: int = 8192) -> None:
+        """Synthesize audio at `sample_rate` into a queue of `capacity` samples (0 turns it off)."""
+        if lib.nes_set_audio_output(self._h, sample_rate, capacity) != 0:
+            raise ValueError("sample_rate must be 0 or 8000-96000 and capacity positive")
+
+    def audio_drain(self, max_samples: int = 4096) -> array:
+        """Up to `max_samples` queued mono samples, as floats in -1..1."""
+        buf = (ctypes.c_float * max_samples)()
+        n = lib.nes_audio_drain(self._h, buf, max_samples)
+        return array("f", buf[:n])
+
+    def audio_available(self) -> int:
+        return lib.nes_audio_available(self._h)
+
+    def audio_capacity(self) -> int:
+        return lib.nes_audio_capacity(self._h)
+
+    def audio_overruns(self) -> int:
+        """Samples dropped because the queue was full."""
+        return lib.nes_audio_overruns(self._h)
+
+    def audio_underruns(self) -> int:
+        """Drains that found the queue empty."""
+        return lib.nes_audio_underruns(self._h)
+
     def ram(self) -> bytes:
         """The 2 KB of CPU work RAM ($0000-$07FF)."""
         buf = (ctypes.c_ubyte * RAM_SIZE)()
@@ -68,6 +158,19 @@ class Nes:
         ptr = lib.nes_framebuffer(self._h)
         return ctypes.string_at(ptr, FRAMEBUFFER_SIZE)
 
+    def indices(self) -> bytes:
+        """The current frame as 256*240 NES colour indices (no RGB conversion)."""
+        ptr = lib.nes_framebuffer_indices(self._h)
+        return ctypes.string_at(ptr, PIXELS)
+
+    def framebuffer_as(self, fmt: int) -> bytes:
+        """The current frame converted to RGBA, BGRA or RGB24."""
+        buf = (ctypes.c_ubyte * (PIXELS * 4))()
+        n = lib.nes_framebuffer_convert(self._h, fmt, buf)
+        if n == 0:
+            raise ValueError(f"unknown pixel format {fmt}")
+        return bytes(buf)[:n]
+
     def frame_count(self) -> int:
         return lib.nes_frame_count(self._h)
 
@@ -1,17 +1,22 @@
 """A small, Gymnasium-style environment base built on the deterministic core.
 
 It deliberately uses only the standard library: observations are returned as bytes
-(RAM) or RGBA bytes (the framebuffer). The optional Gymnasium adapter in
+(RAM), RGBA bytes (the framebuffer) or one NES colour index per pixel. Frames are only drawn when the observation
+(or `render=True`) needs them. The optional Gymnasium adapter in
 gymnasium_env.py wraps this for the wider RL ecosystem.
 
 A subclass provides the game-specific reset() (how an episode starts) and the
-reward/termination logic inside step(); everything else is generic.
+reward/termination logic inside step(); everything else is generic. Episodes that
+always start from the same point should start from a checkpoint (_reset_to), so
+the boot is emulated once per process, or once ever with checkpoint_dir.
 """
 
 from __future__ import annotations
 
 from pathlib import Path
+from typing import Callable
 
+from .checkpoint import Checkpoint, load_or_capture
 from .core import Nes
 from .movie import write_movie
 
@@ -26,17 +31,25 @@ class NesEnv:
         frameskip: int = 1,
         obs: str = "ram",
         record: bool = False,
+        render: bool | None = None,
+        checkpoint_dir: str | Path | None = None,
     ) -> None:
-        if obs not in ("ram", "rgb"):
-            raise ValueError("obs must be 'ram' or 'rgb'")
+        if obs not in ("ram", "rgb", "indices"):
+            raise ValueError("obs must be 'ram', 'rgb' or 'indices'")
         self.rom = bytes(rom)
         self.actions = list(actions)
         self.frameskip = max(1, frameskip)
         self.obs_kind = obs
         self.record = record
         self.history = bytearray()
+        self.checkpoint_dir = checkpoint_dir
+        self._checkpoints: dict[str, Checkpoint] = {}
         self.nes = Nes()
         self.nes.load(self.rom)
+        # Drawing frames only matters if someone looks at them; RAM agents
+        # skip it (the game runs identically either way).
+        self.render = obs != "ram" if render is None else render
+        self.nes.set_render_interval(1 if self.render else 0)
 
     @property
     def num_actions(self) -> int:
@@ -48,8 +61,38 @@ class NesEnv:
         if self.record:
             self.history.append(mask & 0xFF)
 
+    def _advance(self, mask: int, frames: int) -> None:
+        """Hold `mask` for `frames` (>= 1) frames, drawing only the last (frameskip)."""
+        if self.render:
+            self.nes.set_render_interval(0)
+        for _ in range(frames - 1):
+            self._apply(mask)
+        if self.render:
+            self.nes.set_render_interval(1)
+        self._apply(mask)
+
+    def _reset_to(
+        self,
+        name: str,
+        prefix: bytes,
+        until: Callable[[Nes], bool] | None = None,
+        max_frames: int = 0,
+    ) -> None:
+        """Restore the named checkpoint (see checkpoint.capture), capturing it or
+        reading it from checkpoint_dir the first time. A recorded episode starts
+        with the checkpoint's inputs, so its movie still replays from power-on."""
+        cp = self._checkpoints.get(name)
+        if cp is None:
+            cp = load_or_capture(self.nes, self.rom, name, prefix, until, max_frames, self.checkpoint_dir)
+            self._checkpoints[name] = cp
+        self.nes.load_state(cp.state)
+        if self.record:
+            self.history = bytearray(cp.inputs)
+
     def _obs(self) -> bytes:
-        return self.nes.ram() if self.obs_kind == "ram" else self.nes.framebuffer()
+        if self.obs_kind == "ram":
+            return self.nes.ram()
+        return self.nes.framebuffer() if self.obs_kind == "rgb" else self.nes.indices()
 
     def save_movie(self, path: str | Path) -> None:
         """Write everything applied since the last reset as a .nesmovie."""
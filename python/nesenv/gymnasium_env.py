@@ -19,18 +19,35 @@ from .smb import SuperMarioBrosEnv
 class SmbGymEnv(gym.Env):
     """A Gymnasium wrapper around SuperMarioBrosEnv.
 
-    Observations are numpy arrays: the 2 KB RAM (obs="ram") or the 240x256x4 RGBA
-    frame (obs="rgb"). Actions are a Discrete index into the SMB action set.
+    Observations are numpy arrays: the 2 KB RAM (obs="ram"), the 240x256x4 RGBA
+    frame (obs="rgb") or the 240x256 frame of NES colour indices (obs="indices").
+    Actions are a Discrete index into the SMB action set.
     """
 
     metadata = {"render_modes": ["rgb_array"]}
 
-    def __init__(self, rom: bytes, frameskip: int = 4, obs: str = "ram", record: bool = False) -> None:
-        self._env = SuperMarioBrosEnv(rom, frameskip=frameskip, obs=obs, record=record)
+    def __init__(
+        self,
+        rom: bytes,
+        frameskip: int = 4,
+        obs: str = "ram",
+        record: bool = False,
+        render_mode: str | None = None,
+        checkpoint_dir: str | None = None,
+    ) -> None:
+        self.render_mode = render_mode
+        # RAM observations only draw frames when render() will be used.
+        render = obs != "ram" or render_mode == "rgb_array"
+        self._env = SuperMarioBrosEnv(
+            rom, frameskip=frameskip, obs=obs, record=record, render=render, checkpoint_dir=checkpoint_dir
+        )
         self._obs_kind = obs
         self.action_space = spaces.Discrete(self._env.num_actions)
         if obs == "ram":
             self.observation_space = spaces.Box(0, 255, (2048,), dtype=np.uint8)
+        elif obs == "indices":
+            # 0..63, plus 0x40 (BLANK_PIXEL) where nothing has been drawn since reset.
+            self.observation_space = spaces.Box(0, 0x40, (240, 256), dtype=np.uint8)
         else:
             self.observation_space = spaces.Box(0, 255, (240, 256, 4), dtype=np.uint8)
 
@@ -40,7 +57,9 @@ class SmbGymEnv(gym.Env):
 
     def _to_np(self, raw: bytes) -> np.ndarray:
         arr = np.frombuffer(raw, dtype=np.uint8)
-        return arr if self._obs_kind == "ram" else arr.reshape(240, 256, 4)
+        if self._obs_kind == "ram":
+            return arr
+        return arr.reshape(240, 256, 4) if self._obs_kind == "rgb" else arr.reshape(240, 256)
 
     def reset(self, *, seed=None, options=None):
         super().reset(seed=seed)
@@ -52,4 +71,4 @@ class SmbGymEnv(gym.Env):
         return self._to_np(obs), reward, terminated, truncated, info
 
     def render(self):
-        return self._to_np(self._env.nes.framebuffer())
+        return np.frombuffer(self._env.nes.framebuffer(), dtype=np.uint8).reshape(240, 256, 4)
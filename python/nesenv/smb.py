@@ -1,14 +1,18 @@
 """A Super Mario Bros environment: observation, a small action set, and a reward
 that rewards moving right and staying alive.
 
-Reset boots the ROM and auto-advances through the title and the WORLD 1-1 card so
-every episode begins in gameplay, deterministically. When record=True, every frame
-(including the boot sequence) is captured, so save_movie() produces a self-contained
-.nesmovie you can replay in the browser.
+Reset starts every episode in gameplay, deterministically: the first reset boots the
+ROM and auto-advances through the title and the WORLD 1-1 card, and every reset
+restores a snapshot of that point. Pass checkpoint_dir to keep the snapshot on disk
+so later processes skip the boot too. When record=True, every frame (including the
+boot sequence) is captured, so save_movie() produces a self-contained .nesmovie you
+can replay in the browser.
 """
 
 from __future__ import annotations
 
+from pathlib import Path
+
 from . import core
 from .env import NesEnv
 
@@ -32,8 +36,24 @@ ACTIONS = [
 
 
 class SuperMarioBrosEnv(NesEnv):
-    def __init__(self, rom: bytes, frameskip: int = 1, obs: str = "ram", record: bool = False) -> None:
-        super().__init__(rom, actions=ACTIONS, frameskip=frameskip, obs=obs, record=record)
+    def __init__(
+        self,
+        rom: bytes,
+        frameskip: int = 1,
+        obs: str = "ram",
+        record: bool = False,
+        render: bool | None = None,
+        checkpoint_dir: str | Path | None = None,
+    ) -> None:
+        super().__init__(
+            rom,
+            actions=ACTIONS,
+            frameskip=frameskip,
+            obs=obs,
+            record=record,
+            render=render,
+            checkpoint_dir=checkpoint_dir,
+        )
         self._progress = 0
         self._lives = 0
 
@@ -41,28 +61,19 @@ class SuperMarioBrosEnv(NesEnv):
         return self.nes.peek(PLAYER_PAGE) * 256 + self.nes.peek(PLAYER_X)
 
     def reset(self) -> tuple[bytes, dict]:
-        self.nes.reset()
-        if self.record:
-            self.history = bytearray()
         # Boot, press Start, then idle through the WORLD 1-1 card until controllable.
-        for _ in range(80):
-            self._apply(0)
-        for _ in range(10):
-            self._apply(core.START)
-        frame = 90
-        while frame < 600:
-            self._apply(0)
-            frame += 1
-            if self.nes.peek(OPER_MODE) == 1 and frame > 250:
-                break
+        self._reset_to(
+            "OperMode==1",
+            prefix=bytes(80) + bytes([core.START] * 10),
+            until=lambda nes: nes.peek(OPER_MODE) == 1 and nes.frame_count() > 250,
+            max_frames=600 - 90,
+        )
         self._progress = self._progress_now()
         self._lives = self.nes.peek(LIVES)
         return self._obs(), {"progress": self._progress}
 
     def step(self, action: int) -> tuple[bytes, float, bool, bool, dict]:
-        mask = self.actions[action]
-        for _ in range(self.frameskip):
-            self._apply(mask)
+        self._advance(self.actions[action], self.frameskip)
 
         progress = self._progress_now()
         # Reward forward progress (clamped so a page wrap can't spike it), with a
@@ -12,6 +12,9 @@ import tempfile
 import unittest
 
 from nesenv import Nes, read_movie, version, write_movie
+from nesenv.env import NesEnv
+from nesenv.checkpoint import capture, load_or_capture
+from nesenv.core import RGB24, RGBA
 
 
 def synthetic_rom() -> bytes:
@@ -38,6 +41,21 @@ class TestCore(unittest.TestCase):
         self.assertEqual(nes.frame_count(), 10)
         self.assertEqual(len(nes.ram()), 2048)
         self.assertEqual(len(nes.framebuffer()), 256 * 240 * 4)
+        self.assertEqual(len(nes.indices()), 256 * 240)
+        self.assertEqual(nes.framebuffer_as(RGBA), nes.framebuffer())
+        self.assertEqual(len(nes.framebuffer_as(RGB24)), 256 * 240 * 3)
+
+    def test_env_observations(self):
+        rom = synthetic_rom()
+        self.assertEqual(len(NesEnv(rom, [0], obs="ram")._obs()), 2048)
+        self.assertEqual(len(NesEnv(rom, [0], obs="rgb")._obs()), 256 * 240 * 4)
+        env = NesEnv(rom, [0], obs="indices")
+        self.assertTrue(env.render)
+        env._advance(0, 2)
+        self.assertEqual(env._obs(), env.nes.indices())
+        self.assertLessEqual(max(env._obs()), 0x40)  # 0x40: not drawn since reset
+        with self.assertRaises(ValueError):
+            NesEnv(rom, [0], obs="gray")
 
     def test_rejects_junk(self):
         nes = Nes()
@@ -49,6 +67,7 @@ class TestCore(unittest.TestCase):
         a, b = Nes(), Nes()
         a.load(rom)
         b.load(rom)
+        b.set_render_threads(2)
         seq = [0, 0x80, 0x81, 0x08, 0x10, 0x40]
         for f in range(120):
             a.step(seq[f % len(seq)])
@@ -68,6 +87,93 @@ class TestCore(unittest.TestCase):
             nes.step(seq[i % 4])
         self.assertEqual(first, nes.ram())
 
+    def test_state_roundtrip(self):
+        rom = synthetic_rom()
+        nes = Nes()
+        nes.load(rom)
+        for _ in range(10):
+            nes.step()
+        state = nes.save_state()
+        for _ in range(5):
+            nes.step(0x80)
+        after = (nes.frame_count(), nes.indices())
+        other = Nes()
+        other.load(rom)
+        other.load_state(state)
+        self.assertEqual(other.frame_count(), 10)
+        for _ in range(5):
+            other.step(0x80)
+        self.assertEqual((other.frame_count(), other.indices()), after)
+        with self.assertRaises(ValueError):
+            other.load_state(state[:-1])
+
+    def test_clone_branches_independently(self):
+        nes = Nes()
+        nes.load(synthetic_rom())
+        for _ in range(7):
+            nes.step()
+        fork = nes.clone()
+        pool = Nes()
+        pool.copy_from(nes)
+        for f in range(10):
+            nes.step(f)
+            fork.step(f)
+        self.assertEqual(fork.save_state(), nes.save_state())
+        self.assertEqual(pool.frame_count(), 7)
+
+    def test_rewind(self):
+        nes = Nes()
+        nes.load(synthetic_rom())
+        nes.enable_rewind(1 << 20)
+        for f in range(30):
+            nes.step(f)
+            if f == 9:
+                state = nes.save_state()
+        self.assertEqual(nes.rewind(20), 20)
+        self.assertEqual(nes.save_state(), state)
+        self.assertEqual(nes.rewind_depth(), 11)
+
+    def test_audio_output(self):
+        nes = Nes()
+        nes.load(synthetic_rom())
+        nes.step(0)
+        self.assertEqual(nes.audio_available(), 0)  # off by default
+        nes.set_audio_output(48000, 16384)
+        for _ in range(10):
+            nes.step(0)
+        samples = nes.audio_drain(16384)
+        self.assertAlmostEqual(len(samples), 8000, delta=50)
+        self.assertEqual(len(nes.audio_drain()), 0)
+        self.assertEqual((nes.audio_overruns(), nes.audio_underruns()), (0, 1))
+        with self.assertRaises(ValueError):
+            nes.set_audio_output(1000)
+
+    def test_checkpoint_matches_booting(self):
+        rom = synthetic_rom()
+        prefix = bytes([0, 0x08, 0x08, 0])
+        until = lambda nes: nes.frame_count() >= 12  # noqa: E731
+        cp = capture(rom, "twelve", prefix, until, max_frames=100)
+        self.assertEqual(cp.inputs, prefix + bytes(8))
+
+        booted = Nes()
+        booted.load(rom)
+        for mask in cp.inputs:
+            booted.step(mask)
+        restored = Nes()
+        restored.load(rom)
+        restored.load_state(cp.state)
+        self.assertEqual(restored.save_state(), booted.save_state())
+
+        with tempfile.TemporaryDirectory() as d:
+            first = load_or_capture(restored, rom, "twelve", prefix, until, 100, cache_dir=d)
+            self.assertEqual(len(os.listdir(d)), 1)
+
+            def never(nes):
+                raise AssertionError("booted again instead of reading the cache")
+
+            cached = load_or_capture(restored, rom, "twelve", prefix, never, 100, cache_dir=d)
+            self.assertEqual((cached.inputs, cached.state), (first.inputs, first.state))
+
     def test_movie_roundtrip(self):
         rom = synthetic_rom()
         inputs = bytes([0, 0x80, 0x81, 0x08, 0x40])
@@ -1,4 +1,7 @@
 #include "apu.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace nes {
 namespace {
@@ -11,8 +14,74 @@ const u8 DUTY[4][8] = {{0, 1, 0, 0, 0, 0, 0, 0},
                        {1, 0, 0, 1, 1, 1, 1, 1}};
 const u16 NOISE_PERIOD[16] = {4, 8, 16, 32, 64, 96, 128, 160, 202, 254,
                               380, 508, 762, 1016, 2034, 4068};
+// Frame sequencer: at `cycle` clock the quarter-frame units and, if `half`,
+// the half-frame units; the last entry restarts the sequence.
+struct FrameStep {
+  u32 cycle;
+  bool quarter, half;
+};
+const FrameStep FRAME_STEPS[2][5] = {
+    {{7457, true, false}, {14913, true, true}, {22371, true, false},
+     {29829, true, true}, {29830, false, false}},  // 4-step
+    {{7457, true, false}, {14913, true, true}, {22371, true, false},
+     {37281, true, true}, {37282, false, false}}};  // 5-step
 const u8 TRI_SEQ[32] = {15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
                         0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+
+constexpr double CPU_RATE = 1789773.0;
+
+// The nonlinear mixer as lookup tables: pulse[p1 + p2] and
+// tnd[3 * triangle + 2 * noise + dmc].
+struct MixTables {
+  float pulse[31];
+  float tnd[203];
+  MixTables() {
+    pulse[0] = tnd[0] = 0.0f;
+    for (int n = 1; n < 31; n++) pulse[n] = 95.52f / (8128.0f / n + 100.0f);
+    for (int n = 1; n < 203; n++) tnd[n] = 163.67f / (24329.0f / n + 100.0f);
+  }
+};
+const MixTables MIX;
+
+// A level step, band-limited: a Blackman-windowed sinc impulse (cut off just
+// under Nyquist) spread over KERNEL_WIDTH output samples, one row per
+// 1/KERNEL_PHASES-sample offset of the step. Each row sums to 1, so the
+// running sum of the impulses settles exactly on the new level.
+constexpr int KERNEL_WIDTH = 16;
+constexpr int KERNEL_PHASE_BITS = 5;
+constexpr int KERNEL_PHASES = 1 << KERNEL_PHASE_BITS;
+struct StepKernel {
+  float taps[KERNEL_PHASES][KERNEL_WIDTH];
+  StepKernel() {
+    const double pi = 3.14159265358979323846;
+    const double cutoff = 0.9;  // of Nyquist
+    for (int p = 0; p < KERNEL_PHASES; p++) {
+      double row[KERNEL_WIDTH], sum = 0.0;
+      for (int i = 0; i < KERNEL_WIDTH; i++) {
+        const double x = i - (KERNEL_WIDTH / 2 - 1) - static_cast<double>(p) / KERNEL_PHASES;
+        const double t = (x + KERNEL_WIDTH / 2) / KERNEL_WIDTH;  // 0..1 across the window
+        const double window = 0.42 - 0.5 * std::cos(2 * pi * t) + 0.08 * std::cos(4 * pi * t);
+        const double sinc = x == 0.0 ? 1.0 : std::sin(pi * cutoff * x) / (pi * cutoff * x);
+        row[i] = sinc * window;
+        sum += row[i];
+      }
+      for (int i = 0; i < KERNEL_WIDTH; i++) taps[p][i] = static_cast<float>(row[i] / sum);
+    }
+  }
+};
+const StepKernel KERNEL;
+
+// Tick a down-counting timer that reloads to `period` after reaching 0
+// `ticks` times at once; returns how many times it reloaded.
+u32 advance_timer(u16& timer, u16 period, u32 ticks) {
+  if (ticks <= timer) {
+    timer = static_cast<u16>(timer - ticks);
+    return 0;
+  }
+  ticks -= timer + 1u;  // the first reload
+  timer = static_cast<u16>(period - ticks % (period + 1u));
+  return 1 + ticks / (period + 1u);
+}
 }  // namespace
 
 // ---- Envelope -------------------------------------------------------------
@@ -92,20 +161,27 @@ u8 APU::Triangle::output() const {
 void APU::Noise::clock_timer() {
   if (timer == 0) {
     timer = timer_period;
-    u16 fb = (shift & 1) ^ ((shift >> (mode ? 6 : 1)) & 1);
-    shift = static_cast<u16>((shift >> 1) | (fb << 14));
+    shift_lfsr();
   } else {
     timer--;
   }
 }
 
+void APU::Noise::shift_lfsr() {
+  u16 fb = (shift & 1) ^ ((shift >> (mode ? 6 : 1)) & 1);
+  shift = static_cast<u16>((shift >> 1) | (fb << 14));
+}
+
 u8 APU::Noise::output() const {
   if (!enabled || length == 0 || (shift & 1)) return 0;
   return env.output();
 }
 
 // ---- APU ------------------------------------------------------------------
-APU::APU() { reset(); }
+APU::APU() {
+  set_output(44100, 8192);
+  reset();
+}
 
 void APU::reset() {
   _pulse1 = Pulse();
@@ -117,9 +193,122 @@ void APU::reset() {
   _noise.shift = 1;
   _frame_cycles = 0;
   _frame_mode = 0;
+  _frame_step = 0;
+  _frame_next = FRAME_STEPS[0][0].cycle;
   _apu_cycle = false;
-  _sample_accum = 0.0;
-  _ring_w = _ring_r = 0;
+  clear_samples();  // every channel is silent, which both mixer tables map to 0
+}
+
+void APU::clear_samples() {
+  _pos = 0;
+  _level = _sum = 0.0f;
+  _hp_prev_in = _hp_prev_out = 0.0f;
+  std::fill(_buf, _buf + BUFFER, 0.0f);
+}
+
+void APU::set_output(u32 sample_rate, u32 capacity) {
+  _sample_rate = std::min(std::max(sample_rate, 8000u), 96000u);
+  _sample_step = static_cast<u64>(_sample_rate / CPU_RATE * 4294967296.0 + 0.5);
+  // The same ~35Hz DC-blocking corner at any rate.
+  _hp_coeff = static_cast<float>(1.0 - 0.005 * 44100.0 / _sample_rate);
+  _ring = std::make_unique<AudioRing>(capacity);
+  clear_samples();
+  update_level();
+}
+u32 APU::sample_rate() const { return _sample_rate; }
+
+void APU::set_synthesis(bool enabled) {
+  if (enabled == _synthesis) return;
+  _synthesis = enabled;
+  clear_samples();
+  update_level();  // step up from silence to where the channels are now
+}
+bool APU::synthesis() const { return _synthesis; }
+
+void APU::pause_stream() {
+  _paused.synthesis = _synthesis;
+  _paused.pos = _pos;
+  _paused.level = _level;
+  _paused.sum = _sum;
+  _paused.hp_prev_in = _hp_prev_in;
+  _paused.hp_prev_out = _hp_prev_out;
+  _paused.buf.assign(_buf, _buf + BUFFER);
+  _synthesis = false;  // without clear_samples(): _buf stays as it is
+}
+
+void APU::resume_stream() {
+  _synthesis = _paused.synthesis;
+  _pos = _paused.pos;
+  _level = _paused.level;
+  _sum = _paused.sum;
+  _hp_prev_in = _paused.hp_prev_in;
+  _hp_prev_out = _paused.hp_prev_out;
+  std::copy(_paused.buf.begin(), _paused.buf.end(), _buf);
+}
+
+void APU::Envelope::io_state(StateIO& s) {
+  s.field(start);
+  s.field(loop);
+  s.field(constant);
+  s.field(volume);
+  s.field(decay);
+  s.field(divider);
+}
+
+void APU::Pulse::io_state(StateIO& s) {
+  s.field(enabled);
+  s.field(duty);
+  s.field(duty_step);
+  s.field(timer);
+  s.field(timer_period);
+  s.field(length);
+  s.field(length_halt);
+  env.io_state(s);
+  s.field(sweep_enabled);
+  s.field(sweep_negate);
+  s.field(sweep_reload);
+  s.field(sweep_period);
+  s.field(sweep_shift);
+  s.field(sweep_divider);
+}
+
+void APU::Triangle::io_state(StateIO& s) {
+  s.field(enabled);
+  s.field(timer);
+  s.field(timer_period);
+  s.field(length);
+  s.field(linear);
+  s.field(linear_reload_val);
+  s.field(control);
+  s.field(linear_reload);
+  s.field(step);
+}
+
+void APU::Noise::io_state(StateIO& s) {
+  s.field(enabled);
+  s.field(mode);
+  s.field(length_halt);
+  s.field(timer);
+  s.field(timer_period);
+  s.field(shift);
+  s.field(length);
+  env.io_state(s);
+}
+
+void APU::io_state(StateIO& s) {
+  _pulse1.io_state(s);
+  _pulse2.io_state(s);
+  _triangle.io_state(s);
+  _noise.io_state(s);
+  s.field(_frame_cycles);
+  s.field(_frame_mode);
+  s.field(_frame_step);
+  s.field(_frame_next);
+  s.field(_apu_cycle);
+  if (s.loading()) {
+    clear_samples();
+    update_level();
+  }
 }
 
 void APU::clock_quarter_frame() {
@@ -144,81 +333,142 @@ void APU::clock_half_frame() {
   _pulse2.clock_sweep();
 }
 
-float APU::mix() const {
-  float p = static_cast<float>(_pulse1.output() + _pulse2.output());
-  float pulse_out = p > 0 ? 95.88f / (8128.0f / p + 100.0f) : 0.0f;
-  float tnd = _triangle.output() / 8227.0f + _noise.output() / 12241.0f;
-  float tnd_out = tnd > 0 ? 159.79f / (1.0f / tnd + 100.0f) : 0.0f;
-  return pulse_out + tnd_out;  // ~0..1
+void APU::update_level() {
+  if (!_synthesis) return;
+  const float level = MIX.pulse[_pulse1.output() + _pulse2.output()] +
+                      MIX.tnd[3 * _triangle.output() + 2 * _noise.output()];
+  if (level == _level) return;
+  const float delta = level - _level;
+  _level = level;
+  const float* taps = KERNEL.taps[static_cast<u32>(_pos) >> (32 - KERNEL_PHASE_BITS)];
+  float* out = &_buf[_pos >> 32];
+  for (int i = 0; i < KERNEL_WIDTH; i++) out[i] += delta * taps[i];
 }
 
 void APU::clock() {
+  // Channel outputs only move when a timer reloads, at a sequencer step, or
+  // on a register write.
+  bool fired = _triangle.timer == 0;
   _triangle.clock_timer();  // ticks at the CPU rate
   if (_apu_cycle) {
+    fired |= _pulse1.timer == 0 || _pulse2.timer == 0 || _noise.timer == 0;
     _pulse1.clock_timer();
     _pulse2.clock_timer();
     _noise.clock_timer();
   }
   _apu_cycle = !_apu_cycle;
 
-  _frame_cycles++;
-  if (_frame_mode == 0) {  // 4-step
-    if (_frame_cycles == 7457) {
-      clock_quarter_frame();
-    } else if (_frame_cycles == 14913) {
-      clock_quarter_frame();
-      clock_half_frame();
-    } else if (_frame_cycles == 22371) {
-      clock_quarter_frame();
-    } else if (_frame_cycles == 29829) {
-      clock_quarter_frame();
-      clock_half_frame();
-    } else if (_frame_cycles >= 29830) {
-      _frame_cycles = 0;
-    }
-  } else {  // 5-step
-    if (_frame_cycles == 7457 || _frame_cycles == 22371) {
-      clock_quarter_frame();
-    } else if (_frame_cycles == 14913 || _frame_cycles == 37281) {
-      clock_quarter_frame();
-      clock_half_frame();
-    } else if (_frame_cycles >= 37282) {
-      _frame_cycles = 0;
-    }
+  // Frame sequencer: one compare against the next step's precomputed cycle.
+  if (++_frame_cycles == _frame_next) {
+    clock_frame_step();
+    fired = true;
   }
+  if (!_synthesis) return;
+  if (fired) update_level();
 
-  // Downsample the ~1.79MHz CPU rate to 44.1kHz, with a DC-blocking high-pass.
-  _sample_accum += 44100.0 / 1789773.0;
-  if (_sample_accum >= 1.0) {
-    _sample_accum -= 1.0;
-    float raw = mix();
-    float out = raw - _hp_prev_in + 0.995f * _hp_prev_out;
-    _hp_prev_in = raw;
-    _hp_prev_out = out;
-    push_sample(out);
-  }
+  _pos += _sample_step;
+  if (staged() >= FLUSH_AT) flush();
+}
+
+u32 APU::quiet_cycles() const {
+  // The k-th pulse/noise tick from now lands on cycle 2k, or 2k - 1 if this
+  // cycle is an APU cycle; a timer fires on the tick that finds it at 0.
+  const u32 odd = _apu_cycle ? 1 : 0;
+  u32 next = _frame_next - _frame_cycles;
+  next = std::min(next, _triangle.timer + 1u);
+  next = std::min(next, 2u * (_pulse1.timer + 1u) - odd);
+  next = std::min(next, 2u * (_pulse2.timer + 1u) - odd);
+  next = std::min(next, 2u * (_noise.timer + 1u) - odd);
+  return next - 1;
 }
 
-void APU::push_sample(float s) {
-  int next = (_ring_w + 1) % RING;
-  if (next == _ring_r) return;  // full: drop (front-end fell behind)
-  _ring[_ring_w] = s;
-  _ring_w = next;
+void APU::skip(u32 cycles) {
+  const u16 ticks = static_cast<u16>((cycles + (_apu_cycle ? 1 : 0)) / 2);
+  _triangle.timer = static_cast<u16>(_triangle.timer - cycles);
+  _pulse1.timer = static_cast<u16>(_pulse1.timer - ticks);
+  _pulse2.timer = static_cast<u16>(_pulse2.timer - ticks);
+  _noise.timer = static_cast<u16>(_noise.timer - ticks);
+  if (cycles & 1) _apu_cycle = !_apu_cycle;
+  _frame_cycles += cycles;
+  _pos += cycles * _sample_step;
+  if (staged() >= FLUSH_AT) flush();
 }
 
-int APU::available() const {
-  return (_ring_w - _ring_r + RING) % RING;
+void APU::fast_forward(u32 cycles) {
+  const u32 ticks = (cycles + (_apu_cycle ? 1 : 0)) / 2;
+  if (cycles & 1) _apu_cycle = !_apu_cycle;
+  _frame_cycles += cycles;
+
+  // Length and linear counters only change at sequencer steps and writes,
+  // so whether the triangle advances is fixed across the stretch.
+  const u32 tri_steps = advance_timer(_triangle.timer, _triangle.timer_period, cycles);
+  if (_triangle.length > 0 && _triangle.linear > 0) _triangle.step = (_triangle.step + tri_steps) & 31;
+  _pulse1.duty_step = (_pulse1.duty_step + advance_timer(_pulse1.timer, _pulse1.timer_period, ticks)) & 7;
+  _pulse2.duty_step = (_pulse2.duty_step + advance_timer(_pulse2.timer, _pulse2.timer_period, ticks)) & 7;
+  for (u32 n = advance_timer(_noise.timer, _noise.timer_period, ticks); n > 0; n--) _noise.shift_lfsr();
 }
 
-int APU::drain(float* out, int max) {
-  int n = 0;
-  while (n < max && _ring_r != _ring_w) {
-    out[n++] = _ring[_ring_r];
-    _ring_r = (_ring_r + 1) % RING;
+void APU::run(u32 cycles) {
+  if (!_synthesis) {
+    while (cycles > 0) {
+      const u32 n = std::min(cycles, _frame_next - _frame_cycles);
+      fast_forward(n);
+      if (_frame_cycles == _frame_next) clock_frame_step();
+      cycles -= n;
+    }
+    return;
   }
-  return n;
+  while (cycles > 0) {
+    const u32 quiet = quiet_cycles();
+    if (quiet >= cycles) {
+      skip(cycles);
+      break;
+    }
+    skip(quiet);
+    clock();
+    cycles -= quiet + 1;
+  }
+  flush();
 }
 
+void APU::clock_frame_step() {
+  const FrameStep& step = FRAME_STEPS[_frame_mode][_frame_step];
+  if (step.quarter) clock_quarter_frame();
+  if (step.half) clock_half_frame();
+  if (step.quarter) {
+    _frame_step++;
+  } else {  // end of the sequence
+    _frame_cycles = 0;
+    _frame_step = 0;
+  }
+  _frame_next = FRAME_STEPS[_frame_mode][_frame_step].cycle;
+}
+
+// Integrate the final samples (through the DC-blocking high-pass), queue
+// them, and shift the rest of the buffer down.
+void APU::flush() {
+  const int count = staged();
+  if (count == 0) return;
+  for (int i = 0; i < count; i++) {
+    _sum += _buf[i];
+    const float s = _sum - _hp_prev_in + _hp_coeff * _hp_prev_out;
+    _hp_prev_in = _sum;
+    _hp_prev_out = s;
+    _block[i] = s;
+  }
+  _ring->push(_block, static_cast<u32>(count));
+  const int live = count + KERNEL_WIDTH;  // the newest steps reach this far
+  std::memmove(_buf, _buf + count, KERNEL_WIDTH * sizeof(float));
+  std::fill(_buf + KERNEL_WIDTH, _buf + live, 0.0f);
+  _pos -= static_cast<u64>(count) << 32;
+}
+
+int APU::drain(float* out, int max) { return static_cast<int>(_ring->pop(out, max > 0 ? static_cast<u32>(max) : 0)); }
+int APU::available() const { return static_cast<int>(_ring->size()); }
+u32 APU::capacity() const { return _ring->capacity(); }
+u64 APU::overruns() const { return _ring->overruns(); }
+u64 APU::underruns() const { return _ring->underruns(); }
+
 void APU::write(u16 address, u8 value) {
   switch (address) {
     case 0x4000:
@@ -312,6 +562,8 @@ void APU::write(u16 address, u8 value) {
     case 0x4017:
       _frame_mode = (value & 0x80) ? 1 : 0;
       _frame_cycles = 0;
+      _frame_step = 0;
+      _frame_next = FRAME_STEPS[_frame_mode][0].cycle;
       if (_frame_mode == 1) {  // 5-step: immediate quarter+half clock
         clock_quarter_frame();
         clock_half_frame();
@@ -321,6 +573,7 @@ void APU::write(u16 address, u8 value) {
     default:
       break;  // $4010-$4013 (DMC) accepted as no-ops
   }
+  update_level();
 }
 
 u8 APU::read_status() const {
@@ -0,0 +1,45 @@
+#include "audio_ring.h"
+#include <algorithm>
+#include <cstring>
+
+namespace nes {
+
+AudioRing::AudioRing(u32 capacity) {
+  u32 size = 16;
+  while (size < capacity) size <<= 1;
+  _data.assign(size, 0.0f);
+  _mask = size - 1;
+}
+
+u32 AudioRing::push(const float* samples, u32 count) {
+  const u32 write = _write.load(std::memory_order_relaxed);
+  const u32 read = _read.load(std::memory_order_acquire);  // slots it has finished with
+  const u32 n = std::min(count, capacity() - (write - read));
+  // Copy in at most two pieces: up to the end of the storage, then from 0.
+  const u32 at = write & _mask;
+  const u32 first = std::min(n, capacity() - at);
+  std::memcpy(&_data[at], samples, first * sizeof(float));
+  std::memcpy(&_data[0], samples + first, (n - first) * sizeof(float));
+  _write.store(write + n, std::memory_order_release);
+  if (n < count) _overruns.fetch_add(count - n, std::memory_order_relaxed);
+  return n;
+}
+
+u32 AudioRing::pop(float* out, u32 max) {
+  const u32 read = _read.load(std::memory_order_relaxed);
+  const u32 write = _write.load(std::memory_order_acquire);  // samples it has published
+  const u32 n = std::min(max, write - read);
+  const u32 at = read & _mask;
+  const u32 first = std::min(n, capacity() - at);
+  std::memcpy(out, &_data[at], first * sizeof(float));
+  std::memcpy(out + first, &_data[0], (n - first) * sizeof(float));
+  _read.store(read + n, std::memory_order_release);
+  if (n == 0 && max > 0) _underruns.fetch_add(1, std::memory_order_relaxed);  // ran dry
+  return n;
+}
+
+u32 AudioRing::size() const {
+  return _write.load(std::memory_order_acquire) - _read.load(std::memory_order_acquire);
+}
+
+}  // namespace nes
@@ -1,22 +1,24 @@
 #include "bus.h"
+#include <algorithm>
+#include <cstring>
 
 namespace nes {
 Bus::Bus()
   : _sys_clock(0)
   , _cpu(*this)
-  , _cartridge(nullptr) {}
+  , _cartridge(nullptr) {
+  map_pages();
+}
 
 void Bus::clock() {
+  if (_ppu_clock != _sys_clock) sync_ppu();  // left behind by step()
   // While an OAM DMA is in progress the CPU is halted; the PPU keeps running.
   if (_dma_stall > 0) {
     _dma_stall--;
   } else {
     _cpu.clock();
   }
-  _ppu.clock();
-  _ppu.clock();
-  _ppu.clock();
-  _apu.clock();  // APU runs at the CPU rate, even during a DMA stall
+  _ppu.run(3);
   if (_ppu.take_nmi()) {
     _cpu.trigger_nmi();
   }
@@ -26,9 +28,129 @@ void Bus::clock() {
     if (_cpu.trigger_irq()) _cartridge->irq_clear();
   }
   _sys_clock++;
+  _ppu_clock = _sys_clock;  // the APU catches up when it is next touched
+  _events_dirty = true;
+}
+
+int Bus::step() {
+  int cycles = 0;
+  if (!_catch_up) {
+    do {
+      clock();
+      cycles++;
+    } while (_cpu.get_remaining_cycles() > 0);
+    return cycles;
+  }
+
+  if (_events_dirty) {
+    sync_ppu();
+    schedule_events();
+  }
+  // Same cycle sequence as clock(), but idle CPU cycles are skipped in bulk
+  // and interrupts are only polled where their inputs can change: after an
+  // instruction executes, and at the end of the deadline cycle.
+  do {
+    const u64 until_event = _scheduler.next_deadline() - _sys_clock + 1;
+    u64 span = 1;
+    bool executed = false;
+    if (_dma_stall > 0) {
+      // The CPU is halted. A stall on an instruction boundary ends the step
+      // after one cycle, exactly like the clock() loop.
+      if (_cpu.get_remaining_cycles() > 0) span = std::min<u64>(_dma_stall, until_event);
+      _dma_stall -= static_cast<int>(span);
+    } else if (_cpu.get_remaining_cycles() > 0) {
+      span = std::min<u64>(_cpu.get_remaining_cycles(), until_event);
+      _cpu.skip_cycles(static_cast<u8>(span));
+    } else {
+      _cpu.clock();  // register accesses catch the PPU/APU up to _sys_clock
+      executed = true;
+    }
+    _sys_clock += span;
+    cycles += static_cast<int>(span);
+
+    if (executed && _events_dirty) schedule_events();
+    if (_sys_clock > _scheduler.next_deadline()) {
+      run_events();
+    } else if (executed) {
+      poll_irq();  // the instruction may have cleared I or acknowledged the mapper
+    }
+  } while (_cpu.get_remaining_cycles() > 0);
+  return cycles;
+}
+
+void Bus::sync() {
+  sync_ppu();
+  sync_apu();
+}
+
+void Bus::set_catch_up(bool enabled) {
+  sync();
+  _catch_up = enabled;
+}
+bool Bus::catch_up() const { return _catch_up; }
+
+void Bus::sync_ppu() const {
+  if (_ppu_clock == _sys_clock) return;
+  _ppu.run(static_cast<u32>(_sys_clock - _ppu_clock) * 3);
+  _ppu_clock = _sys_clock;
+}
+
+void Bus::sync_apu() const {
+  if (_apu_clock == _sys_clock) return;
+  _apu.run(static_cast<u32>(_sys_clock - _apu_clock));
+  _apu_clock = _sys_clock;
+}
+
+void Bus::schedule_events() {
+  // The k-th dot after the PPU's current one lands in CPU cycle
+  // _ppu_clock + (k - 1) / 3.
+  auto post = [this](Scheduler::Event event, u32 dots) {
+    if (dots) {
+      _scheduler.schedule(event, _ppu_clock + (dots - 1) / 3);
+    } else {
+      _scheduler.cancel(event);
+    }
+  };
+  const int lines = _cartridge ? _cartridge->scanlines_until_irq() : 0;
+  post(Scheduler::VBLANK_NMI, _ppu.dots_until_nmi());
+  post(Scheduler::MAPPER_IRQ, lines > 0 ? _ppu.dots_until_scanline_pulse(lines) : 0);
+  post(Scheduler::FRAME_END, _ppu.dots_until_frame_end());
+  _irq_line = _cartridge && _cartridge->irq_pending();
+  _events_dirty = false;
+}
+
+void Bus::run_events() {
+  sync_ppu();  // through the deadline cycle; _sys_clock is one past it
+  Scheduler::Event event;
+  while (_scheduler.pop_due(_sys_clock - 1, event)) {
+    switch (event) {
+      case Scheduler::VBLANK_NMI:
+        if (_ppu.take_nmi()) _cpu.trigger_nmi();
+        break;
+      case Scheduler::MAPPER_IRQ:  // _irq_line is refreshed below
+      case Scheduler::FRAME_END:   // run_frame() reads the PPU's frame count
+      default:
+        break;
+    }
+  }
+  schedule_events();
+  poll_irq();
+}
+
+// Deliver a pending mapper IRQ (MMC3). If the CPU has interrupts masked the
+// request stays pending until the I flag clears (level-triggered).
+void Bus::poll_irq() {
+  if (_irq_line && _cpu.trigger_irq()) {
+    _cartridge->irq_clear();
+    _irq_line = false;
+  }
 }
+
 void Bus::reset() {
   _sys_clock = 0;
+  _ppu_clock = 0;
+  _apu_clock = 0;
+  _events_dirty = true;
   _cpu.reset();
   _ppu.reset();
   _apu.reset();
@@ -36,21 +158,118 @@ void Bus::reset() {
   _pad[1].reset();
 }
 
+namespace {
+// Leads every snapshot; load_state() accepts only an exact match.
+struct StateHeader {
+  char magic[4] = {'N', 'E', 'S', 'S'};
+  u16 version = 2;  // bump whenever any io_state() walk changes
+  u8 mapper_id = 0;
+  u8 prg_banks = 0;
+  u8 chr_banks = 0;
+  u8 pad[3] = {};
+  u32 size = 0;  // whole snapshot, header included
+};
+}  // namespace
+
+void Bus::io_state(StateIO& s) {
+  s.field(_sys_clock);
+  s.field(_dma_stall);
+  s.field(_irq_line);
+  s.field(_ram);
+  _pad[0].io_state(s);
+  _pad[1].io_state(s);
+  _cpu.io_state(s);
+  _ppu.io_state(s);
+  _apu.io_state(s);
+  if (_cartridge) _cartridge->io_state(s);
+}
+
+size_t Bus::state_size() {
+  StateIO s(StateIO::Mode::SIZE);
+  io_state(s);
+  return sizeof(StateHeader) + s.size();
+}
+
+void Bus::save_state(u8* out) {
+  sync();  // the PPU and APU as of the CPU's clock
+  StateHeader header;
+  if (_cartridge) {
+    header.mapper_id = _cartridge->_mapper_id;
+    header.prg_banks = _cartridge->_prg_banks;
+    header.chr_banks = _cartridge->_chr_banks;
+  }
+  header.size = static_cast<u32>(state_size());
+  std::memcpy(out, &header, sizeof(header));
+  StateIO s(StateIO::Mode::SAVE, out + sizeof(header));
+  io_state(s);
+}
+
+bool Bus::load_state(const u8* data, size_t size) {
+  StateHeader expected;
+  if (_cartridge) {
+    expected.mapper_id = _cartridge->_mapper_id;
+    expected.prg_banks = _cartridge->_prg_banks;
+    expected.chr_banks = _cartridge->_chr_banks;
+  }
+  expected.size = static_cast<u32>(state_size());
+  if (size != expected.size || std::memcmp(data, &expected, sizeof(expected)) != 0) return false;
+
+  sync();  // finish the current APU block and deferred frame before replacing them
+  StateIO s(StateIO::Mode::LOAD, const_cast<u8*>(data) + sizeof(expected));
+  io_state(s);
+  _ppu_clock = _apu_clock = _sys_clock;
+  _events_dirty = true;
+  map_pages();  // restored PRG banks
+  _ppu.update_mirroring();
+  return true;
+}
+
 CPU& Bus::get_cpu() { return _cpu; }
 PPU& Bus::get_ppu() { return _ppu; }
-APU& Bus::get_apu() { return _apu; }
+APU& Bus::get_apu() {
+  sync_apu();  // samples and state up to the current cycle
+  return _apu;
+}
+AudioRing& Bus::audio_queue() { return _apu.queue(); }
 void Bus::insert_cartridge(const std::shared_ptr<Cartridge>& cartridge) {
   _cartridge = cartridge;
   _ppu.insert_cartridge(cartridge);
+  _events_dirty = true;
+  map_pages();
 }
 
-void Bus::cpu_write(u16 address, u8 value) {
+void Bus::map_pages() {
+  for (size_t page = 0; page < _PAGES; page++) {
+    const u16 address = static_cast<u16>(page << 10);
+    if (address < 0x2000) {
+      _read_pages[page] = _write_pages[page] = &_ram[address & 0x07FF];
+    } else if (address >= 0x6000 && _cartridge) {
+      _read_pages[page] = _cartridge->cpu_read_page(address);
+      _write_pages[page] = _cartridge->cpu_write_page(address);
+    } else {
+      _read_pages[page] = nullptr;  // PPU/APU/IO registers, expansion area
+      _write_pages[page] = nullptr;
+    }
+  }
+}
+
+void Bus::io_write(u16 address, u8 value) {
+  // Mapper registers can switch CHR banks, mirroring, or the IRQ counter, so
+  // the PPU must see everything before the write first.
+  if (address >= 0x8000) {
+    sync_ppu();
+    _events_dirty = true;
+  }
   if (_cartridge && _cartridge->cpu_write(address, value)) {
-  } else if (address >= 0x0000 && address <= 0x1FFF) {
-    _ram[address & 0x07FF] = value;
+  } else if (address >= 0x8000) {
+    map_pages();  // mapper register: PRG banks or mirroring may have moved
+    _ppu.update_mirroring();
   } else if (address >= 0x2000 && address <= 0x3FFF) {
+    sync_ppu();
+    _events_dirty = true;  // NMI enable / rendering enable move the deadline
     _ppu.cpu_write(address & 0x0007, value);
   } else if (address == 0x4014) {
+    sync_ppu();
     // OAMDMA: copy 256 bytes from CPU page $XX00 into PPU OAM (through OAMADDR),
     // then stall the CPU ~513 cycles while the transfer "runs".
     u16 base = static_cast<u16>(value) << 8;
@@ -66,18 +285,19 @@ void Bus::cpu_write(u16 address, u8 value) {
              address == 0x4017) {
     // APU channel, status/enable, and frame-counter registers. ($4017 is the
     // APU frame counter on write; controller 2 on read.)
+    sync_apu();
     _apu.write(address, value);
   }
 }
 
-u8 Bus::cpu_read(u16 address) const {
+u8 Bus::io_read(u16 address) const {
   u8 data = 0x00;
   if (_cartridge && _cartridge->cpu_read(address, data)) {
-  } else if (address >= 0x0000 && address <= 0x1FFF) {
-    data = _ram[address & 0x07FF];
   } else if (address >= 0x2000 && address <= 0x3FFF) {
+    sync_ppu();
     data = _ppu.cpu_read(address & 0x0007);
   } else if (address == 0x4015) {
+    sync_apu();
     data = _apu.read_status();  // APU channel status
   } else if (address == 0x4016) {
     data = _pad[0].read();  // player 1 serial read
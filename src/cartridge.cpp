@@ -1,4 +1,5 @@
 #include "cartridge.h"
+#include <cstring>
 #include <fstream>
 #include <memory>
 #include "mapper_cnrom.h"
@@ -8,6 +9,23 @@
 #include "mapper_zero.h"
 
 namespace nes {
+namespace {
+// Call `f` with the concrete board so the mapper call binds statically (the
+// boards are final, and their hot methods inline); std::visit-style, but the
+// tag lives on the Mapper so test doubles with other mappers still work.
+template <typename F>
+decltype(auto) visit_board(Mapper& m, F&& f) {
+  switch (m.board()) {
+    case Mapper::Board::NROM: return f(static_cast<MapperZero&>(m));
+    case Mapper::Board::MMC1: return f(static_cast<MapperMMC1&>(m));
+    case Mapper::Board::UXROM: return f(static_cast<MapperUxROM&>(m));
+    case Mapper::Board::CNROM: return f(static_cast<MapperCNROM&>(m));
+    case Mapper::Board::MMC3: return f(static_cast<MapperMMC3&>(m));
+    default: return f(m);
+  }
+}
+}  // namespace
+
 Cartridge::Cartridge(const std::string& file) {
   struct Header {
     char name[4];
@@ -37,8 +55,9 @@ Cartridge::Cartridge(const std::string& file) {
     }
 
     if (file_type == 1) {
-      _mirror = (header.mapper1 & 0x01) ? MirrorMode::VERTICAL
-                                        : MirrorMode::HORIZONTAL;
+      _mirror = (header.mapper1 & 0x08)   ? MirrorMode::FOUR_SCREEN
+                : (header.mapper1 & 0x01) ? MirrorMode::VERTICAL
+                                          : MirrorMode::HORIZONTAL;
 
       _prg_banks = header.prg_rom_chunks;
       _prg_memory.resize(_prg_banks * 16384);
@@ -73,6 +92,18 @@ Cartridge::Cartridge(const std::string& file) {
   }
 
   ifs.close();
+  build_chr_cache();
+}
+
+void Cartridge::build_chr_cache() {
+  if (_chr_memory.empty()) return;
+  if (_chr_is_ram) {
+    auto tiles = std::make_shared<ChrCache>(_chr_memory);
+    _chr_ram_tiles = tiles.get();
+    _chr_cache = std::move(tiles);
+  } else {
+    _chr_cache = ChrCache::shared(_chr_memory);
+  }
 }
 
 bool Cartridge::cpu_read(u16 address, u8& data) const {
@@ -81,19 +112,25 @@ bool Cartridge::cpu_read(u16 address, u8& data) const {
     data = _prg_ram[address & 0x1FFF];
     return true;
   }
-  u32 mapped_addr = 0x00;
-  if (_mapper->cpu_read(address, mapped_addr) && mapped_addr < _prg_memory.size()) {
-    data = _prg_memory[mapped_addr];
-    return true;
+  if (address >= 0x8000) {
+    const u32 mapped_addr = _mapper->prg_offset(address);
+    const std::vector<u8>& prg = prg_rom();
+    if (mapped_addr < prg.size()) {
+      data = prg[mapped_addr];
+      return true;
+    }
   }
   return false;
 }
 
 bool Cartridge::ppu_read(u16 address, u8& data) const {
-  u32 mapped_addr = 0x00;
-  if (_mapper->ppu_read(address, mapped_addr) && mapped_addr < _chr_memory.size()) {
-    data = _chr_memory[mapped_addr];
-    return true;
+  if (address <= 0x1FFF) {
+    const u32 mapped_addr = _mapper->chr_offset(address);
+    const std::vector<u8>& chr = chr_memory();
+    if (mapped_addr < chr.size()) {
+      data = chr[mapped_addr];
+      return true;
+    }
   }
   return false;
 }
@@ -107,20 +144,46 @@ bool Cartridge::cpu_write(u16 address, u8 value) {
   // $8000-$FFFF writes are usually mapper-register writes (the mapper updates
   // bank state and returns false); only writable PRG-ROM returns a mapped offset.
   u32 mapped_addr = 0x00;
-  if (_mapper->cpu_write(address, value, mapped_addr)) {
+  if (visit_board(*_mapper, [&](auto& m) { return m.cpu_write(address, value, mapped_addr); })) {
     if (mapped_addr < _prg_memory.size()) _prg_memory[mapped_addr] = value;
     return true;
   }
   return false;
 }
 
+const u8* Cartridge::cpu_read_page(u16 address) const {
+  const u16 base = address & 0xFC00;
+  if (base >= 0x6000 && base <= 0x7FFF) {
+    return (base & 0x1FFFu) + 0x400u <= _prg_ram.size() ? &_prg_ram[base & 0x1FFF] : nullptr;
+  }
+  // Every supported mapper switches PRG in 8KB or larger banks, so a 1KB page
+  // is contiguous in PRG memory.
+  if (base >= 0x8000 && _mapper) {
+    const u32 mapped_addr = _mapper->prg_offset(base);
+    const std::vector<u8>& prg = prg_rom();
+    if (mapped_addr < prg.size() && prg.size() - mapped_addr >= 0x400u) {
+      return &prg[mapped_addr];
+    }
+  }
+  return nullptr;
+}
+
+u8* Cartridge::cpu_write_page(u16 address) {
+  // Only PRG-RAM; $8000-$FFFF writes are mapper registers.
+  const u16 base = address & 0xFC00;
+  if (base >= 0x6000 && base <= 0x7FFF && (base & 0x1FFF) + 0x400u <= _prg_ram.size()) {
+    return &_prg_ram[base & 0x1FFF];
+  }
+  return nullptr;
+}
+
 bool Cartridge::ppu_write(u16 address, u8 value) {
   // Only RAM-backed CHR is writable; use the mapper's banked offset.
   if (_chr_is_ram && address <= 0x1FFF) {
-    u32 mapped_addr = address;
-    if (_mapper->ppu_read(address, mapped_addr) &&
-        mapped_addr < _chr_memory.size()) {
+    const u32 mapped_addr = _mapper->chr_offset(address);
+    if (mapped_addr < _chr_memory.size()) {
       _chr_memory[mapped_addr] = value;
+      if (_chr_ram_tiles) _chr_ram_tiles->update(_chr_memory, mapped_addr);
       return true;
     }
   }
@@ -128,7 +191,8 @@ bool Cartridge::ppu_write(u16 address, u8 value) {
 }
 
 Cartridge::MirrorMode Cartridge::mirror_mode() const {
-  switch (_mapper ? _mapper->mirror() : -1) {
+  if (_mirror == MirrorMode::FOUR_SCREEN) return _mirror;  // wired on the board
+  switch (_mapper ? visit_board(*_mapper, [](auto& m) { return m.mirror(); }) : -1) {
     case 0: return MirrorMode::HORIZONTAL;
     case 1: return MirrorMode::VERTICAL;
     case 2: return MirrorMode::SINGLE_LO;
@@ -138,13 +202,59 @@ Cartridge::MirrorMode Cartridge::mirror_mode() const {
 }
 
 void Cartridge::signal_scanline() {
-  if (_mapper) _mapper->scanline();
+  if (_mapper) visit_board(*_mapper, [](auto& m) { m.scanline(); });
 }
 bool Cartridge::irq_pending() const {
-  return _mapper && _mapper->irq_pending();
+  return _mapper && visit_board(*_mapper, [](auto& m) { return m.irq_pending(); });
 }
 void Cartridge::irq_clear() {
-  if (_mapper) _mapper->irq_clear();
+  if (_mapper) visit_board(*_mapper, [](auto& m) { m.irq_clear(); });
+}
+int Cartridge::scanlines_until_irq() const {
+  return _mapper ? visit_board(*_mapper, [](auto& m) { return m.scanlines_until_irq(); }) : 0;
+}
+
+void Cartridge::io_state(StateIO& s) {
+  _mapper->io_state(s);
+  s.bytes(_prg_ram.data(), _prg_ram.size());
+  if (!_chr_is_ram) return;
+  if (!s.loading()) {
+    s.bytes(_chr_memory.data(), _chr_memory.size());
+    return;
+  }
+  // Re-decode only the tiles that differ; a snapshot of the same scene
+  // usually changes few or none.
+  const u8* chr = s.take(_chr_memory.size());
+  for (size_t tile = 0; tile < _chr_memory.size(); tile += 16) {
+    if (std::memcmp(&_chr_memory[tile], chr + tile, 16) == 0) continue;
+    std::memcpy(&_chr_memory[tile], chr + tile, 16);
+    if (_chr_ram_tiles) {
+      for (u32 row = 0; row < 8; row++) _chr_ram_tiles->update(_chr_memory, static_cast<u32>(tile + row));
+    }
+  }
+}
+
+std::shared_ptr<Cartridge> Cartridge::clone(const std::shared_ptr<const Cartridge>& source) {
+  auto cart = std::shared_ptr<Cartridge>(new Cartridge());
+  cart->_prg_ram = source->_prg_ram;
+  cart->_mapper = source->_mapper->clone();
+  cart->_mapper_id = source->_mapper_id;
+  cart->_prg_banks = source->_prg_banks;
+  cart->_chr_banks = source->_chr_banks;
+  cart->_mirror = source->_mirror;
+  cart->_chr_is_ram = source->_chr_is_ram;
+  cart->_rom = source->_rom ? source->_rom : source;  // the original owns the ROM
+  if (cart->_chr_is_ram) {
+    cart->_chr_memory = source->_chr_memory;
+    if (source->_chr_ram_tiles) {
+      auto tiles = std::make_shared<ChrCache>(*source->_chr_ram_tiles);
+      cart->_chr_ram_tiles = tiles.get();
+      cart->_chr_cache = std::move(tiles);
+    }
+  } else {
+    cart->_chr_cache = source->_chr_cache;
+  }
+  return cart;
 }
 
 std::shared_ptr<Cartridge> Cartridge::from_ines(const std::vector<u8>& bytes,
@@ -161,12 +271,6 @@ std::shared_ptr<Cartridge> Cartridge::from_ines(const std::vector<u8>& bytes,
   const u8 flags6 = bytes[6];
   const u8 flags7 = bytes[7];
 
-  // Four-screen mirroring is unsupported in Phase 1.
-  if (flags6 & 0x08) {
-    out_status = 3;
-    return nullptr;
-  }
-
   // Supported mappers: 0 NROM, 1 MMC1, 2 UxROM, 3 CNROM, 4 MMC3.
   const u8 mapper = (flags7 & 0xF0) | (flags6 >> 4);
   if (mapper != 0 && mapper != 1 && mapper != 2 && mapper != 3 && mapper != 4) {
@@ -191,8 +295,9 @@ std::shared_ptr<Cartridge> Cartridge::from_ines(const std::vector<u8>& bytes,
   cart->_mapper_id = mapper;
   cart->_prg_banks = prg_banks;
   cart->_chr_banks = chr_banks;
-  cart->_mirror =
-      (flags6 & 0x01) ? MirrorMode::VERTICAL : MirrorMode::HORIZONTAL;
+  cart->_mirror = (flags6 & 0x08)   ? MirrorMode::FOUR_SCREEN
+                 : (flags6 & 0x01) ? MirrorMode::VERTICAL
+                                   : MirrorMode::HORIZONTAL;
 
   // Slice PRG.
   cart->_prg_memory.assign(bytes.begin() + offset,
@@ -230,6 +335,7 @@ std::shared_ptr<Cartridge> Cartridge::from_ines(const std::vector<u8>& bytes,
       cart->_mapper = std::make_shared<MapperZero>(prg_banks, chr_banks);
       break;
   }
+  cart->build_chr_cache();
   out_status = 0;
   return cart;
 }
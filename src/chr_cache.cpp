@@ -0,0 +1,56 @@
+#include "chr_cache.h"
+#include <mutex>
+
+namespace nes {
+
+ChrCache::ChrCache(const std::vector<u8>& chr)
+  : _tiles(static_cast<u32>(chr.size() / 16)), _pixels(static_cast<size_t>(_tiles) * 128) {
+  for (u32 tile = 0; tile < _tiles; tile++) {
+    for (u32 row = 0; row < 8; row++) decode_row(chr, tile, row);
+  }
+}
+
+void ChrCache::decode_row(const std::vector<u8>& chr, u32 tile, u32 row) {
+  const u8 lo = chr[tile * 16 + row];
+  const u8 hi = chr[tile * 16 + 8 + row];
+  u8* plain = &_pixels[((tile << 1) << 6) | (row << 3)];
+  u8* flipped = plain + 64;
+  for (int col = 0; col < 8; col++) {
+    const int bit = 7 - col;
+    const u8 pixel2 = static_cast<u8>(((hi >> bit) & 1) << 1) | static_cast<u8>((lo >> bit) & 1);
+    plain[col] = pixel2;
+    flipped[7 - col] = pixel2;
+  }
+}
+
+void ChrCache::update(const std::vector<u8>& chr, u32 offset) {
+  const u32 tile = offset >> 4;
+  if (tile < _tiles) decode_row(chr, tile, offset & 7);
+}
+
+std::shared_ptr<const ChrCache> ChrCache::shared(const std::vector<u8>& chr) {
+  // Caches stay alive only while some cartridge holds them.
+  static std::mutex mutex;
+  static std::vector<std::weak_ptr<const ChrCache>> caches;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  std::shared_ptr<const ChrCache> found;
+  for (size_t i = 0; i < caches.size();) {
+    auto cache = caches[i].lock();
+    if (!cache) {
+      caches[i] = caches.back();
+      caches.pop_back();
+      continue;
+    }
+    if (!found && cache->_source == chr) found = cache;
+    i++;
+  }
+  if (found) return found;
+
+  auto cache = std::make_shared<ChrCache>(chr);
+  cache->_source = chr;
+  caches.push_back(cache);
+  return cache;
+}
+
+}  // namespace nes
@@ -0,0 +1,185 @@
+#include "compose.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define NES_COMPOSE_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NES_COMPOSE_AVX2 1
+#include <immintrin.h>
+#endif
+#if defined(__wasm_simd128__)
+#define NES_COMPOSE_WASM 1
+#include <wasm_simd128.h>
+#endif
+
+namespace nes {
+
+namespace {
+constexpr int WIDTH = 256;
+
+inline u8 select_index(u8 bg, u8 any, u8 front) {
+  return bg ? (front ? front : bg) : static_cast<u8>(any & 0x1F);
+}
+}  // namespace
+
+bool compose_line_scalar(const u8* bg, const u8* spr_any, const u8* spr_front,
+                         const u8* colors, u8* out) {
+  u8 hit = 0;
+  for (int x = 0; x < WIDTH; x++) {
+    hit |= static_cast<u8>(spr_any[x] & (bg[x] ? 0x80 : 0));
+    out[x] = colors[select_index(bg[x], spr_any[x], spr_front[x])];
+  }
+  return hit != 0;
+}
+
+void expand_pixels_scalar(const u8* indices, int count, const u32* table, u32* out) {
+  for (int i = 0; i < count; i++) out[i] = table[indices[i]];
+}
+
+// The SIMD kernels pick 16 or 32 indices at once with compare/and/or masks
+// (idx = bg ? (front ? front : bg) : any & 0x1F) and fold the sprite-0 test
+// into a mask reduction. The 32-entry colour lookup is two 16-byte shuffles
+// where the ISA has one (AVX2, SIMD128) and a short scalar loop on SSE2.
+#if NES_COMPOSE_SSE2
+namespace {
+bool compose_line_sse2(const u8* bg, const u8* spr_any, const u8* spr_front,
+                       const u8* colors, u8* out) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i low5 = _mm_set1_epi8(0x1F);
+  const __m128i flag = _mm_set1_epi8(static_cast<char>(0x80));
+  __m128i hit = zero;
+  alignas(16) u8 idx[16];
+  for (int x = 0; x < WIDTH; x += 16) {
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bg + x));
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(spr_any + x));
+    const __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(spr_front + x));
+    const __m128i bg_clear = _mm_cmpeq_epi8(b, zero);
+    // front is 0 where there is none, so OR-ing in bg there picks bg.
+    const __m128i opaque = _mm_or_si128(f, _mm_and_si128(_mm_cmpeq_epi8(f, zero), b));
+    const __m128i pick = _mm_or_si128(_mm_andnot_si128(bg_clear, opaque),
+                                      _mm_and_si128(bg_clear, _mm_and_si128(a, low5)));
+    hit = _mm_or_si128(hit, _mm_andnot_si128(bg_clear, _mm_and_si128(a, flag)));
+    _mm_store_si128(reinterpret_cast<__m128i*>(idx), pick);
+    for (int i = 0; i < 16; i++) out[x + i] = colors[idx[i]];
+  }
+  return _mm_movemask_epi8(hit) != 0;
+}
+}  // namespace
+#endif
+
+#if NES_COMPOSE_AVX2
+namespace {
+__attribute__((target("avx2"))) bool compose_line_avx2(const u8* bg, const u8* spr_any,
+                                                       const u8* spr_front, const u8* colors,
+                                                       u8* out) {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i low5 = _mm256_set1_epi8(0x1F);
+  const __m256i bit4 = _mm256_set1_epi8(0x10);
+  const __m256i flag = _mm256_set1_epi8(static_cast<char>(0x80));
+  // pshufb looks up 16 bytes per 128-bit lane: palette-RAM $00-$0F and $10-$1F.
+  const __m256i colors_lo =
+      _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(colors)));
+  const __m256i colors_hi =
+      _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(colors + 16)));
+  __m256i hit = zero;
+  for (int x = 0; x < WIDTH; x += 32) {
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bg + x));
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(spr_any + x));
+    const __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(spr_front + x));
+    const __m256i bg_clear = _mm256_cmpeq_epi8(b, zero);
+    const __m256i opaque = _mm256_blendv_epi8(f, b, _mm256_cmpeq_epi8(f, zero));
+    const __m256i pick = _mm256_blendv_epi8(opaque, _mm256_and_si256(a, low5), bg_clear);
+    hit = _mm256_or_si256(hit, _mm256_andnot_si256(bg_clear, _mm256_and_si256(a, flag)));
+    const __m256i color = _mm256_blendv_epi8(_mm256_shuffle_epi8(colors_lo, pick),
+                                             _mm256_shuffle_epi8(colors_hi, pick),
+                                             _mm256_cmpeq_epi8(_mm256_and_si256(pick, bit4), bit4));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), color);
+  }
+  return _mm256_movemask_epi8(hit) != 0;
+}
+
+__attribute__((target("avx2"))) void expand_pixels_avx2(const u8* indices, int count,
+                                                        const u32* table, u32* out) {
+  const int* entries = reinterpret_cast<const int*>(table);
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices + i));
+    const __m256i rgba = _mm256_i32gather_epi32(entries, _mm256_cvtepu8_epi32(bytes), 4);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), rgba);
+  }
+  for (; i < count; i++) out[i] = table[indices[i]];
+}
+}  // namespace
+#endif
+
+#if NES_COMPOSE_WASM
+namespace {
+bool compose_line_simd128(const u8* bg, const u8* spr_any, const u8* spr_front,
+                          const u8* colors, u8* out) {
+  const v128_t zero = wasm_i8x16_splat(0);
+  const v128_t low5 = wasm_i8x16_splat(0x1F);
+  const v128_t sixteen = wasm_i8x16_splat(0x10);
+  const v128_t flag = wasm_i8x16_splat(static_cast<int8_t>(0x80));
+  const v128_t colors_lo = wasm_v128_load(colors);
+  const v128_t colors_hi = wasm_v128_load(colors + 16);
+  v128_t hit = zero;
+  for (int x = 0; x < WIDTH; x += 16) {
+    const v128_t b = wasm_v128_load(bg + x);
+    const v128_t a = wasm_v128_load(spr_any + x);
+    const v128_t f = wasm_v128_load(spr_front + x);
+    const v128_t bg_clear = wasm_i8x16_eq(b, zero);
+    const v128_t opaque = wasm_v128_bitselect(b, f, wasm_i8x16_eq(f, zero));
+    const v128_t pick = wasm_v128_bitselect(wasm_v128_and(a, low5), opaque, bg_clear);
+    hit = wasm_v128_or(hit, wasm_v128_andnot(wasm_v128_and(a, flag), bg_clear));
+    // swizzle yields 0 for out-of-range lanes, so each table fills only its half.
+    const v128_t color = wasm_v128_or(wasm_i8x16_swizzle(colors_lo, pick),
+                                      wasm_i8x16_swizzle(colors_hi, wasm_i8x16_sub(pick, sixteen)));
+    wasm_v128_store(out + x, color);
+  }
+  return wasm_v128_any_true(hit);
+}
+}  // namespace
+#endif
+
+int compose_kernels(ComposeKernel* out, int max) {
+  int n = 0;
+  auto add = [&](const char* name, ComposeFn fn, ExpandFn expand) {
+    if (n < max) out[n++] = {name, fn, expand};
+  };
+  add("scalar", compose_line_scalar, expand_pixels_scalar);
+#if NES_COMPOSE_SSE2
+  add("sse2", compose_line_sse2, expand_pixels_scalar);  // no gather before AVX2
+#endif
+#if NES_COMPOSE_AVX2
+  if (__builtin_cpu_supports("avx2")) add("avx2", compose_line_avx2, expand_pixels_avx2);
+#endif
+#if NES_COMPOSE_WASM
+  add("simd128", compose_line_simd128, expand_pixels_scalar);
+#endif
+  return n;
+}
+
+namespace {
+// The last kernel compose_kernels() lists is the widest one available.
+const ComposeKernel& best_kernel() {
+  static const ComposeKernel best = [] {
+    ComposeKernel all[4];
+    return all[compose_kernels(all, 4) - 1];
+  }();
+  return best;
+}
+}  // namespace
+
+bool compose_line(const u8* bg, const u8* spr_any, const u8* spr_front,
+                  const u8* colors, u8* out) {
+  return best_kernel().fn(bg, spr_any, spr_front, colors, out);
+}
+
+void expand_pixels(const u8* indices, int count, const u32* table, u32* out) {
+  best_kernel().expand(indices, count, table, out);
+}
+
+const char* compose_kernel_name() { return best_kernel().name; }
+
+}  // namespace nes
@@ -306,34 +306,609 @@ CPU::CPU(Bus &bus)
 
 void CPU::clock() {
   if (_cycles == 0) {
-    u8 opcode = read_byte(_PC++);
-    set_flag(Flag::UNUSED, true);
-
-    const auto &instruction = _instruction_table[opcode];
-    if (instruction.cycles == 0) throw std::runtime_error("Unknown opcode: " + std::to_string(opcode));
-
-    _cycles = instruction.cycles;
-
-    if (instruction.is_implied) {
-      // Handle implied addressing operations
-      (this->*(instruction.implied_op))();
-    } else {
-      // Handle operations that require addressing
-      auto addr_mode = instruction.mode;
-      u16 addr = 0;
-      if (addr_mode != nullptr) {
-        addr = (this->*addr_mode)();
-
-        if (_page_crossed && instruction.is_extra_cycle) {
-          _cycles++;
-          _page_crossed = false;
-        }
-      }
+#if NES_CPU_SWITCH_DISPATCH
+    execute_switch(1);
+#else
+    execute_table();
+#endif
+  }
+  _cycles--;
+}
 
-      (this->*(instruction.addressed_op))(addr);
+void CPU::skip_cycles(u8 cycles) { _cycles -= cycles; }
+
+int CPU::run(int cycle_budget) {
+  // Cycles still owed by a partially clocked instruction or an interrupt entry
+  // count first; run() always returns on an instruction boundary.
+  int used = _cycles;
+  _cycles = 0;
+  if (used >= cycle_budget) return used;
+
+#if NES_CPU_SWITCH_DISPATCH
+  used += execute_switch(cycle_budget - used);
+#else
+  do {
+    execute_table();
+    used += _cycles;
+  } while (used < cycle_budget);
+#endif
+  _cycles = 0;
+  return used;
+}
+
+int CPU::step_instruction() { return run(1); }
+
+// Table-driven dispatch: two pointer-to-member calls per instruction. Kept as
+// the reference implementation (and for NES_CPU_SWITCH_DISPATCH=OFF builds);
+// cpu_test_dispatch cross-checks the switch core against it.
+void CPU::execute_table() {
+  u8 opcode = read_byte(_PC++);
+  set_flag(Flag::UNUSED, true);
+
+  const auto &instruction = _instruction_table[opcode];
+  if (instruction.cycles == 0) throw std::runtime_error("Unknown opcode: " + std::to_string(opcode));
+
+  _cycles = instruction.cycles;
+
+  if (instruction.is_implied) {
+    // Handle implied addressing operations
+    (this->*(instruction.implied_op))();
+  } else {
+    // Handle operations that require addressing
+    auto addr_mode = instruction.mode;
+    u16 addr = 0;
+    if (addr_mode != nullptr) {
+      addr = (this->*addr_mode)();
+
+      if (_page_crossed && instruction.is_extra_cycle) {
+        _cycles++;
+        _page_crossed = false;
+      }
     }
+
+    (this->*(instruction.addressed_op))(addr);
   }
-  _cycles--;
+}
+
+// Switch-dispatched interpreter. Every opcode x addressing-mode pair is spelled
+// out as its own case, so the mode and the operation inline into one block and
+// the compiler lowers the switch to a single jump table. Executes whole
+// instructions until `cycle_budget` cycles are used and returns the total;
+// _cycles is left holding the last instruction's count (what clock() expects).
+// Registers live in locals for the whole run, which lets them stay in host
+// registers across the (opaque) bus calls. Semantics, including the cycle
+// counts and the page-cross penalty, must match the _instruction_table exactly.
+int CPU::execute_switch(int cycle_budget) {
+  constexpr u8 C = (u8)Flag::CARRY, Z = (u8)Flag::ZERO, I = (u8)Flag::INTERRUPT_DISABLE, D = (u8)Flag::DECIMAL,
+               B = (u8)Flag::BREAK, U = (u8)Flag::UNUSED, V = (u8)Flag::OVERFLOW_, N = (u8)Flag::NEGATIVE;
+
+  u8 A = _A, X = _X, Y = _Y, SP = _SP, P = _status;
+  u16 PC = _PC;
+  u8 cycles = 0;
+
+  auto read = [this](u16 addr) -> u8 { return _bus.cpu_read(addr); };
+  auto write = [this](u16 addr, u8 value) { _bus.cpu_write(addr, value); };
+  auto flag = [&](u8 f, bool on) { P = on ? (P | f) : (P & ~f); };
+  auto zn = [&](u8 value) { P = (P & ~(Z | N)) | (value == 0 ? Z : 0) | (value & N); };
+  auto push = [&](u8 value) { write(0x0100 + SP--, value); };
+  auto pull = [&]() -> u8 { return read(0x0100 + ++SP); };
+
+  // Addressing modes. The indexed ones take whether this opcode pays the +1
+  // page-cross penalty (reads do, stores and read-modify-writes don't).
+  auto imm = [&]() -> u16 { return PC++; };
+  auto zp = [&]() -> u16 { return read(PC++); };
+  auto zpx = [&]() -> u16 { return (u8)(read(PC++) + X); };
+  auto zpy = [&]() -> u16 { return (u8)(read(PC++) + Y); };
+  auto ab = [&]() -> u16 {
+    u16 lo = read(PC++);
+    u16 hi = read(PC++);
+    return (hi << 8) | lo;
+  };
+  auto indexed = [&](u16 base, u8 index, bool penalty) -> u16 {
+    u16 addr = base + index;
+    if (penalty && ((base ^ addr) & 0xFF00)) cycles++;
+    return addr;
+  };
+  auto abx = [&](bool penalty) -> u16 { return indexed(ab(), X, penalty); };
+  auto aby = [&](bool penalty) -> u16 { return indexed(ab(), Y, penalty); };
+  auto izx = [&]() -> u16 {
+    u8 zp_addr = read(PC++) + X;
+    u16 lo = read(zp_addr);
+    u16 hi = read((u8)(zp_addr + 1));
+    return (hi << 8) | lo;
+  };
+  auto izy = [&](bool penalty) -> u16 {
+    u8 zp_addr = read(PC++);
+    u16 lo = read(zp_addr);
+    u16 hi = read((u8)(zp_addr + 1));
+    return indexed((hi << 8) | lo, Y, penalty);
+  };
+  auto ind = [&]() -> u16 {
+    u16 ptr = ab();
+    u16 lo = read(ptr);
+    u16 hi = read((ptr & 0x00FF) == 0x00FF ? (ptr & 0xFF00) : (ptr + 1));  // page-wrap bug
+    return (hi << 8) | lo;
+  };
+
+  // Shared ALU helpers.
+  auto adc_value = [&](u8 value) {
+    u16 sum = (u16)A + value + (P & C);
+    flag(C, sum > 0xFF);
+    flag(V, ((A ^ sum) & (value ^ sum) & 0x80) != 0);
+    A = (u8)sum;
+    zn(A);
+  };
+  auto sbc_value = [&](u8 value) {
+    u16 sub = (u16)A - value - (1 - (P & C));
+    flag(C, !(sub & 0x100));
+    flag(V, ((A ^ value) & 0x80) && ((A ^ sub) & 0x80));
+    A = (u8)sub;
+    zn(A);
+  };
+  auto compare = [&](u8 reg, u8 value) {
+    flag(C, reg >= value);
+    zn((u8)(reg - value));
+  };
+  auto asl_value = [&](u8 value) -> u8 {
+    flag(C, value & 0x80);
+    return value << 1;
+  };
+  auto lsr_value = [&](u8 value) -> u8 {
+    flag(C, value & 0x01);
+    return value >> 1;
+  };
+  auto rol_value = [&](u8 value) -> u8 {
+    u8 result = (u8)(value << 1) | (P & C);
+    flag(C, value & 0x80);
+    return result;
+  };
+  auto ror_value = [&](u8 value) -> u8 {
+    u8 result = (value >> 1) | ((P & C) ? 0x80 : 0x00);
+    flag(C, value & 0x01);
+    return result;
+  };
+  auto branch = [&](bool taken) {
+    i8 offset = (i8)read(PC++);
+    if (!taken) return;
+    u16 old_page = PC & 0xFF00;
+    PC += offset;
+    cycles++;
+    if ((PC & 0xFF00) != old_page) cycles++;
+  };
+
+  // Operations that take an effective address.
+  auto lda = [&](u16 addr) { zn(A = read(addr)); };
+  auto ldx = [&](u16 addr) { zn(X = read(addr)); };
+  auto ldy = [&](u16 addr) { zn(Y = read(addr)); };
+  auto sta = [&](u16 addr) { write(addr, A); };
+  auto stx = [&](u16 addr) { write(addr, X); };
+  auto sty = [&](u16 addr) { write(addr, Y); };
+  auto adc = [&](u16 addr) { adc_value(read(addr)); };
+  auto sbc = [&](u16 addr) { sbc_value(read(addr)); };
+  auto cmp = [&](u16 addr) { compare(A, read(addr)); };
+  auto cpx = [&](u16 addr) { compare(X, read(addr)); };
+  auto cpy = [&](u16 addr) { compare(Y, read(addr)); };
+  auto and_ = [&](u16 addr) { zn(A &= read(addr)); };
+  auto ora = [&](u16 addr) { zn(A |= read(addr)); };
+  auto eor = [&](u16 addr) { zn(A ^= read(addr)); };
+  auto bit = [&](u16 addr) {
+    u8 value = read(addr);
+    P = (P & ~(N | V | Z)) | (value & (N | V)) | ((A & value) == 0 ? Z : 0);
+  };
+  auto asl = [&](u16 addr) {
+    u8 value = asl_value(read(addr));
+    write(addr, value);
+    zn(value);
+  };
+  auto lsr = [&](u16 addr) {
+    u8 value = lsr_value(read(addr));
+    write(addr, value);
+    zn(value);
+  };
+  auto rol = [&](u16 addr) {
+    u8 value = rol_value(read(addr));
+    write(addr, value);
+    zn(value);
+  };
+  auto ror = [&](u16 addr) {
+    u8 value = ror_value(read(addr));
+    write(addr, value);
+    zn(value);
+  };
+  auto inc = [&](u16 addr) {
+    u8 value = read(addr) + 1;
+    write(addr, value);
+    zn(value);
+  };
+  auto dec = [&](u16 addr) {
+    u8 value = read(addr) - 1;
+    write(addr, value);
+    zn(value);
+  };
+  auto jmp = [&](u16 addr) { PC = addr; };
+  auto jsr = [&](u16 addr) {
+    PC--;
+    push(PC >> 8);
+    push(PC & 0xFF);
+    PC = addr;
+  };
+
+  // Unofficial opcodes (see the op_* reference versions for the details).
+  auto nop_addr = [&](u16 addr) { (void)addr; };
+  auto lax = [&](u16 addr) { zn(A = X = read(addr)); };
+  auto sax = [&](u16 addr) { write(addr, A & X); };
+  auto dcp = [&](u16 addr) {
+    u8 value = read(addr) - 1;
+    write(addr, value);
+    compare(A, value);
+  };
+  auto isc = [&](u16 addr) {
+    u8 value = read(addr) + 1;
+    write(addr, value);
+    sbc_value(value);
+  };
+  auto slo = [&](u16 addr) {
+    u8 value = asl_value(read(addr));
+    write(addr, value);
+    zn(A |= value);
+  };
+  auto rla = [&](u16 addr) {
+    u8 value = rol_value(read(addr));
+    write(addr, value);
+    zn(A &= value);
+  };
+  auto sre = [&](u16 addr) {
+    u8 value = lsr_value(read(addr));
+    write(addr, value);
+    zn(A ^= value);
+  };
+  auto rra = [&](u16 addr) {
+    u8 value = ror_value(read(addr));
+    write(addr, value);
+    adc_value(value);
+  };
+  auto anc = [&](u16 addr) {
+    zn(A &= read(addr));
+    flag(C, A & 0x80);
+  };
+  auto alr = [&](u16 addr) { zn(A = lsr_value(A & read(addr))); };
+  auto arr = [&](u16 addr) {
+    A &= read(addr);
+    A = (A >> 1) | ((P & C) ? 0x80 : 0x00);
+    zn(A);
+    flag(C, A & 0x40);
+    flag(V, ((A >> 6) ^ (A >> 5)) & 0x01);
+  };
+  auto axs = [&](u16 addr) {
+    u8 value = read(addr);
+    flag(C, (A & X) >= value);
+    zn(X = (u8)((A & X) - value));
+  };
+  auto las = [&](u16 addr) { zn(A = X = SP = read(addr) & SP); };
+
+  // Implied operations.
+  auto nop = [&]() {};
+  auto tax = [&]() { zn(X = A); };
+  auto tay = [&]() { zn(Y = A); };
+  auto txa = [&]() { zn(A = X); };
+  auto tya = [&]() { zn(A = Y); };
+  auto tsx = [&]() { zn(X = SP); };
+  auto txs = [&]() { SP = X; };
+  auto pha = [&]() { push(A); };
+  auto php = [&]() { push(P | B | U); };
+  auto pla = [&]() { zn(A = pull()); };
+  auto plp = [&]() { P = (pull() & ~B) | (P & B) | U; };
+  auto asl_acc = [&]() { zn(A = asl_value(A)); };
+  auto lsr_acc = [&]() { zn(A = lsr_value(A)); };
+  auto rol_acc = [&]() { zn(A = rol_value(A)); };
+  auto ror_acc = [&]() { zn(A = ror_value(A)); };
+  auto inx = [&]() { zn(++X); };
+  auto iny = [&]() { zn(++Y); };
+  auto dex = [&]() { zn(--X); };
+  auto dey = [&]() { zn(--Y); };
+  auto clc = [&]() { P &= ~C; };
+  auto cld = [&]() { P &= ~D; };
+  auto cli = [&]() { P &= ~I; };
+  auto clv = [&]() { P &= ~V; };
+  auto sec = [&]() { P |= C; };
+  auto sed = [&]() { P |= D; };
+  auto sei = [&]() { P |= I; };
+  auto brk = [&]() {
+    u16 pc_plus_two = PC + 1;
+    push(pc_plus_two >> 8);
+    push(pc_plus_two & 0xFF);
+    push(P | B | U);
+    P = (P & ~B) | I;
+    u16 lo = read(0xFFFE);
+    u16 hi = read(0xFFFF);
+    PC = (hi << 8) | lo;
+  };
+  auto rti = [&]() {
+    P = (pull() & ~B) | U;
+    u16 lo = pull();
+    u16 hi = pull();
+    PC = (hi << 8) | lo;
+  };
+  auto rts = [&]() {
+    u16 lo = pull();
+    u16 hi = pull();
+    PC = ((hi << 8) | lo) + 1;
+  };
+
+  int used = 0;
+  do {
+    u8 opcode = read(PC++);
+    P |= U;
+
+    switch (opcode) {
+      case 0x00: cycles = 7; brk(); break;
+      case 0x01: cycles = 6; ora(izx()); break;
+      case 0x02: cycles = 2; nop(); break;
+      case 0x03: cycles = 8; slo(izx()); break;
+      case 0x04: cycles = 3; nop_addr(zp()); break;
+      case 0x05: cycles = 3; ora(zp()); break;
+      case 0x06: cycles = 5; asl(zp()); break;
+      case 0x07: cycles = 5; slo(zp()); break;
+      case 0x08: cycles = 3; php(); break;
+      case 0x09: cycles = 2; ora(imm()); break;
+      case 0x0A: cycles = 2; asl_acc(); break;
+      case 0x0B: cycles = 2; anc(imm()); break;
+      case 0x0C: cycles = 4; nop_addr(ab()); break;
+      case 0x0D: cycles = 4; ora(ab()); break;
+      case 0x0E: cycles = 6; asl(ab()); break;
+      case 0x0F: cycles = 6; slo(ab()); break;
+      case 0x10: cycles = 2; branch(!(P & N)); break;
+      case 0x11: cycles = 5; ora(izy(true)); break;
+      case 0x12: cycles = 2; nop(); break;
+      case 0x13: cycles = 8; slo(izy(false)); break;
+      case 0x14: cycles = 4; nop_addr(zpx()); break;
+      case 0x15: cycles = 4; ora(zpx()); break;
+      case 0x16: cycles = 6; asl(zpx()); break;
+      case 0x17: cycles = 6; slo(zpx()); break;
+      case 0x18: cycles = 2; clc(); break;
+      case 0x19: cycles = 4; ora(aby(true)); break;
+      case 0x1A: cycles = 2; nop(); break;
+      case 0x1B: cycles = 7; slo(aby(false)); break;
+      case 0x1C: cycles = 4; nop_addr(abx(true)); break;
+      case 0x1D: cycles = 4; ora(abx(true)); break;
+      case 0x1E: cycles = 7; asl(abx(false)); break;
+      case 0x1F: cycles = 7; slo(abx(false)); break;
+      case 0x20: cycles = 6; jsr(ab()); break;
+      case 0x21: cycles = 6; and_(izx()); break;
+      case 0x22: cycles = 2; nop(); break;
+      case 0x23: cycles = 8; rla(izx()); break;
+      case 0x24: cycles = 3; bit(zp()); break;
+      case 0x25: cycles = 3; and_(zp()); break;
+      case 0x26: cycles = 5; rol(zp()); break;
+      case 0x27: cycles = 5; rla(zp()); break;
+      case 0x28: cycles = 4; plp(); break;
+      case 0x29: cycles = 2; and_(imm()); break;
+      case 0x2A: cycles = 2; rol_acc(); break;
+      case 0x2B: cycles = 2; anc(imm()); break;
+      case 0x2C: cycles = 4; bit(ab()); break;
+      case 0x2D: cycles = 4; and_(ab()); break;
+      case 0x2E: cycles = 6; rol(ab()); break;
+      case 0x2F: cycles = 6; rla(ab()); break;
+      case 0x30: cycles = 2; branch(P & N); break;
+      case 0x31: cycles = 5; and_(izy(true)); break;
+      case 0x32: cycles = 2; nop(); break;
+      case 0x33: cycles = 8; rla(izy(false)); break;
+      case 0x34: cycles = 4; nop_addr(zpx()); break;
+      case 0x35: cycles = 4; and_(zpx()); break;
+      case 0x36: cycles = 6; rol(zpx()); break;
+      case 0x37: cycles = 6; rla(zpx()); break;
+      case 0x38: cycles = 2; sec(); break;
+      case 0x39: cycles = 4; and_(aby(true)); break;
+      case 0x3A: cycles = 2; nop(); break;
+      case 0x3B: cycles = 7; rla(aby(false)); break;
+      case 0x3C: cycles = 4; nop_addr(abx(true)); break;
+      case 0x3D: cycles = 4; and_(abx(true)); break;
+      case 0x3E: cycles = 7; rol(abx(false)); break;
+      case 0x3F: cycles = 7; rla(abx(false)); break;
+      case 0x40: cycles = 6; rti(); break;
+      case 0x41: cycles = 6; eor(izx()); break;
+      case 0x42: cycles = 2; nop(); break;
+      case 0x43: cycles = 8; sre(izx()); break;
+      case 0x44: cycles = 3; nop_addr(zp()); break;
+      case 0x45: cycles = 3; eor(zp()); break;
+      case 0x46: cycles = 5; lsr(zp()); break;
+      case 0x47: cycles = 5; sre(zp()); break;
+      case 0x48: cycles = 3; pha(); break;
+      case 0x49: cycles = 2; eor(imm()); break;
+      case 0x4A: cycles = 2; lsr_acc(); break;
+      case 0x4B: cycles = 2; alr(imm()); break;
+      case 0x4C: cycles = 3; jmp(ab()); break;
+      case 0x4D: cycles = 4; eor(ab()); break;
+      case 0x4E: cycles = 6; lsr(ab()); break;
+      case 0x4F: cycles = 6; sre(ab()); break;
+      case 0x50: cycles = 2; branch(!(P & V)); break;
+      case 0x51: cycles = 5; eor(izy(true)); break;
+      case 0x52: cycles = 2; nop(); break;
+      case 0x53: cycles = 8; sre(izy(false)); break;
+      case 0x54: cycles = 4; nop_addr(zpx()); break;
+      case 0x55: cycles = 4; eor(zpx()); break;
+      case 0x56: cycles = 6; lsr(zpx()); break;
+      case 0x57: cycles = 6; sre(zpx()); break;
+      case 0x58: cycles = 2; cli(); break;
+      case 0x59: cycles = 4; eor(aby(true)); break;
+      case 0x5A: cycles = 2; nop(); break;
+      case 0x5B: cycles = 7; sre(aby(false)); break;
+      case 0x5C: cycles = 4; nop_addr(abx(true)); break;
+      case 0x5D: cycles = 4; eor(abx(true)); break;
+      case 0x5E: cycles = 7; lsr(abx(false)); break;
+      case 0x5F: cycles = 7; sre(abx(false)); break;
+      case 0x60: cycles = 6; rts(); break;
+      case 0x61: cycles = 6; adc(izx()); break;
+      case 0x62: cycles = 2; nop(); break;
+      case 0x63: cycles = 8; rra(izx()); break;
+      case 0x64: cycles = 3; nop_addr(zp()); break;
+      case 0x65: cycles = 3; adc(zp()); break;
+      case 0x66: cycles = 5; ror(zp()); break;
+      case 0x67: cycles = 5; rra(zp()); break;
+      case 0x68: cycles = 4; pla(); break;
+      case 0x69: cycles = 2; adc(imm()); break;
+      case 0x6A: cycles = 2; ror_acc(); break;
+      case 0x6B: cycles = 2; arr(imm()); break;
+      case 0x6C: cycles = 5; jmp(ind()); break;
+      case 0x6D: cycles = 4; adc(ab()); break;
+      case 0x6E: cycles = 6; ror(ab()); break;
+      case 0x6F: cycles = 6; rra(ab()); break;
+      case 0x70: cycles = 2; branch(P & V); break;
+      case 0x71: cycles = 5; adc(izy(true)); break;
+      case 0x72: cycles = 2; nop(); break;
+      case 0x73: cycles = 8; rra(izy(false)); break;
+      case 0x74: cycles = 4; nop_addr(zpx()); break;
+      case 0x75: cycles = 4; adc(zpx()); break;
+      case 0x76: cycles = 6; ror(zpx()); break;
+      case 0x77: cycles = 6; rra(zpx()); break;
+      case 0x78: cycles = 2; sei(); break;
+      case 0x79: cycles = 4; adc(aby(true)); break;
+      case 0x7A: cycles = 2; nop(); break;
+      case 0x7B: cycles = 7; rra(aby(false)); break;
+      case 0x7C: cycles = 4; nop_addr(abx(true)); break;
+      case 0x7D: cycles = 4; adc(abx(true)); break;
+      case 0x7E: cycles = 7; ror(abx(false)); break;
+      case 0x7F: cycles = 7; rra(abx(false)); break;
+      case 0x80: cycles = 2; nop_addr(imm()); break;
+      case 0x81: cycles = 6; sta(izx()); break;
+      case 0x82: cycles = 2; nop_addr(imm()); break;
+      case 0x83: cycles = 6; sax(izx()); break;
+      case 0x84: cycles = 3; sty(zp()); break;
+      case 0x85: cycles = 3; sta(zp()); break;
+      case 0x86: cycles = 3; stx(zp()); break;
+      case 0x87: cycles = 3; sax(zp()); break;
+      case 0x88: cycles = 2; dey(); break;
+      case 0x89: cycles = 2; nop_addr(imm()); break;
+      case 0x8A: cycles = 2; txa(); break;
+      case 0x8B: cycles = 2; nop_addr(imm()); break;
+      case 0x8C: cycles = 4; sty(ab()); break;
+      case 0x8D: cycles = 4; sta(ab()); break;
+      case 0x8E: cycles = 4; stx(ab()); break;
+      case 0x8F: cycles = 4; sax(ab()); break;
+      case 0x90: cycles = 2; branch(!(P & C)); break;
+      case 0x91: cycles = 6; sta(izy(false)); break;
+      case 0x92: cycles = 2; nop(); break;
+      case 0x93: cycles = 6; nop_addr(izy(false)); break;
+      case 0x94: cycles = 4; sty(zpx()); break;
+      case 0x95: cycles = 4; sta(zpx()); break;
+      case 0x96: cycles = 4; stx(zpy()); break;
+      case 0x97: cycles = 4; sax(zpy()); break;
+      case 0x98: cycles = 2; tya(); break;
+      case 0x99: cycles = 5; sta(aby(false)); break;
+      case 0x9A: cycles = 2; txs(); break;
+      case 0x9B: cycles = 5; nop_addr(aby(false)); break;
+      case 0x9C: cycles = 5; nop_addr(abx(false)); break;
+      case 0x9D: cycles = 5; sta(abx(false)); break;
+      case 0x9E: cycles = 5; nop_addr(aby(false)); break;
+      case 0x9F: cycles = 5; nop_addr(aby(false)); break;
+      case 0xA0: cycles = 2; ldy(imm()); break;
+      case 0xA1: cycles = 6; lda(izx()); break;
+      case 0xA2: cycles = 2; ldx(imm()); break;
+      case 0xA3: cycles = 6; lax(izx()); break;
+      case 0xA4: cycles = 3; ldy(zp()); break;
+      case 0xA5: cycles = 3; lda(zp()); break;
+      case 0xA6: cycles = 3; ldx(zp()); break;
+      case 0xA7: cycles = 3; lax(zp()); break;
+      case 0xA8: cycles = 2; tay(); break;
+      case 0xA9: cycles = 2; lda(imm()); break;
+      case 0xAA: cycles = 2; tax(); break;
+      case 0xAB: cycles = 2; lax(imm()); break;
+      case 0xAC: cycles = 4; ldy(ab()); break;
+      case 0xAD: cycles = 4; lda(ab()); break;
+      case 0xAE: cycles = 4; ldx(ab()); break;
+      case 0xAF: cycles = 4; lax(ab()); break;
+      case 0xB0: cycles = 2; branch(P & C); break;
+      case 0xB1: cycles = 5; lda(izy(true)); break;
+      case 0xB2: cycles = 2; nop(); break;
+      case 0xB3: cycles = 5; lax(izy(true)); break;
+      case 0xB4: cycles = 4; ldy(zpx()); break;
+      case 0xB5: cycles = 4; lda(zpx()); break;
+      case 0xB6: cycles = 4; ldx(zpy()); break;
+      case 0xB7: cycles = 4; lax(zpy()); break;
+      case 0xB8: cycles = 2; clv(); break;
+      case 0xB9: cycles = 4; lda(aby(true)); break;
+      case 0xBA: cycles = 2; tsx(); break;
+      case 0xBB: cycles = 4; las(aby(true)); break;
+      case 0xBC: cycles = 4; ldy(abx(true)); break;
+      case 0xBD: cycles = 4; lda(abx(true)); break;
+      case 0xBE: cycles = 4; ldx(aby(true)); break;
+      case 0xBF: cycles = 4; lax(aby(true)); break;
+      case 0xC0: cycles = 2; cpy(imm()); break;
+      case 0xC1: cycles = 6; cmp(izx()); break;
+      case 0xC2: cycles = 2; nop_addr(imm()); break;
+      case 0xC3: cycles = 8; dcp(izx()); break;
+      case 0xC4: cycles = 3; cpy(zp()); break;
+      case 0xC5: cycles = 3; cmp(zp()); break;
+      case 0xC6: cycles = 5; dec(zp()); break;
+      case 0xC7: cycles = 5; dcp(zp()); break;
+      case 0xC8: cycles = 2; iny(); break;
+      case 0xC9: cycles = 2; cmp(imm()); break;
+      case 0xCA: cycles = 2; dex(); break;
+      case 0xCB: cycles = 2; axs(imm()); break;
+      case 0xCC: cycles = 4; cpy(ab()); break;
+      case 0xCD: cycles = 4; cmp(ab()); break;
+      case 0xCE: cycles = 6; dec(ab()); break;
+      case 0xCF: cycles = 6; dcp(ab()); break;
+      case 0xD0: cycles = 2; branch(!(P & Z)); break;
+      case 0xD1: cycles = 5; cmp(izy(true)); break;
+      case 0xD2: cycles = 2; nop(); break;
+      case 0xD3: cycles = 8; dcp(izy(false)); break;
+      case 0xD4: cycles = 4; nop_addr(zpx()); break;
+      case 0xD5: cycles = 4; cmp(zpx()); break;
+      case 0xD6: cycles = 6; dec(zpx()); break;
+      case 0xD7: cycles = 6; dcp(zpx()); break;
+      case 0xD8: cycles = 2; cld(); break;
+      case 0xD9: cycles = 4; cmp(aby(true)); break;
+      case 0xDA: cycles = 2; nop(); break;
+      case 0xDB: cycles = 7; dcp(aby(false)); break;
+      case 0xDC: cycles = 4; nop_addr(abx(true)); break;
+      case 0xDD: cycles = 4; cmp(abx(true)); break;
+      case 0xDE: cycles = 7; dec(abx(false)); break;
+      case 0xDF: cycles = 7; dcp(abx(false)); break;
+      case 0xE0: cycles = 2; cpx(imm()); break;
+      case 0xE1: cycles = 6; sbc(izx()); break;
+      case 0xE2: cycles = 2; nop_addr(imm()); break;
+      case 0xE3: cycles = 8; isc(izx()); break;
+      case 0xE4: cycles = 3; cpx(zp()); break;
+      case 0xE5: cycles = 3; sbc(zp()); break;
+      case 0xE6: cycles = 5; inc(zp()); break;
+      case 0xE7: cycles = 5; isc(zp()); break;
+      case 0xE8: cycles = 2; inx(); break;
+      case 0xE9: cycles = 2; sbc(imm()); break;
+      case 0xEA: cycles = 2; nop(); break;
+      case 0xEB: cycles = 2; sbc(imm()); break;
+      case 0xEC: cycles = 4; cpx(ab()); break;
+      case 0xED: cycles = 4; sbc(ab()); break;
+      case 0xEE: cycles = 6; inc(ab()); break;
+      case 0xEF: cycles = 6; isc(ab()); break;
+      case 0xF0: cycles = 2; branch(P & Z); break;
+      case 0xF1: cycles = 5; sbc(izy(true)); break;
+      case 0xF2: cycles = 2; nop(); break;
+      case 0xF3: cycles = 8; isc(izy(false)); break;
+      case 0xF4: cycles = 4; nop_addr(zpx()); break;
+      case 0xF5: cycles = 4; sbc(zpx()); break;
+      case 0xF6: cycles = 6; inc(zpx()); break;
+      case 0xF7: cycles = 6; isc(zpx()); break;
+      case 0xF8: cycles = 2; sed(); break;
+      case 0xF9: cycles = 4; sbc(aby(true)); break;
+      case 0xFA: cycles = 2; nop(); break;
+      case 0xFB: cycles = 7; isc(aby(false)); break;
+      case 0xFC: cycles = 4; nop_addr(abx(true)); break;
+      case 0xFD: cycles = 4; sbc(abx(true)); break;
+      case 0xFE: cycles = 7; inc(abx(false)); break;
+      case 0xFF: cycles = 7; isc(abx(false)); break;
+    }
+    used += cycles;
+  } while (used < cycle_budget);
+
+  _A = A;
+  _X = X;
+  _Y = Y;
+  _SP = SP;
+  _status = P;
+  _PC = PC;
+  _cycles = cycles;
+  return used;
 }
 
 void CPU::reset() {
@@ -347,6 +922,17 @@ void CPU::reset() {
   _page_crossed = false;
 }
 
+void CPU::io_state(StateIO& s) {
+  s.field(_A);
+  s.field(_X);
+  s.field(_Y);
+  s.field(_SP);
+  s.field(_status);
+  s.field(_PC);
+  s.field(_cycles);
+  s.field(_page_crossed);
+}
+
 // Memory operations
 u8 CPU::read_byte(const u16 address) { return _bus.cpu_read(address); }
 
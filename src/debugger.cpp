@@ -214,11 +214,7 @@ void Debugger::step() {
   // Check if current instruction is BRK (0x00)
   u8 opcode = _bus.cpu_read(current_pc);
 
-  do {
-    _cpu.clock();
-    _cycle_count++;
-  } while (_cpu.get_remaining_cycles() > 0);
-
+  _cycle_count += _cpu.step_instruction();
   _instruction_count++;
 
   // Stop if we executed a BRK instruction
@@ -239,24 +235,21 @@ void Debugger::run() { _running = true; }
 int Debugger::run_frame() {
   const u32 start_frame = _bus.get_ppu().frame_count();
 
-  // Execute whole instructions, clocking the PPU via the Bus, until the PPU
-  // finishes a frame, a breakpoint is hit, or a BRK executes.
+  // Execute whole instructions through the Bus until the PPU finishes a
+  // frame, a breakpoint is hit, or a BRK executes. The Bus may let the PPU/APU
+  // lag behind the CPU while stepping, so catch them up before returning.
   while (true) {
     u16 current_pc = _cpu.get_pc();
     u8 opcode = _bus.cpu_read(current_pc);
 
-    // Execute exactly one instruction by clocking the Bus until the CPU's
-    // remaining cycles drain (matches step()'s instruction granularity, but
-    // through the Bus so the PPU is clocked 3x per CPU cycle).
-    do {
-      _bus.clock();
-      _cycle_count++;
-    } while (_cpu.get_remaining_cycles() > 0);
-
+    // Exactly one instruction (matches step()'s granularity), with the PPU
+    // advanced 3 dots per CPU cycle.
+    _cycle_count += _bus.step();
     _instruction_count++;
 
     // BRK -> stop, reason 2 (preserve Phase 0 BRK behavior).
     if (opcode == 0x00) {
+      _bus.sync();
       stop();
 #ifdef __EMSCRIPTEN__
       EM_ASM({ window.dispatchEvent(new CustomEvent('nes-brk-encountered')); });
@@ -266,12 +259,14 @@ int Debugger::run_frame() {
 
     // Breakpoint at the new PC -> stop, reason 1.
     if (has_breakpoint(_cpu.get_pc())) {
+      _bus.sync();
       stop();
       return 1;
     }
 
     // Frame finished -> reason 0.
     if (_bus.get_ppu().frame_count() != start_frame) {
+      _bus.sync();
       return 0;
     }
   }
@@ -341,6 +336,8 @@ std::vector<u8> Debugger::get_stack() const {
 
 u64 Debugger::get_instruction_count() const { return _instruction_count; }
 u64 Debugger::get_cycle_count() const { return _cycle_count; }
+u64 Debugger::get_lines_reused() const { return _bus.get_ppu().lines_reused(); }
+u64 Debugger::get_lines_drawn() const { return _bus.get_ppu().lines_drawn(); }
 
 // Get the number of bytes for a specific opcode
 u8 Debugger::get_instruction_bytes(u8 opcode) const {
@@ -710,6 +707,20 @@ EMSCRIPTEN_EXPORT u64 debugger_get_cycle_count() {
   return 0;
 }
 
+EMSCRIPTEN_EXPORT u64 debugger_get_lines_reused() {
+  if (g_debugger) {
+    return g_debugger->get_lines_reused();
+  }
+  return 0;
+}
+
+EMSCRIPTEN_EXPORT u64 debugger_get_lines_drawn() {
+  if (g_debugger) {
+    return g_debugger->get_lines_drawn();
+  }
+  return 0;
+}
+
 EMSCRIPTEN_EXPORT void debugger_set_pc(u16 address) {
   if (g_debugger) {
     g_debugger->set_pc(address);
@@ -0,0 +1,150 @@
+#include "deferred_renderer.h"
+#include <chrono>
+#include <cstring>
+
+// Emscripten builds without -pthread can't start threads; there the frame
+// is drawn in submit() instead.
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define NES_RENDER_THREADS 0
+#else
+#define NES_RENDER_THREADS 1
+#endif
+
+namespace nes {
+namespace {
+template <typename Pred>
+void wait_for(std::condition_variable& cv, std::unique_lock<std::mutex>& lock, Pred ready) {
+#if NES_TIMED_CV_WAIT
+  // The runtime's libstdc++ predates wait() (see CMakeLists.txt); the timed
+  // wait is header-only.
+  while (!ready()) cv.wait_for(lock, std::chrono::milliseconds(100));
+#else
+  cv.wait(lock, ready);
+#endif
+}
+
+// The next reusable slot of a snapshot list.
+template <typename T>
+T& next_slot(std::deque<T>& slots, size_t& used) {
+  if (used == slots.size()) slots.emplace_back();
+  return slots[used++];
+}
+}  // namespace
+
+DeferredRenderer::DeferredRenderer(u32 threads) : _threads(threads ? threads : 1) {
+#if NES_RENDER_THREADS
+  for (u32 part = 0; part < _threads; part++) _workers.emplace_back(&DeferredRenderer::worker, this, part);
+#endif
+}
+
+DeferredRenderer::~DeferredRenderer() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stop = true;
+  }
+  _wake.notify_all();
+  for (std::thread& t : _workers) t.join();
+}
+
+bool DeferredRenderer::record(u16 line, const ScanlineState& s, const Versions& versions, bool chr_ram) {
+  Frame& f = *_recording;
+  const bool first = line == 0;
+  if (first) {
+    _open = true;
+    f.vram_used = f.oam_used = f.chr_used = 0;
+  } else if (!_open) {
+    return false;
+  }
+  ScanlineState& out = f.lines[line];
+  out = s;
+
+  bool vram_moved = first || versions.vram != _seen.vram || s.palette != _seen_pages[4];
+  for (int i = 0; i < 4; i++) vram_moved |= s.nametables[i] != _seen_pages[i];
+  if (vram_moved) {
+    auto& copy = next_slot(f.vram, f.vram_used);
+    for (int i = 0; i < 4; i++) {
+      std::memcpy(copy.data() + i * 1024, s.nametables[i], 1024);
+      _seen_pages[i] = s.nametables[i];
+    }
+    std::memcpy(copy.data() + 4 * 1024, s.palette, 32);
+    _seen_pages[4] = s.palette;
+  }
+  const u8* vram = f.vram[f.vram_used - 1].data();
+  for (int i = 0; i < 4; i++) out.nametables[i] = vram + i * 1024;
+  out.palette = vram + 4 * 1024;
+
+  if (first || versions.oam != _seen.oam || s.oam != _seen_oam) {
+    std::memcpy(next_slot(f.oam, f.oam_used).data(), s.oam, 256);
+    _seen_oam = s.oam;
+  }
+  out.oam = f.oam[f.oam_used - 1].data();
+
+  // CHR-ROM (and its decoded cache) never changes under us; CHR-RAM does.
+  if (chr_ram && s.chr.bytes) {
+    if (first || versions.chr != _seen.chr || s.chr.bytes != _seen_chr) {
+      next_slot(f.chr, f.chr_used).assign(s.chr.bytes, s.chr.bytes + s.chr.size);
+      _seen_chr = s.chr.bytes;
+    }
+    out.chr.bytes = f.chr[f.chr_used - 1].data();
+    out.chr.cache = nullptr;
+  }
+  _seen = versions;
+  return true;
+}
+
+void DeferredRenderer::submit() {
+  wait();
+  std::swap(_recording, _drawing);
+  _open = false;
+  _pending = true;
+  if (_workers.empty()) {
+    rasterize(*_drawing, 0);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _job++;
+    _busy = _threads;
+  }
+  _wake.notify_all();
+}
+
+void DeferredRenderer::cancel() { _open = false; }
+
+bool DeferredRenderer::collect(u8* out) {
+  if (!_pending) return false;
+  wait();
+  std::memcpy(out, _pixels.data(), _pixels.size());
+  _pending = false;
+  return true;
+}
+
+void DeferredRenderer::rasterize(const Frame& frame, u32 part) {
+  const u32 parts = _workers.empty() ? 1 : _threads;
+  const u16 first = static_cast<u16>(240 * part / parts);
+  const u16 last = static_cast<u16>(240 * (part + 1) / parts);
+  for (u16 line = first; line < last; line++) draw_scanline(frame.lines[line], line, &_pixels[line * 256]);
+}
+
+void DeferredRenderer::worker(u32 part) {
+  u64 seen = 0;
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (true) {
+    wait_for(_wake, lock, [&] { return _stop || _job != seen; });
+    if (_stop) return;
+    seen = _job;
+    const Frame* frame = _drawing;
+    lock.unlock();
+    rasterize(*frame, part);
+    lock.lock();
+    if (--_busy == 0) _done.notify_all();
+  }
+}
+
+void DeferredRenderer::wait() {
+  if (_workers.empty()) return;
+  std::unique_lock<std::mutex> lock(_mutex);
+  wait_for(_done, lock, [&] { return _busy == 0; });
+}
+
+}  // namespace nes
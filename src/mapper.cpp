@@ -5,4 +5,9 @@ Mapper::Mapper(u8 prg_banks, u8 chr_banks) {
   _prg_banks = prg_banks;
   _chr_banks = chr_banks;
 }
+
+void Mapper::io_state(StateIO& s) {
+  s.field(_prg_map);
+  s.field(_chr_map);
+}
 };  // namespace nes
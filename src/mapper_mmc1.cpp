@@ -2,31 +2,32 @@
 
 namespace nes {
 MapperMMC1::MapperMMC1(u8 prg_banks, u8 chr_banks)
-  : Mapper(prg_banks, chr_banks) {}
+  : Mapper(prg_banks, chr_banks) {
+  _board = Board::MMC1;
+  update_banks();
+}
 
-bool MapperMMC1::cpu_read(u16 address, u32& mapped) const {
-  if (address < 0x8000) return false;
+void MapperMMC1::update_banks() {
   const u8 prg_mode = (_control >> 2) & 0x03;
   if (prg_mode == 0 || prg_mode == 1) {
     // 32KB switch (low bit of the bank register ignored).
-    const u32 bank = (_prg & 0x0E) >> 1;
-    mapped = bank * 0x8000u + (address & 0x7FFF);
+    map_prg_32k(((_prg & 0x0E) >> 1) * 0x8000u);
   } else if (prg_mode == 2) {
     // Fix first bank at $8000, switch 16KB at $C000.
-    if (address < 0xC000) {
-      mapped = address & 0x3FFF;
-    } else {
-      mapped = (_prg & 0x0F) * 0x4000u + (address & 0x3FFF);
-    }
+    map_prg_16k(0, 0);
+    map_prg_16k(1, (_prg & 0x0F) * 0x4000u);
   } else {  // prg_mode == 3
     // Switch 16KB at $8000, fix last bank at $C000.
-    if (address < 0xC000) {
-      mapped = (_prg & 0x0F) * 0x4000u + (address & 0x3FFF);
-    } else {
-      mapped = (_prg_banks - 1) * 0x4000u + (address & 0x3FFF);
-    }
+    map_prg_16k(0, (_prg & 0x0F) * 0x4000u);
+    map_prg_16k(1, (_prg_banks - 1) * 0x4000u);
+  }
+
+  if (_control & 0x10) {  // 4KB CHR banks
+    map_chr_4k(0, _chr0 * 0x1000u);
+    map_chr_4k(1, _chr1 * 0x1000u);
+  } else {  // 8KB CHR bank (low bit ignored)
+    map_chr_8k((_chr0 & 0x1E) * 0x1000u);
   }
-  return true;
 }
 
 bool MapperMMC1::cpu_write(u16 address, u8 value, u32& /*mapped*/) {
@@ -36,6 +37,7 @@ bool MapperMMC1::cpu_write(u16 address, u8 value, u32& /*mapped*/) {
     // Reset: clear the shift register and lock PRG mode 3.
     _shift = 0x10;
     _control |= 0x0C;
+    update_banks();
     return false;
   }
 
@@ -51,35 +53,21 @@ bool MapperMMC1::cpu_write(u16 address, u8 value, u32& /*mapped*/) {
     default: _prg = reg; break;      // $E000-$FFFF
   }
   _shift = 0x10;  // reset for the next 5-write sequence
+  update_banks();
   return false;
 }
 
-bool MapperMMC1::ppu_read(u16 address, u32& mapped) const {
-  if (address > 0x1FFF) return false;
-  if (_control & 0x10) {  // 4KB CHR banks
-    if (address < 0x1000) {
-      mapped = _chr0 * 0x1000u + (address & 0x0FFF);
-    } else {
-      mapped = _chr1 * 0x1000u + (address & 0x0FFF);
-    }
-  } else {  // 8KB CHR bank (low bit ignored)
-    mapped = (_chr0 & 0x1E) * 0x1000u + (address & 0x1FFF);
-  }
-  return true;
-}
-
 bool MapperMMC1::ppu_write(u16 address, u32& mapped) {
   // CHR-RAM uses the same banked mapping for writes.
   return ppu_read(address, mapped);
 }
 
-int MapperMMC1::mirror() const {
-  // MMC1 control bits 0-1: 0 single-lo, 1 single-hi, 2 vertical, 3 horizontal.
-  switch (_control & 0x03) {
-    case 0: return 2;  // single-screen low
-    case 1: return 3;  // single-screen high
-    case 2: return 1;  // vertical
-    default: return 0; // horizontal
-  }
+void MapperMMC1::io_state(StateIO& s) {
+  Mapper::io_state(s);
+  s.field(_shift);
+  s.field(_control);
+  s.field(_chr0);
+  s.field(_chr1);
+  s.field(_prg);
 }
 }  // namespace nes
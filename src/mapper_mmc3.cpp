@@ -2,27 +2,35 @@
 
 namespace nes {
 MapperMMC3::MapperMMC3(u8 prg_banks, u8 chr_banks)
-  : Mapper(prg_banks, chr_banks) {}
+  : Mapper(prg_banks, chr_banks) {
+  _board = Board::MMC3;
+  update_banks();
+}
 
-bool MapperMMC3::cpu_read(u16 address, u32& mapped) const {
-  if (address < 0x8000) return false;
+void MapperMMC3::update_banks() {
   const int total_8k = _prg_banks * 2;  // 8KB PRG bank count
   const int last = total_8k - 1;
   const int second_last = total_8k - 2;
-  const int region = (address - 0x8000) / 0x2000;  // 0..3
   const bool prg_mode = (_bank_select & 0x40) != 0;
+  // $8000 swappable, $C000 fixed to second-last; or the other way round.
+  const int normal_prg[4] = {_regs[6], _regs[7], second_last, last};
+  const int swapped_prg[4] = {second_last, _regs[7], _regs[6], last};
+  for (int region = 0; region < 4; region++) {
+    const int bank = (prg_mode ? swapped_prg : normal_prg)[region] % (total_8k > 0 ? total_8k : 1);
+    map_prg_8k(region, static_cast<u32>(bank) * 0x2000u);
+  }
 
-  int bank;
-  if (!prg_mode) {  // $8000 swappable, $C000 fixed to second-last
-    const int map[4] = {_regs[6], _regs[7], second_last, last};
-    bank = map[region];
-  } else {  // $C000 swappable, $8000 fixed to second-last
-    const int map[4] = {second_last, _regs[7], _regs[6], last};
-    bank = map[region];
+  const bool inv = (_bank_select & 0x80) != 0;  // CHR A12 inversion
+  const u8 r0 = _regs[0] & 0xFE, r1 = _regs[1] & 0xFE;
+  // region order without inversion: [R0,R0+1, R1,R1+1, R2,R3,R4,R5]
+  const int normal[8] = {r0, r0 + 1, r1, r1 + 1,
+                         _regs[2], _regs[3], _regs[4], _regs[5]};
+  // with inversion the 1KB banks move to $0000 and the 2KB banks to $1000.
+  const int inverted[8] = {_regs[2], _regs[3], _regs[4], _regs[5],
+                           r0, r0 + 1, r1, r1 + 1};
+  for (int region = 0; region < 8; region++) {
+    map_chr_1k(region, static_cast<u32>((inv ? inverted : normal)[region]) * 0x0400u);
   }
-  bank %= (total_8k > 0 ? total_8k : 1);
-  mapped = static_cast<u32>(bank) * 0x2000u + (address & 0x1FFF);
-  return true;
 }
 
 bool MapperMMC3::cpu_write(u16 address, u8 value, u32& /*mapped*/) {
@@ -34,6 +42,7 @@ bool MapperMMC3::cpu_write(u16 address, u8 value, u32& /*mapped*/) {
     } else {
       _regs[_bank_select & 0x07] = value;  // bank data
     }
+    update_banks();
   } else if (address <= 0xBFFF) {
     if (!odd) {
       _mirror = value & 0x01;  // 0 vertical, 1 horizontal
@@ -57,44 +66,28 @@ bool MapperMMC3::cpu_write(u16 address, u8 value, u32& /*mapped*/) {
   return false;
 }
 
-u32 MapperMMC3::chr_bank_1k(int region) const {
-  const bool inv = (_bank_select & 0x80) != 0;  // CHR A12 inversion
-  const u8 r0 = _regs[0] & 0xFE, r1 = _regs[1] & 0xFE;
-  // region order without inversion: [R0,R0+1, R1,R1+1, R2,R3,R4,R5]
-  const int normal[8] = {r0, r0 + 1, r1, r1 + 1,
-                         _regs[2], _regs[3], _regs[4], _regs[5]};
-  // with inversion the 1KB banks move to $0000 and the 2KB banks to $1000.
-  const int inverted[8] = {_regs[2], _regs[3], _regs[4], _regs[5],
-                           r0, r0 + 1, r1, r1 + 1};
-  return static_cast<u32>((inv ? inverted : normal)[region]);
-}
-
-bool MapperMMC3::ppu_read(u16 address, u32& mapped) const {
-  if (address > 0x1FFF) return false;
-  const int region = address / 0x0400;  // 1KB region 0..7
-  mapped = chr_bank_1k(region) * 0x0400u + (address & 0x03FF);
-  return true;
-}
-
 bool MapperMMC3::ppu_write(u16 address, u32& mapped) {
   // CHR-RAM carts reuse the banked mapping for writes.
   return ppu_read(address, mapped);
 }
 
-int MapperMMC3::mirror() const {
-  return _mirror == 0 ? 1 /*vertical*/ : 0 /*horizontal*/;
+int MapperMMC3::scanlines_until_irq() const {
+  if (!_irq_enabled) return 0;
+  // A reload pulse loads the latch (firing at once if it is 0), then each
+  // pulse counts down; a running counter fires when it reaches 0.
+  if (_irq_counter == 0 || _irq_reload) return _irq_latch + 1;
+  return _irq_counter;
 }
 
-void MapperMMC3::scanline() {
-  if (_irq_counter == 0 || _irq_reload) {
-    _irq_counter = _irq_latch;
-    _irq_reload = false;
-  } else {
-    _irq_counter--;
-  }
-  if (_irq_counter == 0 && _irq_enabled) _irq_pending = true;
+void MapperMMC3::io_state(StateIO& s) {
+  Mapper::io_state(s);
+  s.field(_bank_select);
+  s.field(_regs);
+  s.field(_mirror);
+  s.field(_irq_latch);
+  s.field(_irq_counter);
+  s.field(_irq_reload);
+  s.field(_irq_enabled);
+  s.field(_irq_pending);
 }
-
-bool MapperMMC3::irq_pending() const { return _irq_pending; }
-void MapperMMC3::irq_clear() { _irq_pending = false; }
 }  // namespace nes
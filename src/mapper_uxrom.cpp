@@ -2,27 +2,23 @@
 
 namespace nes {
 MapperUxROM::MapperUxROM(u8 prg_banks, u8 chr_banks)
-  : Mapper(prg_banks, chr_banks) {}
-
-bool MapperUxROM::cpu_read(u16 address, u32& mapped) const {
-  if (address < 0x8000) return false;
-  if (address < 0xC000) {
-    mapped = _bank * 0x4000u + (address & 0x3FFF);  // switchable low bank
-  } else {
-    mapped = (_prg_banks - 1) * 0x4000u + (address & 0x3FFF);  // fixed last bank
-  }
-  return true;
+  : Mapper(prg_banks, chr_banks) {
+  _board = Board::UXROM;
+  map_chr_8k(0);  // 8KB CHR-RAM, unbanked
+  update_banks();
 }
 
 bool MapperUxROM::cpu_write(u16 address, u8 value, u32& /*mapped*/) {
-  if (address >= 0x8000) _bank = value & 0x0F;  // bank select (low nibble)
+  if (address >= 0x8000) {
+    _bank = value & 0x0F;  // bank select (low nibble)
+    update_banks();
+  }
   return false;
 }
 
-bool MapperUxROM::ppu_read(u16 address, u32& mapped) const {
-  if (address > 0x1FFF) return false;
-  mapped = address;  // 8KB CHR-RAM, unbanked
-  return true;
+void MapperUxROM::update_banks() {
+  map_prg_16k(0, _bank * 0x4000u);             // switchable low bank
+  map_prg_16k(1, (_prg_banks - 1) * 0x4000u);  // fixed last bank
 }
 
 bool MapperUxROM::ppu_write(u16 address, u32& mapped) {
@@ -30,4 +26,9 @@ bool MapperUxROM::ppu_write(u16 address, u32& mapped) {
   mapped = address;
   return true;
 }
+
+void MapperUxROM::io_state(StateIO& s) {
+  Mapper::io_state(s);
+  s.field(_bank);
+}
 }  // namespace nes
@@ -2,22 +2,12 @@
 
 namespace nes {
 MapperZero::MapperZero(u8 prg_banks, u8 chr_banks)
-  : Mapper(prg_banks, chr_banks) {}
-
-bool MapperZero::cpu_read(u16 address, u32& mapped) const {
-  if (address >= 0x8000 && address <= 0xFFFF) {
-    mapped = address & (_prg_banks > 1 ? 0x7FFF : 0x3FFF);
-    return true;
-  }
-  return false;
-}
-
-bool MapperZero::ppu_read(u16 address, u32& mapped) const {
-  if (address <= 0x1FFF) {
-    mapped = address;
-    return true;
-  }
-  return false;
+  : Mapper(prg_banks, chr_banks) {
+  _board = Board::NROM;
+  // 32KB PRG, or a 16KB bank mirrored at $C000; 8KB CHR. Nothing switches.
+  map_prg_16k(0, 0x0000);
+  map_prg_16k(1, _prg_banks > 1 ? 0x4000 : 0x0000);
+  map_chr_8k(0);
 }
 
 bool MapperZero::cpu_write(u16 /*address*/, u8 /*value*/, u32& /*mapped*/) {
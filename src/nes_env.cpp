@@ -8,6 +8,8 @@
 #include "bus.h"
 #include "cartridge.h"
 #include "debugger.h"
+#include "palette.h"
+#include "rewind.h"
 
 // One handle = one independent machine. Bus is declared first so the Debugger's
 // references into it are valid, and the whole thing lives on the heap so those
@@ -16,8 +18,13 @@ struct NesEnv {
   nes::Bus bus;
   nes::Debugger dbg;
   std::shared_ptr<nes::Cartridge> cart;
-  std::vector<uint8_t> rom;
-  NesEnv() : bus(), dbg(bus.get_cpu(), bus) {}
+  // Both immutable once loaded, so clones share them.
+  std::shared_ptr<const std::vector<uint8_t>> rom;
+  std::shared_ptr<const std::vector<uint8_t>> power_on;  // snapshot taken by nes_load; nes_reset restores it
+  std::vector<uint8_t> scratch;  // nes_copy_into's snapshot of the source
+  std::unique_ptr<nes::Rewind> rewind;  // null until nes_rewind_enable
+  // Audio is off until nes_set_audio_output; till then the APU only keeps $4015 state.
+  NesEnv() : bus(), dbg(bus.get_cpu(), bus) { bus.get_apu().set_synthesis(false); }
 };
 
 extern "C" {
@@ -35,13 +42,22 @@ NES_API void nes_destroy(NesEnv* e) { delete e; }
 NES_API int nes_load(NesEnv* e, const uint8_t* rom, int len) {
   if (!e || !rom || len <= 0) return 1;
   try {
-    e->rom.assign(rom, rom + len);
+    e->power_on.reset();
+    auto image = std::make_shared<const std::vector<uint8_t>>(rom, rom + len);
+    e->rom = image;
     int status = 0;
-    e->cart = nes::Cartridge::from_ines(e->rom, status);
+    e->cart = nes::Cartridge::from_ines(*image, status);
     if (status != 0) return status;
     e->bus.insert_cartridge(e->cart);
     e->bus.reset();
     e->dbg.reset_to_vector();
+    auto power_on = std::make_shared<std::vector<uint8_t>>(e->bus.state_size());
+    e->bus.save_state(power_on->data());
+    e->power_on = std::move(power_on);
+    if (e->rewind) {
+      e->rewind->clear();
+      e->rewind->push(e->bus);
+    }
     return 0;
   } catch (...) {
     return 1;
@@ -49,12 +65,16 @@ NES_API int nes_load(NesEnv* e, const uint8_t* rom, int len) {
 }
 
 NES_API void nes_reset(NesEnv* e) {
-  if (!e || e->rom.empty()) return;
+  if (!e || !e->rom) return;
   try {
+    // The power-on snapshot covers PRG-RAM, CHR-RAM and mapper banks too, so
+    // this is a memcpy rather than a new cartridge.
+    e->dbg.reset();  // instruction/cycle counters; the CPU comes from the snapshot
+    if (e->power_on && e->bus.load_state(e->power_on->data(), e->power_on->size())) return;
     // Rebuild the cartridge so PRG-RAM, CHR-RAM, and mapper bank state start
     // clean; bus.reset() clears the CPU/PPU/APU/controllers.
     int status = 0;
-    e->cart = nes::Cartridge::from_ines(e->rom, status);
+    e->cart = nes::Cartridge::from_ines(*e->rom, status);
     if (status != 0) return;
     e->bus.insert_cartridge(e->cart);
     e->bus.reset();
@@ -67,7 +87,9 @@ NES_API int nes_step(NesEnv* e, uint8_t p1_buttons) {
   if (!e) return -1;
   try {
     e->bus.set_controller(0, p1_buttons);
-    return e->dbg.run_frame();
+    const int reason = e->dbg.run_frame();
+    if (e->rewind) e->rewind->push(e->bus);
+    return reason;
   } catch (...) {
     return -1;
   }
@@ -78,6 +100,16 @@ NES_API void nes_set_controller(NesEnv* e, int port, uint8_t buttons) {
   e->bus.set_controller(port, buttons);
 }
 
+NES_API void nes_set_render_interval(NesEnv* e, int every_n) {
+  if (!e || every_n < 0) return;
+  e->bus.get_ppu().set_render_interval(static_cast<uint32_t>(every_n));
+}
+
+NES_API void nes_set_render_threads(NesEnv* e, int threads) {
+  if (!e || threads < 0) return;
+  e->bus.get_ppu().set_render_threads(static_cast<uint32_t>(threads));
+}
+
 NES_API const uint8_t* nes_framebuffer(NesEnv* e) {
   if (!e) return nullptr;
   return reinterpret_cast<const uint8_t*>(e->bus.get_ppu().framebuffer());
@@ -88,6 +120,138 @@ NES_API int nes_framebuffer_size(NesEnv* e) {
   return 256 * 240 * 4;
 }
 
+NES_API const uint8_t* nes_framebuffer_indices(NesEnv* e) {
+  if (!e) return nullptr;
+  return e->bus.get_ppu().pixels();
+}
+
+NES_API int nes_framebuffer_convert(NesEnv* e, int format, uint8_t* out) {
+  if (!e || !out) return 0;
+  nes::PixelFormat f;
+  switch (format) {
+    case NES_FORMAT_RGBA: f = nes::PixelFormat::RGBA; break;
+    case NES_FORMAT_BGRA: f = nes::PixelFormat::BGRA; break;
+    case NES_FORMAT_RGB24: f = nes::PixelFormat::RGB24; break;
+    default: return 0;
+  }
+  nes::convert_pixels(e->bus.get_ppu().pixels(), 256 * 240, f, out);
+  return 256 * 240 * nes::pixel_format_bytes(f);
+}
+
+NES_API int nes_state_size(NesEnv* e) {
+  if (!e || !e->cart) return 0;
+  return static_cast<int>(e->bus.state_size());
+}
+
+NES_API int nes_save_state(NesEnv* e, uint8_t* buf, int len) {
+  if (!e || !e->cart || !buf || len < nes_state_size(e)) return 1;
+  try {
+    e->bus.save_state(buf);
+    return 0;
+  } catch (...) {
+    return 1;
+  }
+}
+
+NES_API int nes_load_state(NesEnv* e, const uint8_t* buf, int len) {
+  if (!e || !e->cart || !buf || len <= 0) return 1;
+  try {
+    return e->bus.load_state(buf, static_cast<size_t>(len)) ? 0 : 1;
+  } catch (...) {
+    return 1;
+  }
+}
+
+NES_API int nes_copy_into(NesEnv* dst, NesEnv* src) {
+  if (!dst || !src || !src->cart) return 1;
+  if (dst == src) return 0;
+  try {
+    // A different game (or none) in dst: give it a clone of src's cartridge,
+    // which shares the ROM. Otherwise the snapshot below covers everything.
+    if (dst->rom != src->rom && (!dst->rom || *dst->rom != *src->rom)) {
+      dst->cart = nes::Cartridge::clone(src->cart);
+      dst->bus.insert_cartridge(dst->cart);
+    }
+    dst->rom = src->rom;
+    dst->power_on = src->power_on;
+    dst->scratch.resize(src->bus.state_size());
+    src->bus.save_state(dst->scratch.data());
+    if (!dst->bus.load_state(dst->scratch.data(), dst->scratch.size())) return 1;
+    // dst's history is of another run (maybe another game): start it afresh.
+    if (dst->rewind) {
+      dst->rewind->clear();
+      dst->rewind->push(dst->bus);
+    }
+    return 0;
+  } catch (...) {
+    return 1;
+  }
+}
+
+NES_API NesEnv* nes_clone(NesEnv* src) {
+  if (!src || !src->cart) return nullptr;
+  NesEnv* e = nes_create();
+  if (!e) return nullptr;
+  e->bus.get_ppu().set_render_interval(src->bus.get_ppu().render_interval());
+  if (nes_copy_into(e, src) != 0) {
+    nes_destroy(e);
+    return nullptr;
+  }
+  return e;
+}
+
+NES_API int nes_rewind_enable(NesEnv* e, int budget_bytes, int keyframe_interval) {
+  if (!e || budget_bytes < 0 || keyframe_interval < 0) return 1;
+  try {
+    e->rewind.reset();
+    if (budget_bytes == 0) return 0;
+    e->rewind = std::make_unique<nes::Rewind>(static_cast<size_t>(budget_bytes),
+                                              static_cast<uint32_t>(keyframe_interval));
+    if (e->cart) e->rewind->push(e->bus);
+    return 0;
+  } catch (...) {
+    e->rewind.reset();
+    return 1;
+  }
+}
+
+NES_API int nes_rewind(NesEnv* e, int frames) {
+  if (!e || !e->rewind || frames < 0) return -1;
+  try {
+    return e->rewind->rewind(e->bus, static_cast<uint32_t>(frames));
+  } catch (...) {
+    return -1;
+  }
+}
+
+NES_API int nes_rewind_depth(NesEnv* e) {
+  if (!e || !e->rewind) return 0;
+  return static_cast<int>(e->rewind->depth());
+}
+
+NES_API int nes_set_audio_output(NesEnv* e, int sample_rate, int capacity) {
+  if (!e || capacity <= 0) return 1;
+  if (sample_rate != 0 && (sample_rate < 8000 || sample_rate > 96000)) return 1;
+  try {
+    nes::APU& apu = e->bus.get_apu();
+    if (sample_rate != 0) apu.set_output(static_cast<uint32_t>(sample_rate), static_cast<uint32_t>(capacity));
+    apu.set_synthesis(sample_rate != 0);
+    return 0;
+  } catch (...) {
+    return 1;
+  }
+}
+
+NES_API int nes_audio_drain(NesEnv* e, float* out, int max) {
+  if (!e || !out || max <= 0) return 0;
+  return static_cast<int>(e->bus.audio_queue().pop(out, static_cast<uint32_t>(max)));
+}
+
+NES_API int nes_audio_available(NesEnv* e) { return e ? static_cast<int>(e->bus.audio_queue().size()) : 0; }
+NES_API int nes_audio_capacity(NesEnv* e) { return e ? static_cast<int>(e->bus.audio_queue().capacity()) : 0; }
+NES_API uint64_t nes_audio_overruns(NesEnv* e) { return e ? e->bus.audio_queue().overruns() : 0; }
+NES_API uint64_t nes_audio_underruns(NesEnv* e) { return e ? e->bus.audio_queue().underruns() : 0; }
+
 NES_API void nes_get_ram(NesEnv* e, uint8_t* out_2048) {
   if (!e || !out_2048) return;
   for (int i = 0; i < 0x0800; i++) {
@@ -1,4 +1,6 @@
 #include "palette.h"
+#include <cstring>
+#include "compose.h"
 
 namespace nes {
 
@@ -41,4 +43,45 @@ const u32 NES_PALETTE[64] = {
 
 u32 palette_rgba(u8 index) { return NES_PALETTE[index & 0x3F]; }
 
+namespace {
+// NES_PALETTE in a 4-byte layout, indexable by any u8 (BLANK_PIXEL and the
+// unused values above it are zero) so the gather never needs a mask.
+struct PixelTable {
+  u32 entries[256] = {};
+  explicit PixelTable(bool bgra) {
+    for (int i = 0; i < 64; i++) {
+      const u32 c = NES_PALETTE[i];
+      entries[i] = bgra ? (c & 0xFF00FF00u) | ((c & 0xFF) << 16) | ((c >> 16) & 0xFF) : c;
+    }
+  }
+};
+}  // namespace
+
+const u32* pixel_table(PixelFormat format) {
+  static const PixelTable rgba(false);
+  static const PixelTable bgra(true);
+  return (format == PixelFormat::BGRA ? bgra : rgba).entries;
+}
+
+void convert_pixels(const u8* indices, int count, PixelFormat format, u8* out) {
+  const u32* table = pixel_table(format);
+  if (format == PixelFormat::RGB24) {
+    for (int i = 0; i < count; i++) {
+      const u32 c = table[indices[i]];
+      out[i * 3 + 0] = static_cast<u8>(c);
+      out[i * 3 + 1] = static_cast<u8>(c >> 8);
+      out[i * 3 + 2] = static_cast<u8>(c >> 16);
+    }
+    return;
+  }
+  // `out` is any byte buffer, so expand a chunk at a time into a u32 one.
+  constexpr int CHUNK = 256;
+  u32 chunk[CHUNK];
+  for (int i = 0; i < count; i += CHUNK) {
+    const int n = count - i < CHUNK ? count - i : CHUNK;
+    expand_pixels(indices + i, n, table, chunk);
+    std::memcpy(out + static_cast<size_t>(i) * 4, chunk, static_cast<size_t>(n) * 4);
+  }
+}
+
 }  // namespace nes
@@ -1,9 +1,16 @@
 #include "ppu.h"
+#include <algorithm>
+#include <cstring>
+#include "compose.h"
+#include "deferred_renderer.h"
 #include "palette.h"
 
 namespace nes {
 
 PPU::PPU() { reset(); }
+PPU::~PPU() = default;
+PPU::PPU(PPU&&) noexcept = default;
+PPU& PPU::operator=(PPU&&) noexcept = default;
 
 void PPU::reset() {
   _ctrl = 0;
@@ -20,13 +27,66 @@ void PPU::reset() {
   _frame = 0;
   _nmi_pending = false;
 
-  for (int t = 0; t < 2; t++)
+  for (int t = 0; t < 4; t++)
     for (int i = 0; i < 1024; i++) _name[t][i] = 0;
   for (int i = 0; i < 32; i++) _palette[i] = 0;
-  _framebuffer.fill(0);
+  collect_frame();  // a frame still being drawn must not land after this
+  _pixels.fill(BLANK_PIXEL);
+  _line_key_size.fill(0);
+  _lines_reused = 0;
+  _lines_drawn = 0;
+  _framebuffer_stale = true;
 }
 
-void PPU::insert_cartridge(const std::shared_ptr<Cartridge>& c) { _cartridge = c; }
+void PPU::io_state(StateIO& s) {
+  collect_frame();  // the snapshot holds the frame as far as it has been drawn
+  s.field(_name);
+  s.field(_palette);
+  s.field(_ctrl);
+  s.field(_mask);
+  s.field(_status);
+  s.field(_oam_addr);
+  s.field(_oam);
+  s.field(_data_buffer);
+  s.field(_v);
+  s.field(_t);
+  s.field(_x);
+  s.field(_w);
+  s.field(_scanline);
+  s.field(_dot);
+  s.field(_frame);
+  s.field(_nmi_pending);
+  if (!s.loading()) {
+    s.field(_pixels);
+    return;
+  }
+
+  // A line whose restored pixels are the ones already there keeps its reuse
+  // key: the key still says what those pixels were drawn from. Run-ahead
+  // loads every frame, mostly over lines that did not change.
+  const u8* pixels = s.take(_pixels.size());
+  for (int line = 0; line < 240; line++) {
+    u8* row = &_pixels[line * 256];
+    if (std::memcmp(row, pixels + line * 256, 256) == 0) continue;
+    std::memcpy(row, pixels + line * 256, 256);
+    _line_key_size[line] = 0;
+    _framebuffer_stale = true;
+  }
+
+  // Everything else derived from the old contents is stale. A frame half
+  // recorded for the render threads is dropped; its remaining lines are drawn
+  // inline. CHR-RAM is restored after this, so keys naming it go too.
+  if (_deferred) _deferred->cancel();
+  _sprite_index_height = 0;
+  _vram_version++;
+  _oam_version++;
+  if (!_cartridge || _cartridge->chr_is_ram()) _chr_version++;
+}
+
+void PPU::insert_cartridge(const std::shared_ptr<Cartridge>& c) {
+  _cartridge = c;
+  update_mirroring();
+}
 
 // --- register access (implemented in B2) ---
 u8 PPU::cpu_read(u16 reg) const {
@@ -105,25 +165,19 @@ void PPU::cpu_write(u16 reg, u8 value) {
 // --- PPU bus access (implemented in B3) ---
 u16 PPU::nt_index(u16 addr, u16& offset) const {
   offset = addr & 0x03FF;
-  Cartridge::MirrorMode mode =
-      _cartridge ? _cartridge->mirror_mode() : Cartridge::MirrorMode::HORIZONTAL;
-  u16 table;
-  switch (mode) {
-    case Cartridge::MirrorMode::VERTICAL:
-      table = (addr >> 10) & 1;
-      break;
-    case Cartridge::MirrorMode::SINGLE_LO:
-      table = 0;  // both logical nametables map to physical table 0
-      break;
-    case Cartridge::MirrorMode::SINGLE_HI:
-      table = 1;
-      break;
-    case Cartridge::MirrorMode::HORIZONTAL:
-    default:
-      table = (addr >> 11) & 1;
-      break;
-  }
-  return table;
+  return _nt_map[(addr >> 10) & 0x03];
+}
+
+void PPU::update_mirroring() {
+  static constexpr u8 MAPS[][4] = {
+      {0, 0, 1, 1},  // HORIZONTAL
+      {0, 1, 0, 1},  // VERTICAL
+      {0, 0, 0, 0},  // SINGLE_LO
+      {1, 1, 1, 1},  // SINGLE_HI
+      {0, 1, 2, 3},  // FOUR_SCREEN
+  };
+  const auto mode = _cartridge ? _cartridge->mirror_mode() : Cartridge::MirrorMode::HORIZONTAL;
+  for (int i = 0; i < 4; i++) _nt_map[i] = MAPS[static_cast<int>(mode)][i];
 }
 
 u8 PPU::ppu_read(u16 addr) const {
@@ -149,14 +203,17 @@ void PPU::ppu_write(u16 addr, u8 value) {
   addr &= 0x3FFF;
   if (addr <= 0x1FFF) {
     if (_cartridge) _cartridge->ppu_write(addr, value);
+    _chr_version++;
   } else if (addr <= 0x3EFF) {
     u16 offset;
     u16 table = nt_index(addr, offset);
     _name[table][offset] = value;
+    _vram_version++;
   } else {
     u16 a = addr & 0x1F;
     if (a == 0x10 || a == 0x14 || a == 0x18 || a == 0x1C) a -= 0x10;
     _palette[a] = value;
+    _vram_version++;
   }
 }
 
@@ -242,125 +299,193 @@ void PPU::clock() {
   }
 }
 
+// Dots on which clock() can change anything, per kind of scanline; the rest
+// only move the counters. Stops are dot numbers after the increment, and 341
+// stands for the wrap onto the next line. copy_y() repeats over 280..304
+// with the same _t, so its first and last dots are enough.
+namespace {
+constexpr u16 RENDER_LINE_STOPS[] = {256, 257, 260, 341};
+constexpr u16 VBLANK_LINE_STOPS[] = {1, 341};
+constexpr u16 PRE_RENDER_STOPS[] = {1, 256, 257, 260, 280, 304, 341};
+constexpr u16 IDLE_LINE_STOPS[] = {341};
+
+u16 next_stop(u16 line, u16 dot) {
+  const u16* stop = line < 240    ? RENDER_LINE_STOPS
+                    : line == 241 ? VBLANK_LINE_STOPS
+                    : line == 261 ? PRE_RENDER_STOPS
+                                  : IDLE_LINE_STOPS;
+  while (*stop <= dot) stop++;
+  return *stop;
+}
+}  // namespace
+
+void PPU::run(u32 dots) {
+  while (dots > 0) {
+    const u32 idle = next_stop(_scanline, _dot) - _dot - 1u;
+    if (dots <= idle) {
+      _dot = static_cast<u16>(_dot + dots);
+      return;
+    }
+    _dot = static_cast<u16>(_dot + idle);
+    clock();
+    dots -= idle + 1;
+  }
+}
+
+// --- Event prediction ----------------------------------------------------
+namespace {
+constexpr u32 FRAME_DOTS = 262 * 341;
+constexpr u32 PULSES_PER_FRAME = 241;  // visible lines + the pre-render line
+
+// Frame-relative dot of the k-th scanline pulse counted from the start of the
+// current frame (k >= PULSES_PER_FRAME runs into the following frames).
+u32 pulse_pos(u32 k) {
+  const u32 i = k % PULSES_PER_FRAME;
+  return (k / PULSES_PER_FRAME) * FRAME_DOTS + (i < 240 ? i : 261) * 341 + 260;
+}
+}  // namespace
+
+u32 PPU::dots_until(u32 frame_pos) const {
+  const u32 pos = _scanline * 341u + _dot;
+  return (frame_pos + FRAME_DOTS - pos - 1) % FRAME_DOTS + 1;  // current dot is done
+}
+
+u32 PPU::dots_until_nmi() const { return (_ctrl & 0x80) ? dots_until(241 * 341 + 1) : 0; }
+
+u32 PPU::dots_until_frame_end() const { return dots_until(0); }
+
+u32 PPU::dots_until_scanline_pulse(u32 n) const {
+  if (!(_mask & 0x18) || !_cartridge || n == 0) return 0;
+  const u32 pos = _scanline * 341u + _dot;
+  u32 k = _scanline < 240 ? _scanline : 240;  // this line's pulse, or the pre-render one
+  if (pulse_pos(k) <= pos) k++;
+  return pulse_pos(k + n - 1) - pos;
+}
+
 // --- Scanline renderer (background + sprites) ------------------------------
 void PPU::render_scanline(u16 line) {
-  // Per-pixel background pixel value (0 = transparent/backdrop) for this line,
-  // used by the sprite pass for priority and sprite-0 hit detection.
-  u8 bg_pix[256] = {0};
-  const u32 backdrop = palette_rgba(_palette[0] & 0x3F);
-
-  if (_mask & 0x08) {  // PPUMASK d3: show background
-    const bool show_left_bg = (_mask & 0x02) != 0;  // d1: show BG in leftmost 8px
-    const u16 bg_base = (_ctrl & 0x10) ? 0x1000 : 0x0000;
-    for (int x = 0; x < 256; x++) {
-      // Fetch nametable tile id for the current coarse position.
-      u8 tile = ppu_read(0x2000 | (_v & 0x0FFF));
-
-      // Fetch attribute byte and extract the 2-bit palette for this quadrant.
-      u8 attr = ppu_read(0x23C0 | (_v & 0x0C00) | ((_v >> 4) & 0x38) | ((_v >> 2) & 0x07));
-      u8 palette_hi = ((attr >> (((_v >> 4) & 4) | (_v & 2))) & 3) << 2;
-
-      // Fetch the two bitplanes for the current fine-Y row.
-      u16 pat = bg_base | (static_cast<u16>(tile) << 4) | ((_v >> 12) & 7);
-      u8 lo = ppu_read(pat);
-      u8 hi = ppu_read(pat + 8);
-
-      // Select the bit using fine-X within the tile.
-      int bit = 7 - ((x + _x) & 7);
-      u8 pixel2 = static_cast<u8>(((hi >> bit) & 1) << 1) | static_cast<u8>((lo >> bit) & 1);
-      if (x < 8 && !show_left_bg) pixel2 = 0;  // mask leftmost 8px of background
-
-      bg_pix[x] = pixel2;
-      u8 color_index = (pixel2 == 0) ? _palette[0] : _palette[(palette_hi | pixel2) & 0x1F];
-      _framebuffer[line * 256 + x] = palette_rgba(color_index & 0x3F);
-
-      // Advance coarse-X every 8 rendered pixels (after the last px of a tile).
-      if (((x + _x) & 7) == 7) inc_coarse_x();
-    }
+  ScanlineState s;
+  capture_line(line, s);
+
+  // Frames nobody will look at (see set_render_interval) and frames drawn
+  // later (set_render_threads) only need the line's side effects here.
+  const bool drawn = _render_interval == 1 || (_render_interval != 0 && (_frame + 1) % _render_interval == 0);
+  const DeferredRenderer::Versions versions{_vram_version, _oam_version, _chr_version};
+  const bool chr_ram = _cartridge && _cartridge->chr_is_ram();
+  if (!drawn || (_deferred && _deferred->record(line, s, versions, chr_ram))) {
+    if (!(_status & 0x40) && sprite_zero_hit(s, line)) _status |= 0x40;
+    if (drawn && line == 239) _deferred->submit();
   } else {
-    for (int x = 0; x < 256; x++) _framebuffer[line * 256 + x] = backdrop;
+    // Redraw only when something the line reads has changed.
+    u8 key[SCANLINE_KEY_BYTES];
+    const int size = scanline_key(s, _chr_version, key);
+    if (size == _line_key_size[line] && std::memcmp(key, _line_keys[line].data(), size) == 0) {
+      _lines_reused++;
+    } else {
+      _line_hit[line] = draw_scanline(s, line, &_pixels[line * 256]);
+      std::memcpy(_line_keys[line].data(), key, size);
+      _line_key_size[line] = static_cast<u8>(size);
+      _lines_drawn++;
+      _framebuffer_stale = true;
+    }
+    if (_line_hit[line]) _status |= 0x40;
   }
 
-  // Overlay sprites on top (handles 8x8/8x16, flips, priority, sprite-0 hit).
-  if (_mask & 0x10) render_sprites(line, bg_pix);
+  // Drawing walks coarse X across the line with 32 inc_coarse_x() calls,
+  // which lands on the same coarse X in the other horizontal nametable.
+  if (_mask & 0x08) _v ^= 0x0400;
+}
+
+void PPU::capture_line(u16 line, ScanlineState& s) {
+  s.v = _v;
+  s.x = _x;
+  s.ctrl = _ctrl;
+  s.mask = _mask;
+  s.sprite_count = (_mask & 0x10) ? static_cast<u8>(evaluate_sprites(line, s.sprites)) : 0;
+  for (int i = 0; i < 4; i++) s.nametables[i] = _name[_nt_map[i]];
+  s.palette = _palette;
+  s.oam = _oam;
+  if (_cartridge) {
+    s.chr.cache = _cartridge->chr_cache();
+    const std::vector<u8>& chr = _cartridge->chr_memory();
+    s.chr.bytes = chr.data();
+    s.chr.size = static_cast<u32>(chr.size());
+    for (int i = 0; i < 8; i++) s.chr.map[i] = _cartridge->_mapper->chr_offset(static_cast<u16>(i << 10));
+  }
 }
 
 // --- Per-scanline sprite evaluation + rendering ----------------------------
-void PPU::render_sprites(u16 line, const u8* bg_pix) {
-  const int sprite_height = (_ctrl & 0x20) ? 16 : 8;  // PPUCTRL d5
-  const bool show_left_spr = (_mask & 0x04) != 0;     // PPUMASK d2
-
-  // Sprite evaluation: collect up to 8 sprites whose Y range covers this line,
-  // in OAM order. A 9th in-range sprite sets the overflow flag (PPUSTATUS d5).
-  int found[8];
-  int count = 0;
+int PPU::evaluate_sprites(u16 line, u8* found) {
+  const u8 sprite_height = (_ctrl & 0x20) ? 16 : 8;  // PPUCTRL d5
+  if (_sprite_index_height != sprite_height) index_sprites(sprite_height);
+
+  // Up to 8 sprites whose Y range covers this line, in OAM order. A 9th
+  // in-range sprite sets the overflow flag (PPUSTATUS d5).
+  const int count = _line_sprite_count[line];
+  for (int i = 0; i < count && i < 8; i++) found[i] = _line_sprites[line][i];
+  if (count > 8) {
+    _status |= 0x20;  // sprite overflow
+    return 8;
+  }
+  return count;
+}
+
+// One pass over OAM files each sprite under every visible line it covers,
+// keeping the first 9 per line (8 to draw + 1 for overflow). OAM rarely
+// changes mid-frame, so this runs about once per frame instead of scanning
+// all 64 sprites on every line.
+void PPU::index_sprites(u8 sprite_height) {
+  std::memset(_line_sprite_count, 0, sizeof(_line_sprite_count));
   for (int s = 0; s < 64; s++) {
-    int sy = _oam[s * 4];
-    int row = static_cast<int>(line) - sy - 1;  // sprites are delayed one scanline
-    if (row < 0 || row >= sprite_height) continue;
-    if (count < 8) {
-      found[count++] = s;
-    } else {
-      _status |= 0x20;  // sprite overflow
-      break;
+    const int top = _oam[s * 4] + 1;  // sprites are delayed one scanline
+    const int bottom = std::min(top + sprite_height, 240);
+    for (int line = top; line < bottom; line++) {
+      u8& count = _line_sprite_count[line];
+      if (count < 9) _line_sprites[line][count++] = static_cast<u8>(s);
     }
   }
+  _sprite_index_height = sprite_height;
+}
 
-  // Draw back-to-front so the lowest OAM index wins at each overlapping pixel.
-  for (int i = count - 1; i >= 0; i--) {
-    const int s = found[i];
-    const int sy = _oam[s * 4];
-    u8 tile = _oam[s * 4 + 1];
-    const u8 attr = _oam[s * 4 + 2];
-    const int sx = _oam[s * 4 + 3];
-
-    int row = static_cast<int>(line) - sy - 1;  // sprites are delayed one scanline
-    const bool flip_v = (attr & 0x80) != 0;
-    const bool flip_h = (attr & 0x40) != 0;
-    const bool behind = (attr & 0x20) != 0;  // priority: 1 = behind background
-    const u8 pal_hi = (attr & 0x03) << 2;
-    if (flip_v) row = sprite_height - 1 - row;
-
-    u16 pat_addr;
-    if (sprite_height == 16) {
-      const u16 table = (tile & 0x01) ? 0x1000 : 0x0000;
-      u8 t = tile & 0xFE;
-      if (row >= 8) {  // bottom half uses the next tile
-        t += 1;
-        row -= 8;
-      }
-      pat_addr = table | (static_cast<u16>(t) << 4) | static_cast<u16>(row);
-    } else {
-      const u16 table = (_ctrl & 0x08) ? 0x1000 : 0x0000;
-      pat_addr = table | (static_cast<u16>(tile) << 4) | static_cast<u16>(row);
-    }
-    const u8 lo = ppu_read(pat_addr);
-    const u8 hi = ppu_read(pat_addr + 8);
-
-    for (int col = 0; col < 8; col++) {
-      const int x = sx + col;
-      if (x >= 256) continue;
-      if (x < 8 && !show_left_spr) continue;
-      const int bit = flip_h ? col : (7 - col);
-      const u8 pixel2 = static_cast<u8>(((hi >> bit) & 1) << 1) | static_cast<u8>((lo >> bit) & 1);
-      if (pixel2 == 0) continue;  // transparent sprite pixel
-
-      // Sprite-0 hit: set whenever an opaque sprite-0 pixel overlaps an opaque
-      // background pixel (independent of priority); never at x==255.
-      if (s == 0 && bg_pix[x] != 0 && x != 255) _status |= 0x40;
-
-      // Priority: a "behind" sprite is hidden by opaque background.
-      if (behind && bg_pix[x] != 0) continue;
-
-      const u8 color_index = _palette[(0x10 + pal_hi + pixel2) & 0x1F];
-      _framebuffer[line * 256 + x] = palette_rgba(color_index & 0x3F);
-    }
+void PPU::set_render_interval(u32 every_n) { _render_interval = every_n; }
+
+void PPU::set_render_threads(u32 threads) {
+  collect_frame();
+  if (threads == 0) {
+    _deferred.reset();
+  } else if (!_deferred || _deferred->threads() != threads) {
+    _deferred = std::make_unique<DeferredRenderer>(threads);
+  }
+}
+
+void PPU::collect_frame() const {
+  if (_deferred && _deferred->collect(_pixels.data())) {
+    _framebuffer_stale = true;
+    _line_key_size.fill(0);  // the lines no longer match their keys
+  }
+}
+
+u64 PPU::lines_reused() const { return _lines_reused; }
+u64 PPU::lines_drawn() const { return _lines_drawn; }
+
+const u8* PPU::pattern_row(u16 addr, bool flip, u8* scratch) const {
+  if (_cartridge) {
+    if (const u8* pixels = _cartridge->chr_row(addr, flip)) return pixels;
+  }
+  const u8 lo = ppu_read(addr);
+  const u8 hi = ppu_read(addr + 8);
+  for (int col = 0; col < 8; col++) {
+    const int bit = flip ? col : (7 - col);
+    scratch[col] = static_cast<u8>(((hi >> bit) & 1) << 1) | static_cast<u8>((lo >> bit) & 1);
   }
+  return scratch;
 }
 
 // --- OAM access ------------------------------------------------------------
 void PPU::oam_write(u8 value) {
   _oam[_oam_addr] = value;
+  _sprite_index_height = 0;  // stale; rebuilt on the next sprite evaluation
+  _oam_version++;
   _oam_addr++;  // wraps at 256
 }
 
@@ -376,11 +501,10 @@ void PPU::render_pattern_table(int table, int palette, u32* out) const {
       int tile = tile_y * 16 + tile_x;
       u16 tile_base = table_base + static_cast<u16>(tile) * 16;
       for (int row = 0; row < 8; row++) {
-        u8 lo = ppu_read(tile_base + row);
-        u8 hi = ppu_read(tile_base + 8 + row);
+        u8 scratch[8];
+        const u8* pixels = pattern_row(tile_base + row, false, scratch);
         for (int col = 0; col < 8; col++) {
-          int bit = 7 - col;
-          u8 pixel2 = static_cast<u8>(((hi >> bit) & 1) << 1) | static_cast<u8>((lo >> bit) & 1);
+          u8 pixel2 = pixels[col];
           u8 color_index = _palette[((palette << 2) | pixel2) & 0x1F];
           int px = tile_x * 8 + col;
           int py = tile_y * 8 + row;
@@ -400,7 +524,20 @@ bool PPU::take_nmi() {
 u32 PPU::frame_count() const { return _frame; }
 u16 PPU::scanline() const { return _scanline; }
 u16 PPU::dot() const { return _dot; }
-const u32* PPU::framebuffer() const { return _framebuffer.data(); }
+const u32* PPU::framebuffer() const {
+  collect_frame();
+  if (_framebuffer_stale) {
+    _framebuffer.resize(_pixels.size());
+    expand_pixels(_pixels.data(), static_cast<int>(_pixels.size()), pixel_table(PixelFormat::RGBA),
+                  _framebuffer.data());
+    _framebuffer_stale = false;
+  }
+  return _framebuffer.data();
+}
+const u8* PPU::pixels() const {
+  collect_frame();
+  return _pixels.data();
+}
 
 u8 PPU::reg_status() const { return _status; }
 u8 PPU::reg_ctrl() const { return _ctrl; }
@@ -0,0 +1,195 @@
+#include "rewind.h"
+#include <algorithm>
+#include <cstring>
+#include "bus.h"
+
+namespace nes {
+
+namespace {
+
+constexpr size_t kPage = 256;   // unchanged pages are skipped with one memcmp
+constexpr size_t kMinFill = 4;  // shorter runs of one value stay in a literal
+
+// A record is a list of tokens, each a varint (length << 2 | tag) walking
+// forward through the snapshot; the bytes it XORs in follow literal and fill
+// tokens. Trailing unchanged bytes are not written.
+enum : u8 { kSkip = 0, kLiteral = 1, kFill = 2 };
+
+void put_token(std::vector<u8>& out, size_t len, u8 tag) {
+  u64 v = (static_cast<u64>(len) << 2) | tag;
+  while (v >= 0x80) {
+    out.push_back(static_cast<u8>(v) | 0x80);
+    v >>= 7;
+  }
+  out.push_back(static_cast<u8>(v));
+}
+
+// Code `cur` as the XOR against `base`, or against zeros for a keyframe.
+void encode(const u8* cur, const u8* base, size_t n, std::vector<u8>& out) {
+  out.clear();
+  auto x = [&](size_t i) -> u8 { return base ? cur[i] ^ base[i] : cur[i]; };
+  auto fill_starts = [&](size_t i) {
+    if (i + kMinFill > n) return false;
+    for (size_t k = 1; k < kMinFill; k++) {
+      if (x(i + k) != x(i)) return false;
+    }
+    return true;
+  };
+  size_t skip = 0;
+  size_t i = 0;
+  while (i < n) {
+    if (base && i % kPage == 0 && i + kPage <= n && std::memcmp(cur + i, base + i, kPage) == 0) {
+      skip += kPage;
+      i += kPage;
+      continue;
+    }
+    const u8 v = x(i);
+    if (v == 0) {
+      ++skip;
+      ++i;
+      continue;
+    }
+    if (skip) {
+      put_token(out, skip, kSkip);
+      skip = 0;
+    }
+    if (fill_starts(i)) {
+      size_t run = kMinFill;
+      while (i + run < n && x(i + run) == v) ++run;
+      put_token(out, run, kFill);
+      out.push_back(v);
+      i += run;
+      continue;
+    }
+    size_t j = i;
+    while (j < n && x(j) != 0 && !fill_starts(j)) ++j;
+    put_token(out, j - i, kLiteral);
+    for (size_t k = i; k < j; k++) out.push_back(x(k));
+    i = j;
+  }
+}
+
+// XOR a record into `state`, which must hold what it was coded against.
+void apply(const u8* code, size_t size, u8* state) {
+  const u8* p = code;
+  const u8* end = code + size;
+  size_t at = 0;
+  while (p < end) {
+    u64 v = 0;
+    int shift = 0;
+    do {
+      v |= static_cast<u64>(*p & 0x7F) << shift;
+      shift += 7;
+    } while (*p++ & 0x80);
+    const size_t len = static_cast<size_t>(v >> 2);
+    switch (v & 3) {
+      case kLiteral:
+        for (size_t k = 0; k < len; k++) state[at + k] ^= p[k];
+        p += len;
+        break;
+      case kFill: {
+        const u8 b = *p++;
+        for (size_t k = 0; k < len; k++) state[at + k] ^= b;
+        break;
+      }
+      default:
+        break;
+    }
+    at += len;
+  }
+}
+
+}  // namespace
+
+Rewind::Rewind(size_t budget_bytes, u32 keyframe_interval)
+    : _ring(budget_bytes), _interval(std::max<u32>(keyframe_interval, 1)) {}
+
+bool Rewind::push(Bus& bus) {
+  const size_t n = bus.state_size();
+  if (n != _prev.size()) clear();  // a different cartridge: start over
+  _cur.resize(n);
+  bus.save_state(_cur.data());
+
+  bool key = _entries.empty() || _since_key + 1 >= _interval;
+  if (!key) {
+    encode(_cur.data(), _prev.data(), n, _code);
+    key = !place(false);  // it would have evicted its own keyframe
+  }
+  if (key) {
+    encode(_cur.data(), nullptr, n, _code);
+    if (!place(true)) {
+      clear();
+      return false;
+    }
+  }
+  _since_key = key ? 0 : _since_key + 1;
+  _prev.swap(_cur);
+  return true;
+}
+
+// Put _code in the ring after the newest record, evicting the oldest records
+// it overlaps. Records never straddle the end of the ring: one that doesn't
+// fit before it starts again at 0. A delta fails rather than evict the
+// keyframe it is decoded from.
+bool Rewind::place(bool key) {
+  const size_t size = _code.size();
+  if (size > _ring.size()) return false;
+  if (_entries.empty()) _tail = 0;
+  const bool wrap = _tail + size > _ring.size();
+  const size_t at = wrap ? 0 : _tail;
+  // Records at or after _tail are left from the previous lap round the ring,
+  // oldest first; so are the ones at the front of the ring once it wraps.
+  auto blocks = [&](const Entry& e) {
+    if (wrap) return e.offset >= _tail || e.offset < size;
+    return e.offset >= _tail && e.offset < _tail + size;
+  };
+  if (!key) {
+    const size_t base = _entries.size() - 1 - _since_key;
+    size_t n = 0;
+    while (n < _entries.size() && blocks(_entries[n])) ++n;
+    if (n > base) return false;
+  }
+  while (!_entries.empty() && blocks(_entries.front())) evict_front();
+  std::memcpy(&_ring[at], _code.data(), size);
+  _entries.push_back({at, size, key});
+  _tail = at + size;
+  return true;
+}
+
+void Rewind::evict_front() {
+  _entries.pop_front();
+  while (!_entries.empty() && !_entries.front().key) _entries.pop_front();  // orphaned deltas
+}
+
+int Rewind::rewind(Bus& bus, u32 frames) {
+  if (_entries.empty()) return -1;
+  const u32 back = std::min(frames, depth() - 1);
+  const size_t target = _entries.size() - 1 - back;
+  size_t key = target;
+  while (!_entries[key].key) --key;
+  _cur.assign(_prev.size(), 0);
+  for (size_t i = key; i <= target; i++) {
+    apply(&_ring[_entries[i].offset], _entries[i].size, _cur.data());
+  }
+  if (!bus.load_state(_cur.data(), _cur.size())) return -1;
+  _prev.swap(_cur);
+  _entries.resize(target + 1);
+  _tail = _entries.back().offset + _entries.back().size;
+  _since_key = static_cast<u32>(target - key);
+  return static_cast<int>(back);
+}
+
+size_t Rewind::used() const {
+  size_t n = 0;
+  for (const Entry& e : _entries) n += e.size;
+  return n;
+}
+
+void Rewind::clear() {
+  _entries.clear();
+  _tail = 0;
+  _since_key = 0;
+  _prev.clear();
+}
+
+}  // namespace nes
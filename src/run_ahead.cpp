@@ -0,0 +1,37 @@
+#include "run_ahead.h"
+#include "bus.h"
+
+namespace nes {
+
+void RunAhead::set_frames(u32 frames) {
+  _frames = frames;
+  if (frames == 0) _shown = false;
+}
+
+void RunAhead::run(Bus& bus) {
+  _shown = false;
+  if (_frames == 0) return;
+  _state.resize(bus.state_size());
+  bus.save_state(_state.data());
+  bus.get_apu().pause_stream();
+
+  // Whole frames on the bus, without the debugger: speculative frames must
+  // not stop at breakpoints or count towards its statistics.
+  PPU& ppu = bus.get_ppu();
+  const u32 interval = ppu.render_interval();
+  for (u32 i = 0; i < _frames; i++) {
+    ppu.set_render_interval(i + 1 == _frames ? 1 : 0);  // draw only the one shown
+    const u32 frame = ppu.frame_count();
+    while (ppu.frame_count() == frame) bus.step();
+  }
+  bus.sync();
+  const u32* fb = ppu.framebuffer();
+  _frame.assign(fb, fb + 256 * 240);
+  ppu.set_render_interval(interval);
+
+  bus.load_state(_state.data(), _state.size());
+  bus.get_apu().resume_stream();
+  _shown = true;
+}
+
+}  // namespace nes
@@ -0,0 +1,190 @@
+#include "scanline.h"
+#include <cstring>
+#include "compose.h"
+
+namespace nes {
+namespace {
+// Pixels of OAM sprite `s` on `line` (it must cover the line).
+const u8* sprite_row(const ScanlineState& st, u16 line, int s, u8* scratch) {
+  const int sprite_height = (st.ctrl & 0x20) ? 16 : 8;
+  const int sy = st.oam[s * 4];
+  const u8 tile = st.oam[s * 4 + 1];
+  const u8 attr = st.oam[s * 4 + 2];
+
+  int row = static_cast<int>(line) - sy - 1;  // sprites are delayed one scanline
+  if (attr & 0x80) row = sprite_height - 1 - row;  // vertical flip
+
+  u16 pat_addr;
+  if (sprite_height == 16) {
+    const u16 table = (tile & 0x01) ? 0x1000 : 0x0000;
+    u8 t = tile & 0xFE;
+    if (row >= 8) {  // bottom half uses the next tile
+      t += 1;
+      row -= 8;
+    }
+    pat_addr = table | (static_cast<u16>(t) << 4) | static_cast<u16>(row);
+  } else {
+    const u16 table = (st.ctrl & 0x08) ? 0x1000 : 0x0000;
+    pat_addr = table | (static_cast<u16>(tile) << 4) | static_cast<u16>(row);
+  }
+  return st.chr.row(pat_addr, (attr & 0x40) != 0, scratch);
+}
+
+// Background pixel value (0..3) at x: the tile the line's coarse-X walk
+// would be on there, counted from v.
+u8 bg_pixel(const ScanlineState& st, int x) {
+  if (x < 8 && !(st.mask & 0x02)) return 0;  // leftmost 8px masked
+  const int pos = x + st.x;
+  const u16 coarse = static_cast<u16>((st.v & 0x001F) + (pos >> 3));
+  u16 v = static_cast<u16>((st.v & ~0x001F) | (coarse & 0x1F));
+  if (coarse >= 32) v ^= 0x0400;
+
+  const u8 tile = st.nametables[(v >> 10) & 3][v & 0x03FF];
+  const u16 bg_base = (st.ctrl & 0x10) ? 0x1000 : 0x0000;
+  const u16 pat = bg_base | (static_cast<u16>(tile) << 4) | ((v >> 12) & 7);
+  u8 scratch[8];
+  return st.chr.row(pat, false, scratch)[pos & 7];
+}
+}  // namespace
+
+const u8* ChrView::row(u16 addr, bool flip, u8* scratch) const {
+  const u32 offset = map[(addr >> 10) & 0x07] + (addr & 0x03FF);
+  if (cache) {
+    if (const u8* pixels = cache->row(offset, flip)) return pixels;
+  }
+  const u8 lo = offset < size ? bytes[offset] : 0;
+  const u8 hi = offset + 8 < size ? bytes[offset + 8] : 0;
+  for (int col = 0; col < 8; col++) {
+    const int bit = flip ? col : (7 - col);
+    scratch[col] = static_cast<u8>(((hi >> bit) & 1) << 1) | static_cast<u8>((lo >> bit) & 1);
+  }
+  return scratch;
+}
+
+bool draw_scanline(const ScanlineState& st, u16 line, u8* out) {
+  // Palette-RAM index per pixel for the background (0 = transparent) and the
+  // winning sprites; compose_line() merges them (see compose.h).
+  u8 bg[256] = {0};
+  u8 spr_any[256] = {0};
+  u8 spr_front[256] = {0};
+
+  if (st.mask & 0x08) {  // PPUMASK d3: show background
+    const bool show_left_bg = (st.mask & 0x02) != 0;  // d1: show BG in leftmost 8px
+    const u16 bg_base = (st.ctrl & 0x10) ? 0x1000 : 0x0000;
+    // Walk the line one tile at a time: the first tile is cut short by fine-X
+    // (and the last one, if fine-X is non-zero, covers the remainder).
+    u16 v = st.v;
+    u8 scratch[8];
+    int x = 0;
+    int fine = st.x;
+    while (x < 256) {
+      // Nametable byte and attribute byte live in the same physical table.
+      const u8* nt = st.nametables[(v >> 10) & 3];
+      const u8 tile = nt[v & 0x03FF];
+      const u8 attr = nt[0x3C0 | ((v >> 4) & 0x38) | ((v >> 2) & 0x07)];
+      const u8 palette_hi = ((attr >> (((v >> 4) & 4) | (v & 2))) & 3) << 2;
+
+      // The tile's pixels on the current fine-Y row.
+      const u16 pat = bg_base | (static_cast<u16>(tile) << 4) | ((v >> 12) & 7);
+      const u8* pixels = st.chr.row(pat, false, scratch);
+
+      const int end = (x + 8 - fine < 256) ? x + 8 - fine : 256;
+      for (; x < end; x++, fine++) {
+        const u8 pixel2 = pixels[fine];
+        if (x < 8 && !show_left_bg) continue;  // mask leftmost 8px of background
+        if (pixel2) bg[x] = palette_hi | pixel2;
+      }
+
+      // Coarse-X increment (with the horizontal nametable switch) after the
+      // last pixel of a whole tile.
+      if (fine == 8) {
+        v = ((v & 0x001F) == 31) ? static_cast<u16>((v & ~0x001F) ^ 0x0400) : static_cast<u16>(v + 1);
+        fine = 0;
+      }
+    }
+  }
+
+  // Sprites (8x8/8x16, flips, priority flag, sprite 0), front-to-back: the
+  // lowest OAM index claims each pixel first.
+  if (st.mask & 0x10) {
+    const bool show_left_spr = (st.mask & 0x04) != 0;  // PPUMASK d2
+    for (int i = 0; i < st.sprite_count; i++) {
+      const int s = st.sprites[i];
+      const u8 attr = st.oam[s * 4 + 2];
+      const int sx = st.oam[s * 4 + 3];
+      const bool behind = (attr & 0x20) != 0;  // priority: 1 = behind background
+      const u8 pal_hi = (attr & 0x03) << 2;
+      u8 scratch[8];
+      const u8* pixels = sprite_row(st, line, s, scratch);
+
+      for (int col = 0; col < 8; col++) {
+        const int x = sx + col;
+        if (x >= 256) continue;
+        if (x < 8 && !show_left_spr) continue;
+        const u8 pixel2 = pixels[col];
+        if (pixel2 == 0) continue;  // transparent sprite pixel
+
+        // Sprite 0 is marked for the hit test (any priority; never at x==255).
+        // A "behind" sprite only shows where the background is transparent, so
+        // over opaque background the first sprite in front of it wins instead.
+        const u8 index = static_cast<u8>(0x10 | pal_hi | pixel2);
+        if (!spr_any[x]) spr_any[x] = index | ((s == 0 && x != 255) ? 0x80 : 0);
+        if (!behind && !spr_front[x]) spr_front[x] = index;
+      }
+    }
+  }
+
+  u8 colors[32];
+  for (int i = 0; i < 32; i++) colors[i] = st.palette[i] & 0x3F;
+  return compose_line(bg, spr_any, spr_front, colors, out);
+}
+
+int scanline_key(const ScanlineState& st, u32 chr_version, u8* key) {
+  u8* k = key;
+  auto put = [&k](const void* data, size_t n) {
+    std::memcpy(k, data, n);
+    k += n;
+  };
+  put(&st.v, 2);
+  *k++ = st.x;
+  *k++ = st.ctrl & 0x38;  // pattern tables and sprite size
+  *k++ = st.mask;
+  put(st.palette, 32);
+  put(st.chr.map, sizeof(st.chr.map));
+  put(&st.chr.cache, sizeof(st.chr.cache));
+  put(&st.chr.bytes, sizeof(st.chr.bytes));
+  put(&chr_version, 4);
+  if (st.mask & 0x08) {
+    // The 33 tiles the background walk can touch, and their attribute bytes.
+    u16 v = st.v;
+    for (int i = 0; i < 33; i++) {
+      const u8* nt = st.nametables[(v >> 10) & 3];
+      *k++ = nt[v & 0x03FF];
+      *k++ = nt[0x3C0 | ((v >> 4) & 0x38) | ((v >> 2) & 0x07)];
+      v = ((v & 0x001F) == 31) ? static_cast<u16>((v & ~0x001F) ^ 0x0400) : static_cast<u16>(v + 1);
+    }
+  }
+  if (st.mask & 0x10) {
+    *k++ = st.sprite_count;
+    for (int i = 0; i < st.sprite_count; i++) {
+      *k++ = st.sprites[i];
+      put(&st.oam[st.sprites[i] * 4], 4);
+    }
+  }
+  return static_cast<int>(k - key);
+}
+
+bool sprite_zero_hit(const ScanlineState& st, u16 line) {
+  if ((st.mask & 0x18) != 0x18 || st.sprite_count == 0 || st.sprites[0] != 0) return false;
+  const bool show_left_spr = (st.mask & 0x04) != 0;
+  const int sx = st.oam[3];
+  u8 scratch[8];
+  const u8* pixels = sprite_row(st, line, 0, scratch);
+  for (int col = 0; col < 8 && sx + col < 255; col++) {
+    if (sx + col < 8 && !show_left_spr) continue;
+    if (pixels[col] && bg_pixel(st, sx + col)) return true;
+  }
+  return false;
+}
+
+}  // namespace nes
@@ -6,6 +6,8 @@
 #include "../include/cpu.h"
 #include "../include/debugger.h"
 #include "../include/ppu.h"
+#include "../include/rewind.h"
+#include "../include/run_ahead.h"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
@@ -13,6 +15,8 @@
 
 nes::Bus g_bus;
 nes::Debugger g_debugger(g_bus.get_cpu(), g_bus);
+std::unique_ptr<nes::Rewind> g_rewind;  // null until rewind_enable
+nes::RunAhead g_run_ahead;              // off until set_run_ahead
 
 #ifdef __EMSCRIPTEN__
 // Main loop function that will be called from JavaScript
@@ -25,8 +29,7 @@ EMSCRIPTEN_KEEPALIVE extern "C" void main_loop() {
 // ---- Phase 1: ROM loading + PPU framebuffer/debug exports ----------------
 
 // Build a cartridge from iNES bytes, insert it, and reset the CPU.
-// Returns the from_ines status code (0 ok, 1 bad-header, 2 unsupported-mapper,
-// 3 four-screen-unsupported).
+// Returns the from_ines status code (0 ok, 1 bad-header, 2 unsupported-mapper).
 EMSCRIPTEN_KEEPALIVE extern "C" int load_rom(const uint8_t* data, int len) {
   std::vector<nes::u8> bytes(data, data + len);
   int status = 0;
@@ -40,11 +43,19 @@ EMSCRIPTEN_KEEPALIVE extern "C" int load_rom(const uint8_t* data, int len) {
   // starts at its own entry point. (reset() alone leaves PC at $FFFC, which on
   // a real ROM is the low byte of the vector and would execute as a stray BRK.)
   g_debugger.reset_to_vector();
+  g_run_ahead.discard();
+  if (g_rewind) {
+    g_rewind->clear();
+    g_rewind->push(g_bus);
+  }
   return 0;
 }
 
-// Pointer to the PPU's 256*240 RGBA framebuffer (read by JS as a HEAPU8 view).
+// Pointer to the PPU's 256*240 RGBA framebuffer (read by JS as a HEAPU8 view),
+// converted from its colour-index frame when a new frame has been drawn. With
+// run-ahead on, the frame ahead that the last run_frame() drew instead.
 EMSCRIPTEN_KEEPALIVE extern "C" uint8_t* get_framebuffer_ptr() {
+  if (g_run_ahead.shown()) return reinterpret_cast<uint8_t*>(const_cast<nes::u32*>(g_run_ahead.framebuffer()));
   return reinterpret_cast<uint8_t*>(const_cast<nes::u32*>(g_bus.get_ppu().framebuffer()));
 }
 
@@ -60,7 +71,26 @@ EMSCRIPTEN_KEEPALIVE extern "C" uint32_t get_frame_count() {
 // reason (0 = frame completed, 1 = breakpoint hit, 2 = BRK) so the JS run loop
 // knows whether to keep going or halt — discarding it made every frame look
 // like a halt.
-EMSCRIPTEN_KEEPALIVE extern "C" int run_frame() { return g_debugger.run_frame(); }
+// Completed frames are recorded for rewind when it is on, then run ahead of
+// (see set_run_ahead).
+EMSCRIPTEN_KEEPALIVE extern "C" int run_frame() {
+  const int reason = g_debugger.run_frame();
+  if (reason != 0) {
+    g_run_ahead.discard();
+    return reason;
+  }
+  if (g_rewind) g_rewind->push(g_bus);
+  g_run_ahead.run(g_bus);
+  return reason;
+}
+
+// Run-ahead (see nes::RunAhead): show each frame as it will be `frames`
+// frames later with the same input, hiding that much of the game's input lag.
+// 0 turns it off. One or two frames cover most games; each costs a full
+// frame of emulation (without drawing or sound) on every run_frame().
+EMSCRIPTEN_KEEPALIVE extern "C" void set_run_ahead(int frames) {
+  g_run_ahead.set_frames(frames > 0 ? static_cast<nes::u32>(frames) : 0);
+}
 
 // Render a 128x128 RGBA pattern table (table 0/1, palette 0..7) into out.
 EMSCRIPTEN_KEEPALIVE extern "C" void ppu_render_pattern_table(int table, int palette, uint8_t* out) {
@@ -88,15 +118,58 @@ EMSCRIPTEN_KEEPALIVE extern "C" void set_controller(int port, int buttons) {
   g_bus.set_controller(port, static_cast<nes::u8>(buttons));
 }
 
-// Number of queued audio samples (44.1kHz mono float) waiting to be drained.
+// Output rate (8000-96000; pass AudioContext.sampleRate so WebAudio need not
+// resample) and queue capacity in samples. Starts an empty queue.
+EMSCRIPTEN_KEEPALIVE extern "C" void set_audio_output(int rate, int capacity) {
+  if (rate <= 0 || capacity <= 0) return;
+  g_bus.get_apu().set_output(static_cast<nes::u32>(rate), static_cast<nes::u32>(capacity));
+}
+
+// Number of queued audio samples (mono float at the output rate) waiting to be drained.
 EMSCRIPTEN_KEEPALIVE extern "C" int audio_available() {
-  return g_bus.get_apu().available();
+  return static_cast<int>(g_bus.audio_queue().size());
 }
 
 // Copy up to `max` queued samples into `out` (HEAPF32); returns the count.
 EMSCRIPTEN_KEEPALIVE extern "C" int audio_drain(float* out, int max) {
-  return g_bus.get_apu().drain(out, max);
+  return max > 0 ? static_cast<int>(g_bus.audio_queue().pop(out, static_cast<nes::u32>(max))) : 0;
+}
+
+// Queue size and its counters: samples dropped because it was full, and
+// drains that found it empty. Doubles, so JS gets the whole count.
+EMSCRIPTEN_KEEPALIVE extern "C" int audio_capacity() { return static_cast<int>(g_bus.audio_queue().capacity()); }
+EMSCRIPTEN_KEEPALIVE extern "C" double audio_overruns() { return static_cast<double>(g_bus.audio_queue().overruns()); }
+EMSCRIPTEN_KEEPALIVE extern "C" double audio_underruns() { return static_cast<double>(g_bus.audio_queue().underruns()); }
+
+// Whole-machine snapshots (see Bus::save_state). JS allocates state_size()
+// bytes with _malloc and passes the pointer; both calls return 0 on success.
+EMSCRIPTEN_KEEPALIVE extern "C" int state_size() { return static_cast<int>(g_bus.state_size()); }
+EMSCRIPTEN_KEEPALIVE extern "C" int save_state(uint8_t* out, int len) {
+  if (len < state_size()) return 1;
+  g_bus.save_state(out);
+  return 0;
+}
+EMSCRIPTEN_KEEPALIVE extern "C" int load_state(const uint8_t* data, int len) {
+  g_run_ahead.discard();
+  return g_bus.load_state(data, static_cast<size_t>(len)) ? 0 : 1;
+}
+
+// Rewind (see nes::Rewind and nes_rewind_enable in nes_env.h): a ring of
+// budget bytes of recent frames, 0 to turn it off. rewind_frames() returns
+// how many frames it went back, -1 with no history. (Not plain "rewind",
+// which is stdio's.)
+EMSCRIPTEN_KEEPALIVE extern "C" void rewind_enable(int budget, int keyframe_interval) {
+  g_rewind.reset();
+  if (budget <= 0) return;
+  g_rewind = std::make_unique<nes::Rewind>(static_cast<size_t>(budget), static_cast<nes::u32>(keyframe_interval));
+  g_rewind->push(g_bus);
+}
+EMSCRIPTEN_KEEPALIVE extern "C" int rewind_frames(int frames) {
+  if (!g_rewind || frames < 0) return -1;
+  g_run_ahead.discard();
+  return g_rewind->rewind(g_bus, static_cast<nes::u32>(frames));
 }
+EMSCRIPTEN_KEEPALIVE extern "C" int rewind_depth() { return g_rewind ? static_cast<int>(g_rewind->depth()) : 0; }
 
 // PPU register / scanline debug getters (no side effects).
 EMSCRIPTEN_KEEPALIVE extern "C" uint8_t ppu_get_ctrl() { return g_bus.get_ppu().reg_ctrl(); }
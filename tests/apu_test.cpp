@@ -1,13 +1,21 @@
 #include <gtest/gtest.h>
 #include <cmath>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <utility>
 #include <vector>
 #include "apu.h"
+#include "bus.h"
+#include "debugger.h"
+#include "test_rom.h"
 
 using namespace nes;
 
 namespace {
 void run(APU& a, int cycles) {
   for (int i = 0; i < cycles; i++) a.clock();
+  a.flush();
 }
 }  // namespace
 
@@ -70,3 +78,193 @@ TEST(APUTest, TriangleProducesAudio) {
   for (int i = 0; i < n; i++) peak = std::max(peak, std::fabs(buf[i]));
   EXPECT_GT(peak, 0.001f);
 }
+
+// run() skips ahead between timer and sequencer events; it must land on the
+// same samples and channel state as clocking every cycle, with register
+// writes arriving at arbitrary cycles.
+TEST(APUTest, RunMatchesClockCycleForCycle) {
+  APU clocked, batched;
+  std::mt19937 rng(42);
+  const u16 regs[] = {0x4000, 0x4001, 0x4002, 0x4003, 0x4004, 0x4005, 0x4006, 0x4007,
+                      0x4008, 0x400A, 0x400B, 0x400C, 0x400E, 0x400F, 0x4015, 0x4017};
+  std::vector<float> a(8192), b(8192);
+  for (int block = 0; block < 400; block++) {
+    const u32 cycles = rng() % 6000;
+    run(clocked, static_cast<int>(cycles));
+    batched.run(cycles);
+    ASSERT_EQ(clocked.read_status(), batched.read_status()) << "block " << block;
+    ASSERT_EQ(clocked.available(), batched.available()) << "block " << block;
+    const int n = clocked.drain(a.data(), 8192);
+    ASSERT_EQ(batched.drain(b.data(), 8192), n);
+    for (int i = 0; i < n; i++) ASSERT_EQ(a[i], b[i]) << "block " << block << " sample " << i;
+
+    const u16 reg = regs[rng() % 16];
+    u8 value = static_cast<u8>(rng());
+    if (reg == 0x4015) value |= 0x0F;  // keep the channels mostly on
+    clocked.write(reg, value);
+    batched.write(reg, value);
+  }
+}
+
+// The configured rate out of the 1.789773MHz CPU clock, and silence after a
+// tone settles back to zero through the high-pass.
+TEST(APUTest, SampleRateAndSettling) {
+  for (u32 rate : {44100u, 48000u}) {
+    SCOPED_TRACE(rate);
+    APU apu;
+    apu.set_output(rate, 4096);
+    EXPECT_EQ(apu.sample_rate(), rate);
+    apu.write(0x4015, 0x01);
+    apu.write(0x4000, 0x3F);  // constant volume 15, length halted
+    apu.write(0x4002, 0xFF);
+    apu.write(0x4003, 0x07);
+    std::vector<float> buf(8192);
+    int total = 0;
+    for (int i = 0; i < 60; i++) {
+      apu.run(29830);  // 60 x 29830 = 1789800 cycles
+      total += apu.drain(buf.data(), 8192);
+    }
+    EXPECT_NEAR(total, static_cast<int>(rate), 1);
+    EXPECT_EQ(apu.overruns(), 0u);
+
+    apu.write(0x4015, 0x00);
+    apu.run(1789773 / 8);
+    const int n = apu.drain(buf.data(), 8192);
+    EXPECT_LT(std::fabs(buf[n - 1]), 0.001f);
+  }
+}
+
+// A queue nobody drains keeps its oldest samples and counts what it drops;
+// a drain that finds it empty counts an underrun, one that is merely short
+// (the web drains 4096 a frame with ~735 queued) does not.
+TEST(APUTest, QueueCountsOverrunsAndUnderruns) {
+  APU apu;
+  apu.set_output(44100, 2048);
+  EXPECT_EQ(apu.capacity(), 2048u);
+  apu.write(0x4015, 0x01);
+  apu.write(0x4000, 0x3F);
+  apu.write(0x4002, 0xFF);
+  apu.write(0x4003, 0x07);
+  apu.run(1789773 / 10);  // 4410 samples
+  EXPECT_EQ(apu.available(), 2048);
+  EXPECT_NEAR(static_cast<double>(apu.overruns()), 4410 - 2048, 1);
+
+  std::vector<float> buf(4096);
+  EXPECT_EQ(apu.drain(buf.data(), 1024), 1024);
+  EXPECT_EQ(apu.underruns(), 0u);
+  EXPECT_EQ(apu.drain(buf.data(), 4096), 1024);
+  EXPECT_EQ(apu.underruns(), 0u);
+  EXPECT_EQ(apu.drain(buf.data(), 4096), 0);
+  EXPECT_EQ(apu.underruns(), 1u);
+}
+
+// An audio thread draining through Bus::audio_queue() while frames run on
+// another gets exactly the samples a machine drained between frames does.
+// The program retunes pulse 1 in every NMI so the stream is never periodic.
+TEST(APUTest, AudioQueueDrainsOnAnotherThread) {
+  TestRom rom(1, 1);
+  rom.emit({0x78, 0xA2, 0xFF, 0x9A});        // SEI; LDX #$FF; TXS
+  rom.emit({0xA9, 0x01, 0x8D, 0x15, 0x40});  // LDA #$01; STA $4015 (pulse 1 on)
+  rom.emit({0xA9, 0xBF, 0x8D, 0x00, 0x40});  // LDA #$BF; STA $4000
+  rom.emit({0xA9, 0x08, 0x8D, 0x03, 0x40});  // LDA #$08; STA $4003
+  rom.emit({0xA9, 0x80, 0x8D, 0x00, 0x20});  // LDA #$80; STA $2000 (NMI on)
+  const u16 loop = rom.pc();
+  rom.emit({0x4C, static_cast<u8>(loop), static_cast<u8>(loop >> 8)});  // JMP loop
+  const u16 nmi = rom.pc();
+  rom.emit({0xA5, 0x01, 0x69, 0x07, 0x85, 0x01});  // LDA $01; ADC #7; STA $01
+  rom.emit({0x8D, 0x02, 0x40, 0x40});              // STA $4002 (pulse period); RTI
+  rom.vectors(nmi, 0xC000, 0xC000);
+
+  constexpr int FRAMES = 120;
+  Bus reference, threaded;
+  for (Bus* bus : {&reference, &threaded}) {
+    bus->get_apu().set_output(44100, 1 << 17);  // room for every frame: nothing dropped
+    bus->insert_cartridge(rom.cartridge());
+    bus->reset();
+  }
+  Debugger reference_dbg(reference.get_cpu(), reference);
+  Debugger threaded_dbg(threaded.get_cpu(), threaded);
+  reference_dbg.reset_to_vector();
+  threaded_dbg.reset_to_vector();
+
+  std::vector<float> expected, buf(4096);
+  for (int i = 0; i < FRAMES; i++) {
+    reference_dbg.run_frame();
+    int n;
+    while ((n = reference.get_apu().drain(buf.data(), 4096)) > 0) {
+      expected.insert(expected.end(), buf.data(), buf.data() + n);
+    }
+  }
+
+  AudioRing& queue = threaded.audio_queue();
+  std::atomic<bool> done{false};
+  std::vector<float> got;
+  std::thread consumer([&] {
+    std::vector<float> out(512);
+    for (;;) {
+      const bool last = done.load(std::memory_order_acquire);
+      const u32 n = queue.pop(out.data(), 512);
+      got.insert(got.end(), out.data(), out.data() + n);
+      if (n == 0 && last) break;
+      if (n == 0) std::this_thread::yield();
+    }
+  });
+  for (int i = 0; i < FRAMES; i++) threaded_dbg.run_frame();
+  done.store(true, std::memory_order_release);
+  consumer.join();
+
+  ASSERT_GT(expected.size(), static_cast<size_t>(FRAMES * 700));
+  EXPECT_EQ(queue.overruns(), 0u);
+  EXPECT_EQ(got, expected);
+}
+
+// With synthesis off, timers are moved forward arithmetically between
+// sequencer steps. $4015 must still track the length counters exactly, and
+// once synthesis is back on every channel must be in the same phase as one
+// that was clocked all along.
+TEST(APUTest, SynthesisOffKeepsChannelState) {
+  APU reference, silent;
+  silent.set_synthesis(false);
+  std::mt19937 rng(7);
+  const u16 regs[] = {0x4000, 0x4001, 0x4002, 0x4003, 0x4004, 0x4005, 0x4006, 0x4007,
+                      0x4008, 0x400A, 0x400B, 0x400C, 0x400E, 0x400F, 0x4015, 0x4017};
+  std::vector<float> a(8192), b(8192);
+  for (int block = 0; block < 400; block++) {
+    const u32 cycles = rng() % 20000;
+    run(reference, static_cast<int>(cycles));
+    silent.run(cycles);
+    ASSERT_EQ(reference.read_status(), silent.read_status()) << "block " << block;
+    EXPECT_EQ(silent.available(), 0);
+    reference.drain(a.data(), 8192);
+
+    const u16 reg = regs[rng() % 16];
+    u8 value = static_cast<u8>(rng());
+    if (reg == 0x4015) value |= 0x0F;
+    reference.write(reg, value);
+    silent.write(reg, value);
+  }
+
+  // Every channel audible (lengths halted, sweeps off), then more silence.
+  const std::pair<u16, u8> audible[] = {
+      {0x4015, 0x0F}, {0x4000, 0xBF}, {0x4001, 0x00}, {0x4002, 0x80}, {0x4003, 0x00},
+      {0x4004, 0x7F}, {0x4005, 0x00}, {0x4006, 0x40}, {0x4007, 0x01}, {0x4008, 0xFF},
+      {0x400A, 0x30}, {0x400B, 0x00}, {0x400C, 0x3F}, {0x400E, 0x03}, {0x400F, 0x00}};
+  for (const auto& [reg, value] : audible) {
+    reference.write(reg, value);
+    silent.write(reg, value);
+  }
+  run(reference, 50001);
+  silent.run(50001);
+  reference.drain(a.data(), 8192);
+
+  // A fresh stream on both: identical only if every timer, step and LFSR agrees.
+  reference.set_synthesis(false);
+  reference.set_synthesis(true);
+  silent.set_synthesis(true);
+  reference.run(100000);
+  silent.run(100000);
+  const int n = reference.drain(a.data(), 8192);
+  ASSERT_EQ(silent.drain(b.data(), 8192), n);
+  ASSERT_GT(n, 0);
+  for (int i = 0; i < n; i++) ASSERT_EQ(a[i], b[i]) << "sample " << i;
+}
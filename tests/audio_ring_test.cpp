@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <thread>
+#include <vector>
+#include "audio_ring.h"
+
+using namespace nes;
+
+TEST(AudioRingTest, WrapsAndCounts) {
+  AudioRing ring(100);
+  EXPECT_EQ(ring.capacity(), 128u);  // rounded up to a power of two
+  float in[200], out[200];
+  for (int i = 0; i < 200; i++) in[i] = static_cast<float>(i);
+
+  // Walk the indices around the end of the storage a few times.
+  for (int round = 0; round < 10; round++) {
+    ASSERT_EQ(ring.push(in, 90), 90u);
+    ASSERT_EQ(ring.size(), 90u);
+    ASSERT_EQ(ring.pop(out, 90), 90u);
+    for (int i = 0; i < 90; i++) ASSERT_EQ(out[i], in[i]) << "round " << round;
+  }
+  EXPECT_EQ(ring.overruns(), 0u);
+  EXPECT_EQ(ring.underruns(), 0u);
+
+  EXPECT_EQ(ring.push(in, 200), 128u);  // the oldest samples are kept
+  EXPECT_EQ(ring.overruns(), 72u);
+  EXPECT_EQ(ring.pop(out, 200), 128u);
+  EXPECT_EQ(out[127], 127.0f);
+  EXPECT_EQ(ring.underruns(), 0u);  // short, but it had samples
+  EXPECT_EQ(ring.pop(out, 10), 0u);
+  EXPECT_EQ(ring.underruns(), 1u);
+  EXPECT_EQ(ring.pop(out, 0), 0u);  // asking for nothing is not an underrun
+  EXPECT_EQ(ring.underruns(), 1u);
+}
+
+// One thread pushes a counting sequence in odd-sized blocks (retrying what
+// didn't fit) while another pops it: every sample must arrive exactly once,
+// in order, with nothing torn.
+TEST(AudioRingTest, ProducerAndConsumerThreads) {
+  AudioRing ring(256);
+  constexpr u32 TOTAL = 2000000;
+  u32 mismatches = 0;
+  std::thread consumer([&] {
+    float out[97];
+    u32 expected = 0;
+    while (expected < TOTAL) {
+      const u32 n = ring.pop(out, 97);
+      for (u32 i = 0; i < n; i++) {
+        if (out[i] != static_cast<float>(expected)) mismatches++;
+        expected++;
+      }
+      if (n == 0) std::this_thread::yield();
+    }
+  });
+  float block[61];
+  u32 value = 0;
+  while (value < TOTAL) {
+    const u32 n = std::min<u32>(61, TOTAL - value);
+    for (u32 i = 0; i < n; i++) block[i] = static_cast<float>(value + i);
+    const u32 pushed = ring.push(block, n);
+    value += pushed;
+    if (pushed < n) std::this_thread::yield();
+  }
+  consumer.join();
+  EXPECT_EQ(mismatches, 0u);
+  EXPECT_EQ(ring.size(), 0u);
+}
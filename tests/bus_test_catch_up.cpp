@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "bus.h"
+#include "debugger.h"
+#include "test_rom.h"
+
+using namespace nes;
+
+// Catch-up timing (Bus::step) must be indistinguishable from clocking every
+// chip every cycle. Two machines load the same MMC3 program -- NMI handler
+// writing the palette, scanline IRQs that switch CHR banks, $2002 polling,
+// scroll + APU writes, and an OAM DMA with IRQs masked every loop -- one
+// steps in lockstep and one in catch-up mode, and every observable must match.
+class BusCatchUpTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const TestRom rom = program();
+    for (Bus* bus : {&lockstep, &catch_up}) {
+      auto cart = rom.cartridge();
+      ASSERT_TRUE(cart);
+      bus->insert_cartridge(cart);
+      bus->reset();
+      bus->get_cpu().set_pc(0xE000);  // CPU::reset() doesn't load the vector
+    }
+    lockstep.set_catch_up(false);
+    catch_up.set_catch_up(true);
+  }
+
+  // 32KB PRG + 8KB CHR, mapper 4. Code lives in the fixed $E000 bank.
+  static TestRom program() {
+    TestRom rom(2, 1, 4);
+    for (int i = 0; i < rom.chr_size(); i++) rom.chr()[i] = static_cast<u8>(i * 37 + (i >> 8));
+    rom.org(0xE000);
+    const u16 reset = rom.pc();
+    rom.emit({0x78, 0xA2, 0xFF, 0x9A});              // SEI; LDX #$FF; TXS
+    rom.emit({0xA9, 0x14, 0x8D, 0x00, 0xC0});        // LDA #20; STA $C000 (IRQ latch)
+    rom.emit({0x8D, 0x01, 0xC0, 0x8D, 0x01, 0xE0});  // STA $C001 (reload); STA $E001 (enable)
+    rom.emit({0xA9, 0x80, 0x8D, 0x00, 0x20});        // LDA #$80; STA $2000 (NMI on)
+    rom.emit({0xA9, 0x1E, 0x8D, 0x01, 0x20});        // LDA #$1E; STA $2001 (rendering on)
+    rom.emit({0x58});                                // CLI
+    const u16 loop = rom.pc();
+    rom.emit({0x78, 0xAD, 0x02, 0x20});              // SEI; LDA $2002
+    rom.emit({0xE6, 0x10, 0xA6, 0x10, 0x8A});        // INC $10; LDX $10; TXA
+    rom.emit({0x9D, 0x00, 0x02});                    // STA $0200,X (sprite data)
+    rom.emit({0x8D, 0x05, 0x20});                    // STA $2005
+    rom.emit({0x8D, 0x00, 0x40, 0xAD, 0x15, 0x40});  // STA $4000; LDA $4015
+    rom.emit({0xA9, 0x02, 0x8D, 0x14, 0x40});        // LDA #$02; STA $4014 (OAM DMA)
+    rom.emit({0x58});                                // CLI (IRQs held off above land here)
+    rom.emit({0x4C, static_cast<u8>(loop), static_cast<u8>(loop >> 8)});
+    const u16 nmi = rom.pc();
+    rom.emit({0xE6, 0x11});                          // INC $11
+    rom.emit({0xA9, 0x3F, 0x8D, 0x06, 0x20});        // LDA #$3F; STA $2006
+    rom.emit({0xA5, 0x11, 0x29, 0x1F});              // LDA $11; AND #$1F
+    rom.emit({0x8D, 0x06, 0x20, 0x8D, 0x07, 0x20});  // STA $2006; STA $2007 (palette)
+    rom.emit({0x40});                                // RTI
+    const u16 irq = rom.pc();
+    rom.emit({0x8D, 0x00, 0xE0, 0x8D, 0x01, 0xE0});  // STA $E000 (ack); STA $E001
+    rom.emit({0xE6, 0x12});                          // INC $12
+    rom.emit({0xA9, 0x02, 0x8D, 0x00, 0x80});        // LDA #2; STA $8000 (select R2)
+    rom.emit({0xA5, 0x12, 0x8D, 0x01, 0x80});        // LDA $12; STA $8001 (CHR bank)
+    rom.emit({0x40});                                // RTI
+    rom.vectors(nmi, reset, irq);
+    return rom;
+  }
+
+  void expect_same_machine() {
+    lockstep.sync();
+    catch_up.sync();
+    const CPU& a = lockstep.get_cpu();
+    const CPU& b = catch_up.get_cpu();
+    EXPECT_EQ(a.get_pc(), b.get_pc());
+    EXPECT_EQ(a.get_accumulator(), b.get_accumulator());
+    EXPECT_EQ(a.get_x(), b.get_x());
+    EXPECT_EQ(a.get_y(), b.get_y());
+    EXPECT_EQ(a.get_sp(), b.get_sp());
+    EXPECT_EQ(a.get_status(), b.get_status());
+    for (u16 addr = 0; addr < 0x0800; addr++) {
+      ASSERT_EQ(lockstep.cpu_read(addr), catch_up.cpu_read(addr)) << "RAM differs at $" << std::hex << addr;
+    }
+    PPU& pa = lockstep.get_ppu();
+    PPU& pb = catch_up.get_ppu();
+    EXPECT_EQ(pa.frame_count(), pb.frame_count());
+    EXPECT_EQ(pa.scanline(), pb.scanline());
+    EXPECT_EQ(pa.dot(), pb.dot());
+    EXPECT_EQ(pa.reg_status(), pb.reg_status());
+    EXPECT_EQ(pa.vram_addr(), pb.vram_addr());
+    EXPECT_EQ(0, std::memcmp(pa.framebuffer(), pb.framebuffer(), 256 * 240 * sizeof(u32)));
+    EXPECT_EQ(lockstep.get_apu().available(), catch_up.get_apu().available());
+  }
+
+  Bus lockstep;
+  Bus catch_up;
+};
+
+TEST_F(BusCatchUpTest, StepMatchesLockstepCycleForCycle) {
+  u64 cycles = 0;
+  while (catch_up.get_ppu().frame_count() < 6) {
+    const u16 pc = lockstep.get_cpu().get_pc();
+    const int expected = lockstep.step();
+    ASSERT_EQ(catch_up.step(), expected) << "instruction at $" << std::hex << pc << " after "
+                                         << std::dec << cycles << " cycles";
+    ASSERT_EQ(lockstep.get_cpu().get_pc(), catch_up.get_cpu().get_pc());
+    cycles += static_cast<u64>(expected);
+  }
+  expect_same_machine();
+
+  // The program really took NMIs and mapper IRQs.
+  EXPECT_GT(catch_up.cpu_read(0x0011), 0);
+  EXPECT_GT(catch_up.cpu_read(0x0012), 0);
+}
+
+TEST_F(BusCatchUpTest, RunFrameMatchesLockstep) {
+  Debugger a(lockstep.get_cpu(), lockstep);
+  Debugger b(catch_up.get_cpu(), catch_up);
+  for (int frame = 0; frame < 10; frame++) {
+    ASSERT_EQ(a.run_frame(), b.run_frame());
+    ASSERT_EQ(a.get_cycle_count(), b.get_cycle_count());
+    ASSERT_EQ(a.get_instruction_count(), b.get_instruction_count());
+    // run_frame() leaves the PPU caught up, so no sync() is needed to see it.
+    ASSERT_EQ(lockstep.get_ppu().scanline(), catch_up.get_ppu().scanline());
+    ASSERT_EQ(lockstep.get_ppu().dot(), catch_up.get_ppu().dot());
+  }
+  expect_same_machine();
+}
+
+// Mixing the per-cycle clock() API with catch-up stepping stays coherent.
+TEST_F(BusCatchUpTest, ClockAfterStepCatchesUp) {
+  for (int i = 0; i < 20000; i++) {
+    lockstep.step();
+    catch_up.step();
+  }
+  for (int i = 0; i < 1000; i++) {
+    lockstep.clock();
+    catch_up.clock();
+  }
+  for (int i = 0; i < 20000; i++) {
+    ASSERT_EQ(lockstep.step(), catch_up.step());
+  }
+  expect_same_machine();
+}
+
+// A snapshot taken mid-frame replays exactly, whichever mode loads it: the
+// machine that saved it and a lockstep one both retrace the original run.
+TEST_F(BusCatchUpTest, SnapshotReplaysInEitherMode) {
+  while (catch_up.get_ppu().frame_count() < 3) catch_up.step();
+  for (int i = 0; i < 777; i++) catch_up.step();
+  const std::vector<u8> state = snapshot(catch_up);
+
+  for (int i = 0; i < 30000; i++) catch_up.step();
+  catch_up.sync();
+  std::vector<u8> ram(0x0800);
+  for (u16 addr = 0; addr < 0x0800; addr++) ram[addr] = catch_up.cpu_read(addr);
+  const u16 pc = catch_up.get_cpu().get_pc();
+  const u32 frame = catch_up.get_ppu().frame_count();
+  const std::vector<u32> fb(catch_up.get_ppu().framebuffer(), catch_up.get_ppu().framebuffer() + 256 * 240);
+
+  ASSERT_TRUE(lockstep.load_state(state.data(), state.size()));
+  ASSERT_TRUE(catch_up.load_state(state.data(), state.size()));
+  for (Bus* bus : {&lockstep, &catch_up}) {
+    float drained[1024];
+    while (bus->get_apu().drain(drained, 1024) > 0) {
+    }
+  }
+  for (int i = 0; i < 30000; i++) ASSERT_EQ(lockstep.step(), catch_up.step()) << "step " << i;
+  expect_same_machine();
+
+  EXPECT_EQ(catch_up.get_cpu().get_pc(), pc);
+  EXPECT_EQ(catch_up.get_ppu().frame_count(), frame);
+  for (u16 addr = 0; addr < 0x0800; addr++) ASSERT_EQ(catch_up.cpu_read(addr), ram[addr]) << std::hex << addr;
+  EXPECT_EQ(0, std::memcmp(catch_up.get_ppu().framebuffer(), fb.data(), fb.size() * sizeof(u32)));
+}
+
+// Snapshots of another size or cartridge are refused without touching the machine.
+TEST_F(BusCatchUpTest, SnapshotRejectsMismatches) {
+  for (int i = 0; i < 5000; i++) catch_up.step();
+  const std::vector<u8> state = snapshot(catch_up);
+  const u16 pc = lockstep.get_cpu().get_pc();
+
+  EXPECT_FALSE(lockstep.load_state(state.data(), state.size() - 1));
+  std::vector<u8> bad = state;
+  bad[0] ^= 0xFF;  // magic
+  EXPECT_FALSE(lockstep.load_state(bad.data(), bad.size()));
+
+  Bus other;
+  other.insert_cartridge(TestRom(2, 1).cartridge());  // same banks, mapper 0
+  EXPECT_FALSE(other.load_state(state.data(), state.size()));
+
+  EXPECT_EQ(lockstep.get_cpu().get_pc(), pc);
+  EXPECT_TRUE(lockstep.load_state(state.data(), state.size()));
+  EXPECT_EQ(lockstep.get_cpu().get_pc(), catch_up.get_cpu().get_pc());
+}
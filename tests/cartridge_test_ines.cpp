@@ -1,4 +1,6 @@
 #include <gtest/gtest.h>
+#include <cstring>
+#include <memory>
 #include <vector>
 #include "cartridge.h"
 
@@ -69,13 +71,16 @@ TEST(CartridgeInesTest, NonZeroMapperReturnsStatus2) {
   EXPECT_EQ(cart, nullptr);
 }
 
-TEST(CartridgeInesTest, FourScreenReturnsStatus3) {
-  // flags6 bit3 = four-screen.
-  auto bytes = make_ines(1, 1, /*flags6*/ 0x08, /*flags7*/ 0x00);
+TEST(CartridgeInesTest, FourScreenOverridesMirroring) {
+  // flags6 bit3 = four-screen; it wins over bit0 and over mapper mirroring.
+  auto bytes = make_ines(1, 1, /*flags6*/ 0x49, /*flags7*/ 0x00);  // MMC3
   int status = -1;
   auto cart = Cartridge::from_ines(bytes, status);
-  EXPECT_EQ(status, 3);
-  EXPECT_EQ(cart, nullptr);
+  ASSERT_EQ(status, 0);
+  ASSERT_NE(cart, nullptr);
+  EXPECT_EQ(cart->mirror_mode(), Cartridge::MirrorMode::FOUR_SCREEN);
+  cart->cpu_write(0xA000, 0x01);  // MMC3: horizontal
+  EXPECT_EQ(cart->mirror_mode(), Cartridge::MirrorMode::FOUR_SCREEN);
 }
 
 TEST(CartridgeInesTest, SkipsTrainerBeforePrg) {
@@ -112,3 +117,37 @@ TEST(CartridgeInesTest, ChrRamAllocatedAndWritable) {
   EXPECT_TRUE(cart->ppu_read(0x0001, data));
   EXPECT_EQ(data, 0x3C);
 }
+
+TEST(CartridgeInesTest, CloneSharesRomAndCopiesState) {
+  auto bytes = make_ines(4, 0, /*flags6*/ 0x20, 0x00);  // UxROM, CHR-RAM
+  int status = -1;
+  std::shared_ptr<Cartridge> cart = Cartridge::from_ines(bytes, status);
+  ASSERT_EQ(status, 0);
+  cart->cpu_write(0x8000, 0x02);  // bank 2 at $8000
+  cart->cpu_write(0x6000, 0x11);
+  cart->ppu_write(0x0010, 0x81);
+
+  auto copy = Cartridge::clone(cart);
+  auto copy_of_copy = Cartridge::clone(copy);
+  EXPECT_TRUE(copy->_prg_memory.empty());
+  EXPECT_EQ(copy->cpu_read_page(0x8000), cart->cpu_read_page(0x8000));  // same ROM bytes
+  EXPECT_EQ(copy_of_copy->cpu_read_page(0xC000), cart->cpu_read_page(0xC000));
+  u8 data = 0;
+  EXPECT_TRUE(copy->cpu_read(0x6000, data));
+  EXPECT_EQ(data, 0x11);
+  EXPECT_TRUE(copy->ppu_read(0x0010, data));
+  EXPECT_EQ(data, 0x81);
+  ASSERT_NE(copy->chr_row(0x0010, false), nullptr);
+  EXPECT_EQ(0, std::memcmp(copy->chr_row(0x0010, false), cart->chr_row(0x0010, false), 8));
+
+  // From here on they are separate machines.
+  copy->cpu_write(0x8000, 0x01);
+  copy->cpu_write(0x6000, 0x22);
+  copy->ppu_write(0x0010, 0x00);
+  EXPECT_EQ(cart->cpu_read_page(0x8000), &cart->_prg_memory[2 * 0x4000]);
+  EXPECT_TRUE(cart->cpu_read(0x6000, data));
+  EXPECT_EQ(data, 0x11);
+  EXPECT_TRUE(cart->ppu_read(0x0010, data));
+  EXPECT_EQ(data, 0x81);
+  EXPECT_NE(0, std::memcmp(copy->chr_row(0x0010, false), cart->chr_row(0x0010, false), 8));
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <random>
+#include <vector>
+#include "cartridge.h"
+#include "chr_cache.h"
+#include "palette.h"
+#include "ppu.h"
+#include "test_rom.h"
+
+using namespace nes;
+
+namespace {
+// iNES image with `chr8k` banks of pseudo-random CHR (0 => CHR-RAM).
+TestRom make_rom(u8 chr8k, u8 mapper, u32 seed) {
+  TestRom rom(2, chr8k, mapper);
+  std::mt19937 rng(seed);
+  for (int i = 0; i < rom.chr_size(); i++) rom.chr()[i] = static_cast<u8>(rng());
+  return rom;
+}
+
+std::shared_ptr<Cartridge> load(const TestRom& rom) {
+  auto c = rom.cartridge();
+  EXPECT_TRUE(c);
+  return c;
+}
+
+// Reference bit-slice of one pattern row.
+u8 pixel(const std::vector<u8>& chr, u32 row_offset, int col) {
+  const int bit = 7 - col;
+  return static_cast<u8>((((chr[row_offset + 8] >> bit) & 1) << 1) | ((chr[row_offset] >> bit) & 1));
+}
+}  // namespace
+
+TEST(ChrCacheTest, DecodesEveryRowAndItsMirror) {
+  auto cart = load(make_rom(/*chr8k*/ 2, /*mapper*/ 3, 1));
+  const ChrCache* cache = cart->chr_cache();
+  ASSERT_NE(cache, nullptr);
+  ASSERT_EQ(cache->tiles(), 1024u);
+  for (u32 tile = 0; tile < cache->tiles(); tile++) {
+    for (u32 row = 0; row < 8; row++) {
+      const u32 offset = tile * 16 + row;
+      const u8* plain = cache->row(offset, false);
+      const u8* flipped = cache->row(offset, true);
+      for (int col = 0; col < 8; col++) {
+        ASSERT_EQ(plain[col], pixel(cart->_chr_memory, offset, col)) << "tile " << tile << " row " << row;
+        ASSERT_EQ(flipped[7 - col], plain[col]);
+      }
+    }
+  }
+  EXPECT_EQ(cache->row(1024 * 16, false), nullptr);  // past the end of CHR
+}
+
+TEST(ChrCacheTest, RowsFollowChrBankSwitches) {
+  auto cart = load(make_rom(/*chr8k*/ 4, /*mapper*/ 3, 2));  // CNROM
+  const ChrCache* cache = cart->chr_cache();
+  EXPECT_EQ(cart->chr_row(0x0123, false), cache->row(0x0123, false));
+  cart->cpu_write(0x8000, 2);  // 8KB CHR bank 2
+  EXPECT_EQ(cart->chr_row(0x0123, true), cache->row(2 * 0x2000 + 0x0123, true));
+}
+
+// Every cartridge loaded from the same CHR-ROM shares one decoded copy; other
+// CHR and CHR-RAM carts get their own.
+TEST(ChrCacheTest, ChrRomCacheIsSharedByIdenticalRoms) {
+  const auto rom = make_rom(/*chr8k*/ 1, /*mapper*/ 0, 3);
+  auto a = load(rom);
+  auto b = load(rom);
+  auto other = load(make_rom(/*chr8k*/ 1, /*mapper*/ 0, 4));
+  auto ram_a = load(make_rom(/*chr8k*/ 0, /*mapper*/ 0, 5));
+  auto ram_b = load(make_rom(/*chr8k*/ 0, /*mapper*/ 0, 5));
+  EXPECT_EQ(a->chr_cache(), b->chr_cache());
+  EXPECT_NE(a->chr_cache(), other->chr_cache());
+  EXPECT_NE(ram_a->chr_cache(), ram_b->chr_cache());
+
+  // The shared copy outlives any one cartridge.
+  const ChrCache* shared = a->chr_cache();
+  a.reset();
+  EXPECT_EQ(load(rom)->chr_cache(), shared);
+}
+
+// CHR-RAM writes re-decode exactly the row they touch, so the renderer sees
+// tiles a game uploads mid-frame.
+TEST(ChrCacheTest, ChrRamWritesRefreshTheCache) {
+  auto cart = load(make_rom(/*chr8k*/ 0, /*mapper*/ 0, 6));
+  PPU ppu;
+  ppu.insert_cartridge(cart);
+  ppu.reset();
+  ppu.cpu_write(1, 0x08);
+  auto poke = [&](u16 addr, u8 value) {
+    ppu.cpu_write(6, (addr >> 8) & 0x3F);
+    ppu.cpu_write(6, addr & 0xFF);
+    ppu.cpu_write(7, value);
+  };
+  poke(0x3F00, 0x0F);
+  poke(0x3F01, 0x30);
+  poke(0x3F02, 0x2A);
+  poke(0x3F03, 0x16);
+  poke(0x0013, 0xF0);  // tile 1, row 3: low plane
+  poke(0x001B, 0x3C);  // tile 1, row 3: high plane
+  EXPECT_EQ(cart->chr_row(0x0012, false)[0], 0);  // neighbouring rows untouched
+
+  std::array<u32, 128 * 128> out{};
+  ppu.render_pattern_table(0, 0, out.data());
+  const u8 expected[8] = {0x30, 0x30, 0x16, 0x16, 0x2A, 0x2A, 0x0F, 0x0F};
+  for (int col = 0; col < 8; col++) {
+    EXPECT_EQ(out[3 * 128 + 8 + col], palette_rgba(expected[col])) << "col " << col;
+  }
+
+  poke(0x0013, 0x00);
+  ppu.render_pattern_table(0, 0, out.data());
+  EXPECT_EQ(out[3 * 128 + 8], palette_rgba(0x0F));
+  EXPECT_EQ(out[3 * 128 + 10], palette_rgba(0x2A));  // hi plane only -> colour 2
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "compose.h"
+
+using namespace nes;
+
+namespace {
+// Colour table whose entries are easy to tell apart: palette-RAM i -> 0x20 + i.
+void make_lut(u8* lut) {
+  for (int i = 0; i < 32; i++) lut[i] = static_cast<u8>(0x20 + i);
+}
+}  // namespace
+
+// Priority rules, independent of the kernel: opaque background loses only to
+// a sprite in front of it; transparent background shows any sprite, else the
+// backdrop; a sprite-0 pixel hits only over opaque background.
+TEST(ComposeTest, ScalarKernelPriorityRules) {
+  u8 bg[256] = {0}, any[256] = {0}, front[256] = {0};
+  u8 lut[32], out[256];
+  make_lut(lut);
+
+  bg[1] = 0x05;                                   // background only
+  any[2] = 0x11;                                  // sprite over transparent background
+  bg[3] = 0x06, any[3] = 0x12;                    // behind sprite under opaque background
+  bg[4] = 0x07, any[4] = 0x13, front[4] = 0x13;  // front sprite
+  bg[5] = 0x07, any[5] = 0x15, front[5] = 0x1A;  // behind sprite, front one later in OAM
+  any[6] = 0x80 | 0x11;                           // sprite 0 over transparent background
+  EXPECT_FALSE(compose_line_scalar(bg, any, front, lut, out));
+
+  EXPECT_EQ(out[0], lut[0x00]);
+  EXPECT_EQ(out[1], lut[0x05]);
+  EXPECT_EQ(out[2], lut[0x11]);
+  EXPECT_EQ(out[3], lut[0x06]);
+  EXPECT_EQ(out[4], lut[0x13]);
+  EXPECT_EQ(out[5], lut[0x1A]);
+  EXPECT_EQ(out[6], lut[0x11]);
+
+  bg[200] = 0x01; any[200] = 0x80 | 0x12;  // behind sprite 0 over background: hit
+  EXPECT_TRUE(compose_line_scalar(bg, any, front, lut, out));
+  EXPECT_EQ(out[200], lut[0x01]);
+}
+
+// Every SIMD kernel this CPU can run matches the scalar one on random lines.
+TEST(ComposeTest, EveryKernelMatchesScalar) {
+  ComposeKernel kernels[8];
+  const int n = compose_kernels(kernels, 8);
+  ASSERT_GE(n, 1);
+  EXPECT_STREQ(kernels[0].name, "scalar");
+  EXPECT_STREQ(compose_kernel_name(), kernels[n - 1].name);
+
+  u32 table[256];
+  for (u32 i = 0; i < 256; i++) table[i] = 0xFF000000u | (i * 0x010307u);
+
+  std::mt19937 rng(1234);
+  u8 lut[32];
+  make_lut(lut);
+  for (int trial = 0; trial < 500; trial++) {
+    u8 bg[256], any[256], front[256];
+    const int hit_at = static_cast<int>(rng() % 300);  // sometimes no sprite 0 at all
+    for (int x = 0; x < 256; x++) {
+      const u32 r = rng();
+      bg[x] = (r & 3) ? static_cast<u8>((r >> 2) & 0x0F) : 0;
+      any[x] = (r & 0x30) ? static_cast<u8>(0x10 | ((r >> 8) & 0x0F)) : 0;
+      // front is either the same sprite or a later one (or none, if all are behind).
+      if (!any[x] || (r & 0x40)) {
+        front[x] = any[x];
+      } else {
+        front[x] = (r & 0x80) ? static_cast<u8>(0x10 | ((r >> 16) & 0x0F)) : 0;
+      }
+      if (any[x] && x == hit_at) any[x] |= 0x80;
+    }
+    u8 expected[256];
+    const bool expected_hit = compose_line_scalar(bg, any, front, lut, expected);
+    for (int k = 1; k < n; k++) {
+      u8 out[256];
+      SCOPED_TRACE(testing::Message() << kernels[k].name << " trial " << trial);
+      ASSERT_EQ(kernels[k].fn(bg, any, front, lut, out), expected_hit);
+      for (int x = 0; x < 256; x++) ASSERT_EQ(out[x], expected[x]) << "x=" << x;
+
+      // Expansion of a whole frame's worth of indices, with a ragged tail.
+      u32 wide[250], wide_expected[250];
+      for (u32& v : wide) v = 0;
+      expand_pixels_scalar(expected, 250, table, wide_expected);
+      kernels[k].expand(expected, 250, table, wide);
+      for (int x = 0; x < 250; x++) ASSERT_EQ(wide[x], wide_expected[x]) << "expand x=" << x;
+    }
+  }
+}
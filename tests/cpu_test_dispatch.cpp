@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <random>
+#include "bus.h"
+#include "test_cartridge.h"
+
+using namespace nes;
+
+// Cross-checks the switch-dispatched interpreter against the reference
+// pointer-to-member table: for every opcode, two machines start from the same
+// random registers + memory, one executes through each core, and the resulting
+// registers, cycle count, and memory must match. Friend of CPU (see cpu.h).
+class CPUTestDispatch : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    for (Bus* bus : {&table_bus, &switch_bus}) {
+      bus->insert_cartridge(std::make_shared<MockCartridge>());
+      bus->reset();
+    }
+  }
+
+  // Same pseudo-random state on both machines. RAM and $8000-$FFFF are filled,
+  // and the opcode is placed at a random PC in either RAM or PRG space.
+  void seed(u8 opcode, u32 trial) {
+    std::mt19937 rng(opcode * 7919u + trial);
+    auto byte = [&]() { return static_cast<u8>(rng() & 0xFF); };
+
+    u8 ram[0x0800];
+    for (u8& b : ram) b = byte();
+    std::vector<u8> prg(0x8000);
+    for (u8& b : prg) b = byte();
+    u8 a = byte(), x = byte(), y = byte(), sp = byte(), p = byte();
+    u16 pc = (rng() & 1) ? static_cast<u16>(rng() % 0x07FD) : static_cast<u16>(0x8000 + rng() % 0x7FFD);
+
+    for (Bus* bus : {&table_bus, &switch_bus}) {
+      for (u16 i = 0; i < 0x0800; i++) bus->cpu_write(i, ram[i]);
+      for (u32 i = 0; i < 0x8000; i++) bus->cpu_write(static_cast<u16>(0x8000 + i), prg[i]);
+      bus->cpu_write(pc, opcode);
+
+      CPU& cpu = bus->get_cpu();
+      cpu._A = a;
+      cpu._X = x;
+      cpu._Y = y;
+      cpu._SP = sp;
+      cpu._status = p;
+      cpu._PC = pc;
+      cpu._cycles = 0;
+    }
+  }
+
+  void expect_same_state(u8 opcode, u32 trial) {
+    const CPU& t = table_bus.get_cpu();
+    const CPU& s = switch_bus.get_cpu();
+    SCOPED_TRACE(testing::Message() << "opcode $" << std::hex << int(opcode) << std::dec << " trial " << trial);
+    EXPECT_EQ(t._A, s._A);
+    EXPECT_EQ(t._X, s._X);
+    EXPECT_EQ(t._Y, s._Y);
+    EXPECT_EQ(t._SP, s._SP);
+    EXPECT_EQ(t._status, s._status);
+    EXPECT_EQ(t._PC, s._PC);
+    EXPECT_EQ(t._cycles, s._cycles);
+    for (u32 addr = 0; addr < 0x10000; addr++) {
+      if (addr == 0x0800) addr = 0x8000;  // skip mirrors and IO registers
+      ASSERT_EQ(table_bus.cpu_read(static_cast<u16>(addr)), switch_bus.cpu_read(static_cast<u16>(addr)))
+          << "memory differs at $" << std::hex << addr;
+    }
+  }
+
+  // Max out both index registers and point the operand (or the (zp) pointer)
+  // at $xx80 so every indexed mode crosses a page.
+  void force_page_cross() {
+    for (Bus* bus : {&table_bus, &switch_bus}) {
+      CPU& cpu = bus->get_cpu();
+      cpu._X = 0xFF;
+      cpu._Y = 0xFF;
+      bus->cpu_write(cpu._PC + 1, 0x80);
+      bus->cpu_write(0x0080, 0x80);
+    }
+  }
+
+  void execute_table() { table_bus.get_cpu().execute_table(); }
+  void execute_switch() { switch_bus.get_cpu().execute_switch(1); }
+
+  Bus table_bus;
+  Bus switch_bus;
+};
+
+TEST_F(CPUTestDispatch, SwitchCoreMatchesTableForEveryOpcode) {
+  constexpr u32 TRIALS = 16;
+  for (int op = 0; op < 256; op++) {
+    for (u32 trial = 0; trial < TRIALS; trial++) {
+      seed(static_cast<u8>(op), trial);
+      execute_table();
+      execute_switch();
+      expect_same_state(static_cast<u8>(op), trial);
+      if (HasFatalFailure()) return;
+    }
+  }
+}
+
+// Page-crossing indexed reads pay one extra cycle in both cores; stores don't.
+TEST_F(CPUTestDispatch, PageCrossPenaltyMatches) {
+  for (u8 op : {0xBD, 0xB9, 0xB1, 0x9D, 0x99, 0x91, 0x1E, 0xBF, 0xB3, 0x1C}) {
+    seed(op, 0);
+    force_page_cross();
+    execute_table();
+    execute_switch();
+    expect_same_state(op, 0);
+  }
+}
@@ -39,6 +39,10 @@ class NmiVectorCartridge : public Cartridge {
   bool cpu_write(u16 address, u8 value) override {
     return address >= 0x8000;
   }
+
+  // No direct pages: every access must reach the overrides above.
+  const u8* cpu_read_page(u16 /*address*/) const override { return nullptr; }
+  u8* cpu_write_page(u16 /*address*/) override { return nullptr; }
 };
 
 class CpuNmiTest : public ::testing::Test {
@@ -0,0 +1,70 @@
+#include "cpu_test_base.h"
+
+using nes::Opcode;
+using nes::u8;
+using nes::u16;
+
+// CPU::run(budget) / step_instruction(): whole instructions back to back, with
+// the cycle count returned to the caller instead of being clocked out.
+class CPURunTest : public CPUTestBase {
+ protected:
+  // Write a program at $0200 and point the CPU at it.
+  void load(std::initializer_list<u8> prog) {
+    u16 addr = 0x0200;
+    for (u8 b : prog) bus.cpu_write(addr++, b);
+    cpu.set_pc(0x0200);
+  }
+};
+
+// A budget is a lower bound: run() finishes the instruction that crosses it.
+TEST_F(CPURunTest, RunExecutesWholeInstructionsAndReturnsCycles) {
+  load({(u8)Opcode::LDA_IMM, 0x42, (u8)Opcode::STA_ZPG, 0x10, (u8)Opcode::INX_IMP});
+  EXPECT_EQ(cpu.run(4), 2 + 3);
+  EXPECT_EQ(cpu.get_accumulator(), 0x42);
+  EXPECT_EQ(bus.cpu_read(0x0010), 0x42);
+  EXPECT_EQ(cpu.get_pc(), 0x0204);
+  EXPECT_EQ(cpu.get_remaining_cycles(), 0);
+}
+
+// Taken branches and page-cross penalties are part of the returned count.
+TEST_F(CPURunTest, RunCountsBranchAndPageCrossCycles) {
+  // LDX #$FF; LDA $02FF,X (crosses into $03FE: 4+1); BNE +0 (taken: 2+1)
+  load({(u8)Opcode::LDX_IMM, 0xFF, (u8)Opcode::LDA_ABX, 0xFF, 0x02, (u8)Opcode::BNE_REL, 0x00});
+  bus.cpu_write(0x03FE, 0x01);
+  EXPECT_EQ(cpu.run(1), 2);
+  EXPECT_EQ(cpu.run(1), 5);
+  EXPECT_EQ(cpu.run(1), 3);
+}
+
+// Cycles owed by a part-clocked instruction are drained first.
+TEST_F(CPURunTest, StepInstructionFinishesPendingCycles) {
+  load({(u8)Opcode::STA_ABS, 0x00, 0x03, (u8)Opcode::INY_IMP});
+  cpu.clock();  // executes STA, 3 of its 4 cycles still owed
+  EXPECT_EQ(cpu.step_instruction(), 3);
+  EXPECT_EQ(cpu.get_y(), 0x00);
+  EXPECT_EQ(cpu.step_instruction(), 2);
+  EXPECT_EQ(cpu.get_y(), 0x01);
+}
+
+// run() and cycle-by-cycle clock() agree on every instruction boundary.
+TEST_F(CPURunTest, RunMatchesClockStepping) {
+  // Countdown loop: LDX #$20; loop: ADC $10; STX $10; DEX; BNE loop; NOP
+  const std::initializer_list<u8> prog = {(u8)Opcode::LDX_IMM, 0x20, (u8)Opcode::ADC_ZPG, 0x10, (u8)Opcode::STX_ZPG,
+                                          0x10, (u8)Opcode::DEX_IMP, (u8)Opcode::BNE_REL, 0xF9, (u8)Opcode::NOP_IMP};
+  nes::Bus ref;
+  ref.insert_cartridge(std::make_shared<nes::MockCartridge>());
+  ref.reset();
+  u16 addr = 0x0200;
+  for (u8 b : prog) ref.cpu_write(addr++, b);
+  ref.get_cpu().set_pc(0x0200);
+  load(prog);
+
+  int used = cpu.run(200);
+  for (int i = 0; i < used; i++) ref.get_cpu().clock();
+
+  EXPECT_EQ(ref.get_cpu().get_remaining_cycles(), 0);
+  EXPECT_EQ(cpu.get_pc(), ref.get_cpu().get_pc());
+  EXPECT_EQ(cpu.get_accumulator(), ref.get_cpu().get_accumulator());
+  EXPECT_EQ(cpu.get_x(), ref.get_cpu().get_x());
+  EXPECT_EQ(cpu.get_status(), ref.get_cpu().get_status());
+}
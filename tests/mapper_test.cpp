@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <vector>
+#include "bus.h"
 #include "cartridge.h"
 
 using namespace nes;
@@ -68,6 +69,31 @@ TEST(MapperTest, MMC1PrgBankingAndMirror) {
   EXPECT_EQ(c->mirror_mode(), Cartridge::MirrorMode::HORIZONTAL);
 }
 
+// MMC1 CHR in 8KB mode (low bit ignored) and 4KB mode (two independent banks).
+TEST(MapperTest, MMC1ChrBankingModes) {
+  auto c = load(make_rom(/*prg16k*/ 2, /*chr8k*/ 4, /*mapper*/ 1));  // 32 x 1KB CHR
+  mmc1_load(*c, 0xA000, 3);  // CHR0 = 4KB bank 3; 8KB mode uses bank 2 -> 1KB idx 8
+  EXPECT_EQ(ppu(*c, 0x0000), 8);
+  EXPECT_EQ(ppu(*c, 0x1C00), 15);
+  mmc1_load(*c, 0x8000, 0x1C);  // 4KB CHR mode
+  mmc1_load(*c, 0xC000, 5);     // CHR1 = 4KB bank 5 -> 1KB idx 20
+  EXPECT_EQ(ppu(*c, 0x0000), 12);
+  EXPECT_EQ(ppu(*c, 0x1400), 21);
+}
+
+// MMC3 PRG mode 1 swaps $8000/$C000; CHR inversion swaps the 2KB/1KB halves.
+TEST(MapperTest, MMC3PrgModeAndChrInversion) {
+  auto c = load(make_rom(/*prg16k*/ 4, /*chr8k*/ 2, /*mapper*/ 4));
+  c->cpu_write(0x8000, 0x46); c->cpu_write(0x8001, 2);  // mode 1, R6 = 2
+  EXPECT_EQ(cpu(*c, 0x8000), 6);
+  EXPECT_EQ(cpu(*c, 0xC000), 2);
+  c->cpu_write(0x8000, 0x80); c->cpu_write(0x8001, 4);  // inverted, R0 = 4 (2KB)
+  EXPECT_EQ(ppu(*c, 0x1000), 4);
+  EXPECT_EQ(ppu(*c, 0x1400), 5);
+  c->cpu_write(0x8000, 0x82); c->cpu_write(0x8001, 9);  // R2 = 9 at $0000
+  EXPECT_EQ(ppu(*c, 0x0000), 9);
+}
+
 TEST(MapperTest, MMC3BankingAndMirror) {
   auto c = load(make_rom(/*prg16k*/ 4, /*chr8k*/ 2, /*mapper*/ 4));  // 8x8KB PRG
   // PRG mode 0: $8000=R6, $A000=R7, $C000=second-last(6), $E000=last(7).
@@ -112,6 +138,47 @@ TEST(MapperTest, MMC3ScanlineIrq) {
   EXPECT_FALSE(c->irq_pending());
 }
 
+// The Bus reads PRG-RAM/PRG-ROM through a cached page table; after bank
+// switches through the Bus it must still agree with the cartridge byte-for-byte.
+TEST(MapperTest, BusPageTableFollowsBankSwitches) {
+  struct Case {
+    u8 mapper;
+    std::vector<std::pair<u16, u8>> writes;
+  };
+  const Case cases[] = {
+      {2, {{0x8000, 5}, {0xC123, 3}}},
+      {1, {{0x8000, 1}, {0x8000, 1}, {0x8000, 0}, {0x8000, 1}, {0x8000, 0},  // control = $0B
+           {0xE000, 1}, {0xE000, 1}, {0xE000, 0}, {0xE000, 0}, {0xE000, 0}}},  // PRG bank 3
+      {4, {{0x8000, 6}, {0x8001, 5}, {0x8000, 0x47}, {0x8001, 2}}},             // R6, then PRG mode 1
+  };
+  for (const Case& c : cases) {
+    auto cart = load(make_rom(/*prg16k*/ 8, /*chr8k*/ 1, c.mapper));
+    Bus bus;
+    bus.insert_cartridge(cart);
+    bus.cpu_write(0x6010, 0x5A);  // PRG-RAM through the page table
+    for (const auto& w : c.writes) {
+      bus.cpu_write(w.first, w.second);
+      for (u32 a = 0x6000; a <= 0xFFFF; a += 0x3FF) {
+        ASSERT_EQ(bus.cpu_read(static_cast<u16>(a)), cpu(*cart, static_cast<u16>(a)))
+            << "mapper " << int(c.mapper) << " $" << std::hex << a;
+      }
+    }
+    EXPECT_EQ(cpu(*cart, 0x6010), 0x5A);
+  }
+}
+
+// Each supported iNES mapper id loads the matching final board, which the
+// Cartridge's static dispatch relies on.
+TEST(MapperTest, BoardTagMatchesMapperId) {
+  const Mapper::Board expected[] = {Mapper::Board::NROM, Mapper::Board::MMC1, Mapper::Board::UXROM,
+                                    Mapper::Board::CNROM, Mapper::Board::MMC3};
+  for (u8 id = 0; id < 5; id++) {
+    auto c = load(make_rom(/*prg16k*/ 2, /*chr8k*/ 1, id));
+    ASSERT_NE(c, nullptr);
+    EXPECT_EQ(c->_mapper->board(), expected[id]) << "mapper " << int(id);
+  }
+}
+
 TEST(MapperTest, UnsupportedMapperRejected) {
   int st = -1;
   auto c = Cartridge::from_ines(make_rom(2, 1, /*mapper*/ 5), st);  // MMC5
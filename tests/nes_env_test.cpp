@@ -77,6 +77,7 @@ TEST(NesEnv, InstancesAreIndependentAndIdentical) {
   NesEnv* b = nes_create();
   nes_load(a, rom.data(), static_cast<int>(rom.size()));
   nes_load(b, rom.data(), static_cast<int>(rom.size()));
+  nes_set_render_threads(b, 2);  // drawing off the emulation thread changes nothing
 
   const uint8_t seq[] = {0, 0x80, 0x81, 0x08, 0, 0x40};
   for (int f = 0; f < 120; f++) {
@@ -89,3 +90,192 @@ TEST(NesEnv, InstancesAreIndependentAndIdentical) {
   nes_destroy(a);
   nes_destroy(b);
 }
+
+// The core keeps colour indices; RGBA/BGRA/RGB24 are derived from them on
+// demand and must agree with each other and with nes_framebuffer().
+TEST(NesEnv, IndexedFramebufferConvertsOnDemand) {
+  NesEnv* e = nes_create();
+  auto rom = synthetic_rom();
+  nes_load(e, rom.data(), static_cast<int>(rom.size()));
+  for (int i = 0; i < 3; i++) nes_step(e, 0);
+
+  const uint8_t* indices = nes_framebuffer_indices(e);
+  ASSERT_NE(indices, nullptr);
+  const int pixels = 256 * 240;
+  for (int i = 0; i < pixels; i++) ASSERT_LT(indices[i], 64) << "pixel " << i;
+
+  std::vector<uint8_t> rgba(pixels * 4), bgra(pixels * 4), rgb(pixels * 3);
+  EXPECT_EQ(nes_framebuffer_convert(e, NES_FORMAT_RGBA, rgba.data()), pixels * 4);
+  EXPECT_EQ(nes_framebuffer_convert(e, NES_FORMAT_BGRA, bgra.data()), pixels * 4);
+  EXPECT_EQ(nes_framebuffer_convert(e, NES_FORMAT_RGB24, rgb.data()), pixels * 3);
+  EXPECT_EQ(nes_framebuffer_convert(e, 99, rgb.data()), 0);
+  EXPECT_EQ(0, std::memcmp(rgba.data(), nes_framebuffer(e), rgba.size()));
+  for (int i = 0; i < pixels; i++) {
+    ASSERT_EQ(bgra[i * 4 + 0], rgba[i * 4 + 2]);
+    ASSERT_EQ(bgra[i * 4 + 1], rgba[i * 4 + 1]);
+    ASSERT_EQ(bgra[i * 4 + 2], rgba[i * 4 + 0]);
+    ASSERT_EQ(bgra[i * 4 + 3], rgba[i * 4 + 3]);
+    ASSERT_EQ(0, std::memcmp(&rgb[i * 3], &rgba[i * 4], 3));
+  }
+  nes_destroy(e);
+}
+
+// Save, run on, then load into a fresh handle: it continues identically. A
+// short buffer or a snapshot of another cartridge layout is refused.
+TEST(NesEnv, StateRoundTrip) {
+  auto rom = synthetic_rom();
+  NesEnv* a = nes_create();
+  NesEnv* b = nes_create();
+  EXPECT_EQ(nes_state_size(a), 0);
+  nes_load(a, rom.data(), static_cast<int>(rom.size()));
+  nes_load(b, rom.data(), static_cast<int>(rom.size()));
+  for (int i = 0; i < 20; i++) nes_step(a, 0);
+
+  const int size = nes_state_size(a);
+  ASSERT_GT(size, 2048);
+  std::vector<uint8_t> state(size);
+  EXPECT_NE(nes_save_state(a, state.data(), size - 1), 0);
+  ASSERT_EQ(nes_save_state(a, state.data(), size), 0);
+  for (int i = 0; i < 30; i++) nes_step(a, static_cast<uint8_t>(i));
+  uint8_t ram_a[2048], ram_b[2048];
+  nes_get_ram(a, ram_a);
+
+  ASSERT_EQ(nes_load_state(b, state.data(), size), 0);
+  EXPECT_EQ(nes_frame_count(b), 20u);
+  for (int i = 0; i < 30; i++) nes_step(b, static_cast<uint8_t>(i));
+  nes_get_ram(b, ram_b);
+  EXPECT_EQ(nes_frame_count(b), nes_frame_count(a));
+  EXPECT_EQ(0, std::memcmp(ram_a, ram_b, 2048));
+  const int n = nes_framebuffer_size(a);
+  EXPECT_EQ(fnv1a(nes_framebuffer(a), n), fnv1a(nes_framebuffer(b), n));
+
+  EXPECT_NE(nes_load_state(b, state.data(), size - 1), 0);
+  auto chr_ram = rom;
+  chr_ram[5] = 0;  // CHR-RAM board: a different layout
+  chr_ram.resize(16 + 16384);
+  nes_load(b, chr_ram.data(), static_cast<int>(chr_ram.size()));
+  EXPECT_NE(nes_state_size(b), size);
+  EXPECT_NE(nes_load_state(b, state.data(), size), 0);
+  nes_destroy(a);
+  nes_destroy(b);
+}
+
+// A clone replays exactly what its source does, and branches independently;
+// copy_into retargets a handle running another ROM.
+TEST(NesEnv, CloneAndCopyInto) {
+  auto rom = synthetic_rom();
+  auto chr_ram = rom;
+  chr_ram[5] = 0;
+  chr_ram.resize(16 + 16384);
+  NesEnv* src = nes_create();
+  EXPECT_EQ(nes_clone(src), nullptr);  // nothing loaded
+  nes_load(src, chr_ram.data(), static_cast<int>(chr_ram.size()));
+  for (int i = 0; i < 15; i++) nes_step(src, 0);
+
+  NesEnv* fork = nes_clone(src);
+  ASSERT_NE(fork, nullptr);
+  NesEnv* pool = nes_create();
+  nes_load(pool, rom.data(), static_cast<int>(rom.size()));  // another layout
+  ASSERT_EQ(nes_copy_into(pool, src), 0);
+  EXPECT_EQ(nes_frame_count(pool), 15u);
+
+  const int size = nes_state_size(src);
+  ASSERT_EQ(nes_state_size(fork), size);
+  std::vector<uint8_t> a(size), b(size);
+  for (int i = 0; i < 20; i++) {
+    nes_step(src, static_cast<uint8_t>(i));
+    nes_step(fork, static_cast<uint8_t>(i));
+  }
+  nes_save_state(src, a.data(), size);
+  nes_save_state(fork, b.data(), size);
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(nes_frame_count(pool), 15u);  // untouched by the others' steps
+
+  nes_destroy(src);  // the clone keeps the shared ROM alive
+  nes_step(fork, 0);
+  nes_reset(fork);
+  EXPECT_EQ(nes_frame_count(fork), 0u);
+  nes_destroy(fork);
+  nes_destroy(pool);
+}
+
+// Stepping records frames once rewind is on; nes_rewind goes back to exactly
+// the state of that frame, and nes_load starts the history over.
+// Audio is off until asked for; then every step queues a frame of samples at
+// the chosen rate, and draining past the end counts one underrun.
+TEST(NesEnv, AudioOutput) {
+  auto rom = synthetic_rom();
+  NesEnv* e = nes_create();
+  nes_load(e, rom.data(), static_cast<int>(rom.size()));
+  nes_step(e, 0);
+  EXPECT_EQ(nes_audio_available(e), 0);
+  EXPECT_NE(nes_set_audio_output(e, 1000, 4096), 0);
+  EXPECT_NE(nes_set_audio_output(e, 48000, 0), 0);
+
+  ASSERT_EQ(nes_set_audio_output(e, 48000, 16384), 0);
+  EXPECT_EQ(nes_audio_capacity(e), 16384);
+  for (int i = 0; i < 10; i++) nes_step(e, 0);
+  EXPECT_NEAR(nes_audio_available(e), 10 * 48000 / 60.0988, 50);  // NTSC frames
+  std::vector<float> out(16384);
+  const int n = nes_audio_available(e);
+  EXPECT_EQ(nes_audio_drain(e, out.data(), 16384), n);
+  EXPECT_EQ(nes_audio_underruns(e), 0u);
+  EXPECT_EQ(nes_audio_drain(e, out.data(), 16384), 0);
+  EXPECT_EQ(nes_audio_underruns(e), 1u);
+  EXPECT_EQ(nes_audio_overruns(e), 0u);
+
+  ASSERT_EQ(nes_set_audio_output(e, 0, 1), 0);
+  nes_step(e, 0);
+  EXPECT_EQ(nes_audio_available(e), 0);
+  nes_destroy(e);
+}
+
+TEST(NesEnv, Rewind) {
+  auto rom = synthetic_rom();
+  NesEnv* e = nes_create();
+  EXPECT_EQ(nes_rewind(e, 1), -1);  // off
+  nes_load(e, rom.data(), static_cast<int>(rom.size()));
+  ASSERT_EQ(nes_rewind_enable(e, 1 << 20, 60), 0);
+  EXPECT_EQ(nes_rewind_depth(e), 1);  // the frame it was enabled on
+
+  const int size = nes_state_size(e);
+  std::vector<uint8_t> at40(size), now(size);
+  for (int i = 0; i < 100; i++) {
+    nes_step(e, static_cast<uint8_t>(i));
+    if (nes_frame_count(e) == 40) nes_save_state(e, at40.data(), size);
+  }
+  EXPECT_EQ(nes_rewind_depth(e), 101);
+  EXPECT_EQ(nes_rewind(e, 60), 60);
+  EXPECT_EQ(nes_frame_count(e), 40u);
+  nes_save_state(e, now.data(), size);
+  EXPECT_EQ(now, at40);
+
+  nes_load(e, rom.data(), static_cast<int>(rom.size()));
+  EXPECT_EQ(nes_rewind_depth(e), 1);
+
+  // Copying in another game drops the old history: rewinding lands on the
+  // copied frame, never on a frame of the previous ROM.
+  auto chr_ram = rom;
+  chr_ram[5] = 0;
+  chr_ram.resize(16 + 16384);
+  NesEnv* other = nes_create();
+  nes_load(other, chr_ram.data(), static_cast<int>(chr_ram.size()));
+  for (int i = 0; i < 10; i++) nes_step(other, 0);
+  for (int i = 0; i < 5; i++) nes_step(e, 0);
+  ASSERT_EQ(nes_copy_into(e, other), 0);
+  EXPECT_EQ(nes_rewind_depth(e), 1);
+  const int other_size = nes_state_size(other);
+  std::vector<uint8_t> copied(other_size), rewound(other_size);
+  nes_save_state(other, copied.data(), other_size);
+  nes_step(e, 0);
+  EXPECT_EQ(nes_rewind(e, 5), 1);
+  EXPECT_EQ(nes_frame_count(e), 10u);
+  ASSERT_EQ(nes_state_size(e), other_size);
+  nes_save_state(e, rewound.data(), other_size);
+  EXPECT_EQ(rewound, copied);
+  nes_destroy(other);
+
+  ASSERT_EQ(nes_rewind_enable(e, 0, 0), 0);
+  EXPECT_EQ(nes_rewind_depth(e), 0);
+  nes_destroy(e);
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <memory>
+#include "bus.h"
 #include "cartridge.h"
 #include "ppu.h"
 
@@ -8,7 +9,7 @@ using namespace nes;
 namespace {
 // Build a minimal NROM iNES image in memory: 1x16KB PRG, 1x8KB CHR.
 // flags6 bit0 selects mirroring (0 = horizontal, 1 = vertical).
-std::vector<u8> make_rom(bool vertical) {
+std::vector<u8> make_rom(bool vertical, u8 flags6 = 0x00) {
   std::vector<u8> bytes(16, 0);
   bytes[0] = 'N';
   bytes[1] = 'E';
@@ -16,7 +17,7 @@ std::vector<u8> make_rom(bool vertical) {
   bytes[3] = 0x1A;
   bytes[4] = 1;                      // 1 x 16KB PRG
   bytes[5] = 1;                      // 1 x 8KB CHR
-  bytes[6] = vertical ? 0x01 : 0x00; // mirroring select; mapper low nibble 0
+  bytes[6] = flags6 | (vertical ? 0x01 : 0x00); // mirroring select; mapper low nibble
   bytes[7] = 0x00;                   // mapper high nibble 0
   bytes.resize(16 + 16384 + 8192, 0);
   return bytes;
@@ -76,6 +77,35 @@ TEST_F(PPUTestMemory, VerticalMirroring) {
   EXPECT_EQ(ppu.ppu_read(0x2C00), 0x44);  // $2C00 mirrors $2400
 }
 
+// Four-screen boards back all four logical nametables with their own page.
+TEST_F(PPUTestMemory, FourScreenNametables) {
+  int status = -1;
+  auto cart = Cartridge::from_ines(make_rom(false, /*four-screen*/ 0x08), status);
+  ASSERT_EQ(status, 0);
+  ppu.insert_cartridge(cart);
+  for (int t = 0; t < 4; t++) ppu.ppu_write(0x2000 + t * 0x400 + 5, static_cast<u8>(0x10 + t));
+  for (int t = 0; t < 4; t++) EXPECT_EQ(ppu.ppu_read(0x3000 + t * 0x400 + 5), 0x10 + t);
+  EXPECT_EQ(ppu.nametable_ram()[0x0805], 0x12);
+}
+
+// A mapper mirroring write through the Bus takes effect in the PPU at once.
+TEST_F(PPUTestMemory, MapperMirroringWriteRemapsNametables) {
+  int status = -1;
+  auto cart = Cartridge::from_ines(make_rom(false, /*mapper 4*/ 0x40), status);
+  ASSERT_EQ(status, 0);
+  Bus bus;
+  bus.insert_cartridge(cart);
+  bus.reset();
+  PPU& p = bus.get_ppu();
+  bus.cpu_write(0xA000, 0x01);  // MMC3: horizontal
+  p.ppu_write(0x2000, 0x55);
+  EXPECT_EQ(p.ppu_read(0x2400), 0x55);
+  EXPECT_NE(p.ppu_read(0x2800), 0x55);
+  bus.cpu_write(0xA000, 0x00);  // vertical
+  EXPECT_EQ(p.ppu_read(0x2800), 0x55);
+  EXPECT_NE(p.ppu_read(0x2400), 0x55);
+}
+
 // $3000-$3EFF mirrors $2000-$2EFF.
 TEST_F(PPUTestMemory, NametableThreeKMirror) {
   auto cart = make_cart(true);
@@ -161,3 +161,45 @@ TEST_F(PPURenderTest, RenderPatternTableSolidTile) {
     }
   }
 }
+
+// Fine-X scroll: the background is fetched a tile at a time, so each fine-X
+// value must still pick the right bit of the right tile across every tile
+// boundary, and coarse-X must advance exactly 32 times per line.
+TEST_F(PPURenderTest, FineXScrollAcrossTileBoundaries) {
+  const u8 planes[3][2] = {{0xF0, 0x00}, {0x0F, 0xFF}, {0xA5, 0x3C}};
+  const u8 colors[4] = {0x0F, 0x16, 0x2A, 0x30};
+
+  for (u8 fine_x = 0; fine_x < 8; fine_x++) {
+    SetUp();
+    for (int t = 0; t < 3; t++) {
+      for (int row = 0; row < 8; row++) {
+        seed_chr((t + 1) * 16 + row, planes[t][0]);
+        seed_chr((t + 1) * 16 + 8 + row, planes[t][1]);
+      }
+    }
+    ppu.cpu_write(1, 0x08);
+    for (u16 i = 0; i < 4; i++) ppu_poke(0x3F00 + i, colors[i]);
+    for (u16 col = 0; col < 32; col++) ppu_poke(0x2000 + col, static_cast<u8>(col % 3 + 1));
+    for (u16 i = 0; i < 8; i++) ppu_poke(0x23C0 + i, 0x00);
+
+    ppu.cpu_write(0, 0x00);
+    ppu.cpu_write(6, 0x00);
+    ppu.cpu_write(6, 0x00);
+    ppu.cpu_write(5, fine_x);  // coarse X 0, fine X = fine_x
+    ppu.cpu_write(5, 0x00);
+    ppu.cpu_write(1, 0x0A);
+
+    for (int d = 0; d < 256; d++) ppu.clock();  // up to dot 256 (render + inc_y)
+
+    const u32* fb = ppu.framebuffer();
+    for (int x = 0; x < 256; x++) {
+      const int world = x + fine_x;
+      const int t = (world / 8) % 32 % 3;
+      const int bit = 7 - (world & 7);
+      const int pixel = (((planes[t][1] >> bit) & 1) << 1) | ((planes[t][0] >> bit) & 1);
+      ASSERT_EQ(fb[x], nes::palette_rgba(colors[pixel])) << "fine_x=" << int(fine_x) << " x=" << x;
+    }
+    // 32 coarse-X increments wrap back to column 0 of the other nametable.
+    EXPECT_EQ(ppu.vram_addr() & 0x041F, 0x0400) << "fine_x=" << int(fine_x);
+  }
+}
@@ -0,0 +1,320 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+#include "cartridge.h"
+#include "palette.h"
+#include "ppu.h"
+#include "test_cartridge.h"
+#include "test_rom.h"
+
+using nes::PPU;
+using nes::u16;
+using nes::u32;
+using nes::u64;
+using nes::u8;
+
+// Undrawn frames (set_render_interval) must leave the PPU in exactly the state
+// a drawn frame would -- status flags and scroll -- since the CPU can see them.
+class PPURenderModeTest : public ::testing::Test {
+ protected:
+  struct Machine {
+    std::shared_ptr<nes::MockCartridge> cart = std::make_shared<nes::MockCartridge>();
+    PPU ppu;
+    Machine() {
+      ppu.insert_cartridge(cart);
+      ppu.reset();
+    }
+    void poke(u16 addr, u8 value) {
+      ppu.cpu_write(6, (addr >> 8) & 0x3F);
+      ppu.cpu_write(6, addr & 0xFF);
+      ppu.cpu_write(7, value);
+    }
+  };
+
+  // The same random scene on both machines: CHR, nametables, OAM (sprite 0
+  // kept on screen so hits are common), scroll, and PPUCTRL/PPUMASK bits.
+  void seed(u32 trial) {
+    std::mt19937 rng(trial);
+    auto byte = [&]() { return static_cast<u8>(rng()); };
+    u8 chr[0x2000], nt[0x800], oam[256];
+    for (u8& b : chr) b = (rng() % 3) ? byte() : 0;  // leave some transparency
+    for (u8& b : nt) b = byte();
+    for (u8& b : oam) b = byte();
+    oam[0] = static_cast<u8>(rng() % 230);
+    const u8 ctrl = byte() & 0x38;                   // sprite/BG tables, 8x16
+    const u8 mask = (byte() & 0x1E) | 0x18;          // both layers, random left-8 bits
+    const u8 scroll_x = byte(), scroll_y = static_cast<u8>(rng() % 240);
+
+    for (Machine* m : {&drawn, &undrawn}) {
+      for (int i = 0; i < 0x2000; i++) m->cart->_chr_memory[i] = chr[i];
+      for (u16 i = 0; i < 0x800; i++) m->poke(0x2000 + i, nt[i]);
+      m->ppu.cpu_write(3, 0);
+      for (u8 b : oam) m->ppu.cpu_write(4, b);
+      m->ppu.cpu_write(0, ctrl);
+      m->ppu.cpu_write(5, scroll_x);
+      m->ppu.cpu_write(5, scroll_y);
+      m->ppu.cpu_write(1, (trial % 4 == 0) ? (mask & ~0x08) : mask);  // sometimes sprites only
+    }
+    undrawn.ppu.set_render_interval(0);
+  }
+
+  Machine drawn;
+  Machine undrawn;
+};
+
+TEST_F(PPURenderModeTest, UndrawnFramesKeepStatusAndScroll) {
+  int hits = 0;
+  for (u32 trial = 0; trial < 64; trial++) {
+    drawn = Machine();
+    undrawn = Machine();
+    seed(trial);
+    for (int frame = 0; frame < 2; frame++) {
+      for (int line = 0; line < 262; line++) {
+        for (int d = 0; d < 341; d++) {
+          drawn.ppu.clock();
+          undrawn.ppu.clock();
+        }
+        ASSERT_EQ(drawn.ppu.reg_status(), undrawn.ppu.reg_status())
+            << "trial " << trial << " frame " << frame << " line " << line;
+        ASSERT_EQ(drawn.ppu.vram_addr(), undrawn.ppu.vram_addr())
+            << "trial " << trial << " frame " << frame << " line " << line;
+        if (line == 239 && (drawn.ppu.reg_status() & 0x40)) hits++;
+      }
+    }
+    // Nothing was drawn: the frame is still the post-reset blank one.
+    for (int i = 0; i < 256 * 240; i++) ASSERT_EQ(undrawn.ppu.pixels()[i], nes::BLANK_PIXEL);
+  }
+  EXPECT_GT(hits, 8) << "too few scenes exercised a sprite-0 hit";
+}
+
+// Interval N draws only the frames that end with frame_count() % N == 0.
+TEST_F(PPURenderModeTest, EveryNthFrameIsDrawn) {
+  Machine m;
+  m.ppu.set_render_interval(3);
+  u8 shown = nes::BLANK_PIXEL;
+  for (u8 frame = 0; frame < 10; frame++) {
+    const u8 color = static_cast<u8>(frame + 1);
+    m.poke(0x3F00, color);  // rendering is off, so every line is the backdrop
+    const u32 start = m.ppu.frame_count();
+    while (m.ppu.frame_count() == start) m.ppu.clock();
+    if (m.ppu.frame_count() % 3 == 0) shown = color;
+    EXPECT_EQ(m.ppu.pixels()[0], shown) << "frame " << int(frame);
+    EXPECT_EQ(m.ppu.pixels()[256 * 240 - 1], shown) << "frame " << int(frame);
+  }
+}
+
+namespace {
+// iNES image for the deferred-rendering tests: mapper 0 with CHR-RAM, or
+// MMC3 with 32KB of CHR-ROM to bank-switch mid-frame.
+std::shared_ptr<nes::Cartridge> make_cart(bool chr_ram, u32 seed) {
+  nes::TestRom rom(2, chr_ram ? 0 : 4, chr_ram ? 0 : 4);
+  std::mt19937 rng(seed);
+  for (int i = 0; i < rom.chr_size(); i++) rom.chr()[i] = static_cast<u8>(rng() % 3 ? rng() : 0);
+  auto cart = rom.cartridge();
+  EXPECT_TRUE(cart);
+  return cart;
+}
+}  // namespace
+
+// Frames drawn later on worker threads (set_render_threads) come out exactly
+// as frames drawn line by line, with palette, OAM, scroll, PPUCTRL/PPUMASK,
+// nametable, CHR-RAM and CHR bank changes landing between lines, and the
+// CPU-visible flags match line for line.
+TEST(PPUDeferredRenderTest, MatchesInlineDrawingWithMidFrameChanges) {
+  for (u32 trial = 0; trial < 12; trial++) {
+    const bool chr_ram = trial % 2 == 0;
+    PPU ppus[3];
+    std::shared_ptr<nes::Cartridge> carts[3];
+    for (int i = 0; i < 3; i++) {
+      carts[i] = make_cart(chr_ram, trial);
+      ppus[i].insert_cartridge(carts[i]);
+      ppus[i].reset();
+    }
+    ppus[1].set_render_threads(1);
+    ppus[2].set_render_threads(3);
+
+    std::mt19937 rng(trial);
+    auto poke = [&](u16 addr, u8 value) {
+      for (PPU& ppu : ppus) {
+        ppu.cpu_write(6, (addr >> 8) & 0x3F);
+        ppu.cpu_write(6, addr & 0xFF);
+        ppu.cpu_write(7, value);
+      }
+    };
+    for (u16 a = 0; a < 0x1000; a++) poke(0x2000 + a, static_cast<u8>(rng()));
+    for (u16 a = 0; a < 32; a++) poke(0x3F00 + a, static_cast<u8>(rng() & 0x3F));
+    if (chr_ram) {
+      for (u16 a = 0; a < 0x2000; a++) poke(a, static_cast<u8>(rng() % 3 ? rng() : 0));
+    }
+    u8 oam[256];
+    for (int i = 0; i < 256; i++) oam[i] = static_cast<u8>(i % 4 == 0 ? rng() % 200 : rng());
+    for (PPU& ppu : ppus) {
+      ppu.cpu_write(3, 0);
+      for (u8 b : oam) ppu.cpu_write(4, b);
+    }
+
+    for (int frame = 0; frame < 4; frame++) {
+      for (int line = 0; line < 262; line++) {
+        for (PPU& ppu : ppus) ppu.run(341);
+        for (int i = 1; i < 3; i++) {
+          ASSERT_EQ(ppus[0].reg_status(), ppus[i].reg_status()) << "trial " << trial << " line " << line;
+          ASSERT_EQ(ppus[0].vram_addr(), ppus[i].vram_addr()) << "trial " << trial << " line " << line;
+        }
+
+        // Something changes between most lines.
+        const u32 r = rng();
+        const u8 value = static_cast<u8>(r >> 8);
+        switch (r % 8) {
+          case 0: poke(0x3F00 + (value & 0x1F), value & 0x3F); break;
+          case 1: poke(0x2000 + (r >> 16) % 0x1000, value); break;
+          case 2:
+            for (PPU& ppu : ppus) {
+              ppu.cpu_write(3, value);
+              ppu.cpu_write(4, static_cast<u8>(r >> 16));
+            }
+            break;
+          case 3:
+            for (PPU& ppu : ppus) {
+              ppu.cpu_write(5, value);
+              ppu.cpu_write(5, static_cast<u8>((r >> 16) % 240));
+            }
+            break;
+          case 4:
+            for (PPU& ppu : ppus) ppu.cpu_write(0, value & 0x3B);
+            break;
+          case 5:
+            for (PPU& ppu : ppus) ppu.cpu_write(1, static_cast<u8>((value & 0x1E) | 0x18));
+            break;
+          default:
+            if (chr_ram) {
+              poke((r >> 16) & 0x1FFF, value);
+            } else {
+              for (auto& cart : carts) {
+                cart->cpu_write(0x8000, value & 0x07);  // select R0-R5: CHR banks
+                cart->cpu_write(0x8001, static_cast<u8>(r >> 16));
+              }
+            }
+            break;
+        }
+      }
+      for (int i = 1; i < 3; i++) {
+        ASSERT_EQ(0, std::memcmp(ppus[0].pixels(), ppus[i].pixels(), 256 * 240))
+            << "trial " << trial << " frame " << frame << " threads " << (i == 1 ? 1 : 3);
+      }
+    }
+  }
+}
+
+// Turning render threads on mid-frame draws the rest of that frame inline;
+// reset() drops a frame still being drawn.
+TEST(PPUDeferredRenderTest, SwitchingModesMidFrame) {
+  PPU ppu;
+  ppu.insert_cartridge(make_cart(true, 1));
+  ppu.reset();
+  ppu.cpu_write(6, 0x3F);
+  ppu.cpu_write(6, 0x00);
+  ppu.cpu_write(7, 0x21);
+  ppu.run(341 * 100);
+  ppu.set_render_threads(2);
+  ppu.run(341 * 162);
+  for (int i = 0; i < 256 * 240; i++) ASSERT_EQ(ppu.pixels()[i], 0x21) << i;
+
+  ppu.run(341 * 241);  // a whole frame recorded and submitted
+  ppu.reset();
+  EXPECT_EQ(ppu.pixels()[0], nes::BLANK_PIXEL);
+  ppu.set_render_threads(0);
+}
+
+// Lines whose inputs are unchanged since they were last drawn are reused;
+// any change to what a line reads redraws it, and the frame always matches
+// one drawn without reuse (the deferred renderer never reuses lines).
+TEST(PPULineReuseTest, ReusesOnlyUnchangedLines) {
+  auto cart = make_cart(/*chr_ram*/ true, 7);
+  auto reference_cart = make_cart(/*chr_ram*/ true, 7);
+  PPU ppu, reference;
+  ppu.insert_cartridge(cart);
+  reference.insert_cartridge(reference_cart);
+  reference.set_render_threads(1);
+
+  // Writes land in vblank with rendering off; $2006 = 0 leaves scroll at 0,0.
+  auto write = [&](std::initializer_list<std::pair<u16, u8>> pokes) {
+    for (PPU* p : {&ppu, &reference}) {
+      p->cpu_write(1, 0x00);
+      for (const auto& [addr, value] : pokes) {
+        p->cpu_write(6, (addr >> 8) & 0x3F);
+        p->cpu_write(6, addr & 0xFF);
+        p->cpu_write(7, value);
+      }
+      p->cpu_write(6, 0);
+      p->cpu_write(6, 0);
+      p->cpu_write(1, 0x1E);
+    }
+  };
+  // Run both to the next vblank and check the frames match; returns how many
+  // lines were redrawn.
+  auto frame = [&]() {
+    const u64 drawn = ppu.lines_drawn();
+    for (PPU* p : {&ppu, &reference}) {
+      while (p->scanline() == 241) p->clock();
+      while (p->scanline() != 241) p->clock();
+    }
+    EXPECT_EQ(0, std::memcmp(ppu.pixels(), reference.pixels(), 256 * 240));
+    return ppu.lines_drawn() - drawn;
+  };
+
+  for (PPU* p : {&ppu, &reference}) {
+    p->reset();
+    while (p->scanline() != 241) p->clock();
+  }
+  std::mt19937 rng(7);
+  std::vector<std::pair<u16, u8>> scene;
+  for (u16 i = 0; i < 0x1000; i++) scene.push_back({i, static_cast<u8>(rng())});          // CHR-RAM
+  for (u16 i = 0; i < 0x400; i++) scene.push_back({0x2000 + i, static_cast<u8>(rng())});  // nametable 0
+  for (u16 i = 0; i < 32; i++) scene.push_back({0x3F00 + i, static_cast<u8>(rng() & 0x3F)});
+  u8 oam[256];
+  for (int i = 0; i < 256; i++) oam[i] = static_cast<u8>(i < 64 ? rng() % 200 : 0xF0);  // 16 sprites
+  for (PPU* p : {&ppu, &reference}) {
+    p->cpu_write(1, 0x00);
+    for (const auto& [addr, value] : scene) {
+      p->cpu_write(6, (addr >> 8) & 0x3F);
+      p->cpu_write(6, addr & 0xFF);
+      p->cpu_write(7, value);
+    }
+    p->cpu_write(3, 0);
+    for (u8 b : oam) p->cpu_write(4, b);
+    p->cpu_write(6, 0);
+    p->cpu_write(6, 0);
+    p->cpu_write(1, 0x1E);
+  }
+
+  EXPECT_EQ(frame(), 240u);
+  EXPECT_EQ(frame(), 0u);  // a static screen is all reuse
+  EXPECT_EQ(ppu.lines_reused(), 240u);
+
+  write({{0x2000 + 5 * 32 + 3, 0x42}});  // one tile of row 5
+  EXPECT_EQ(frame(), 8u);
+  write({{0x23C0 + 2 * 8 + 1, 0xA5}});  // one attribute byte: tile rows 8-11
+  EXPECT_EQ(frame(), 32u);
+  write({{0x3F00, 0x21}});  // the backdrop: every line
+  EXPECT_EQ(frame(), 240u);
+  EXPECT_EQ(frame(), 0u);
+
+  // A CHR-RAM write can change any line using that tile, so all are redrawn.
+  write({{0x0013, 0xFF}});
+  EXPECT_EQ(frame(), 240u);
+
+  for (PPU* p : {&ppu, &reference}) {  // move sprite 1 down a line
+    p->cpu_write(3, 4);
+    p->cpu_write(4, static_cast<u8>(p->oam_read() + 1));
+  }
+  EXPECT_GT(frame(), 0u);
+  EXPECT_EQ(frame(), 0u);
+
+  ppu.reset();
+  EXPECT_EQ(ppu.lines_reused(), 0u);
+  EXPECT_EQ(ppu.lines_drawn(), 0u);
+}
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <array>
 #include <memory>
+#include <random>
 #include "bus.h"
 #include "palette.h"
 #include "ppu.h"
@@ -202,6 +203,60 @@ TEST_F(PPUSpriteTest, OverflowFlag) {
   EXPECT_EQ(ppu.reg_status() & 0x20, 0x20) << "overflow should be set with 9 sprites";
 }
 
+// Sprite evaluation is indexed per frame; the overflow flag must still rise on
+// exactly the first line with a 9th in-range sprite, for either sprite size.
+TEST_F(PPUSpriteTest, OverflowMatchesBruteForceEvaluation) {
+  std::mt19937 rng(7);
+  for (int trial = 0; trial < 40; trial++) {
+    SetUp();
+    const bool tall = trial & 1;
+    u8 oam[256];
+    for (int i = 0; i < 256; i++) oam[i] = static_cast<u8>(rng());
+    for (int s = 0; s < 64; s++) oam[s * 4] = static_cast<u8>(rng() % 4 ? rng() % 120 : 0xF0 + rng() % 16);
+    ppu.cpu_write(3, 0);
+    for (u8 b : oam) ppu.cpu_write(4, b);
+    ppu.cpu_write(0, tall ? 0x20 : 0x00);
+    ppu.cpu_write(1, 0x14);
+
+    int first = 240;  // first line with more than 8 sprites in range
+    for (int line = 0; line < 240 && first == 240; line++) {
+      int count = 0;
+      for (int s = 0; s < 64; s++) {
+        const int row = line - oam[s * 4] - 1;
+        if (row >= 0 && row < (tall ? 16 : 8)) count++;
+      }
+      if (count > 8) first = line;
+    }
+    for (int line = 0; line < 240; line++) {
+      render_line(line);
+      ASSERT_EQ((ppu.reg_status() & 0x20) != 0, line >= first) << "trial " << trial << " line " << line;
+    }
+  }
+}
+
+// OAM writes and a PPUCTRL sprite-size change mid-frame take effect on the
+// next line drawn.
+TEST_F(PPUSpriteTest, MidFrameOamAndSizeChanges) {
+  seed_solid_tile(2, 1);
+  seed_solid_tile(3, 1);
+  ppu_poke(0x3F11, 0x30);
+  ppu.cpu_write(1, 0x14);
+  set_sprite(0, 49, 2, 0x00, 20);
+  render_line(50);
+  EXPECT_EQ(px(50, 20), nes::palette_rgba(0x30));
+
+  set_sprite(0, 99, 2, 0x00, 60);  // move it further down the same frame
+  render_line(100);
+  EXPECT_NE(px(100, 20), nes::palette_rgba(0x30));
+  EXPECT_EQ(px(100, 60), nes::palette_rgba(0x30));
+
+  render_line(108);  // past the bottom of an 8x8 sprite
+  EXPECT_NE(px(108, 60), nes::palette_rgba(0x30));
+  ppu.cpu_write(0, 0x20);  // 8x16: lines 100..115
+  render_line(112);
+  EXPECT_EQ(px(112, 60), nes::palette_rgba(0x30));
+}
+
 // OAM DMA ($4014) copies a CPU page into OAM and stalls the CPU.
 TEST_F(PPUSpriteTest, OamDmaCopiesPage) {
   nes::Bus bus;
@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
+#include <cstring>
+#include <memory>
+#include <random>
+#include "cartridge.h"
 #include "ppu.h"
+#include "test_rom.h"
 
 using nes::PPU;
 using nes::u8;
@@ -91,3 +96,64 @@ TEST_F(PPUTimingTest, VBlankClearedAtPreRenderDot1) {
   EXPECT_EQ(ppu.dot(), 1u);
   EXPECT_EQ(ppu.reg_status() & 0x80, 0x00);
 }
+
+// run(n) jumps between the dots that matter; it must be indistinguishable from
+// n clock() calls however the dots are chunked, with register writes and MMC3
+// scanline IRQs landing between the chunks.
+TEST(PPURunTest, RunMatchesClockDotForDot) {
+  nes::TestRom rom(2, 1, 4);  // MMC3
+  std::mt19937 rng(42);
+  for (int i = 0; i < rom.chr_size(); i++) rom.chr()[i] = static_cast<u8>(rng());
+
+  PPU clocked, batched;
+  std::shared_ptr<nes::Cartridge> carts[2];
+  PPU* ppus[2] = {&clocked, &batched};
+  for (int i = 0; i < 2; i++) {
+    carts[i] = rom.cartridge();
+    ASSERT_TRUE(carts[i]);
+    ppus[i]->insert_cartridge(carts[i]);
+    ppus[i]->reset();
+    carts[i]->cpu_write(0xC000, 7);  // IRQ every 8 scanlines
+    carts[i]->cpu_write(0xC001, 0);
+    carts[i]->cpu_write(0xE001, 0);
+  }
+
+  int nmis = 0, irqs = 0;
+  while (clocked.frame_count() < 8) {
+    const u32 n = 1 + rng() % (rng() % 4 ? 40 : 3000);
+    for (u32 i = 0; i < n; i++) clocked.clock();
+    batched.run(n);
+
+    ASSERT_EQ(clocked.scanline(), batched.scanline());
+    ASSERT_EQ(clocked.dot(), batched.dot());
+    ASSERT_EQ(clocked.frame_count(), batched.frame_count());
+    ASSERT_EQ(clocked.reg_status(), batched.reg_status());
+    ASSERT_EQ(clocked.vram_addr(), batched.vram_addr());
+    const bool nmi = clocked.take_nmi();
+    ASSERT_EQ(nmi, batched.take_nmi());
+    nmis += nmi;
+    ASSERT_EQ(carts[0]->irq_pending(), carts[1]->irq_pending());
+    ASSERT_EQ(carts[0]->scanlines_until_irq(), carts[1]->scanlines_until_irq());
+    if (carts[0]->irq_pending()) {
+      irqs++;
+      for (auto& cart : carts) cart->irq_clear();
+    }
+
+    // Some register traffic between chunks, the same on both.
+    const u32 r = rng();
+    u16 reg = 0;
+    u8 value = static_cast<u8>(r >> 8);
+    switch (r % 8) {
+      case 0: reg = 0; value &= 0xBC; value |= 0x80; break;  // PPUCTRL, NMI on
+      case 1: reg = 1; value = (value & 0x1E) | 0x08; break;  // PPUMASK, BG on
+      case 2: reg = 5; break;
+      case 3: reg = 6; break;
+      case 4: reg = 7; break;
+      default: continue;
+    }
+    for (PPU* ppu : ppus) ppu->cpu_write(reg, value);
+  }
+  EXPECT_GT(nmis, 4);
+  EXPECT_GT(irqs, 100);
+  EXPECT_EQ(0, std::memcmp(clocked.pixels(), batched.pixels(), 256 * 240));
+}
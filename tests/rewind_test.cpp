@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "bus.h"
+#include "debugger.h"
+#include "rewind.h"
+#include "test_rom.h"
+
+using namespace nes;
+
+// Rewind keeps deltas between pushed snapshots in a fixed ring; whatever it
+// has had to evict, rewinding must land on exactly the state that was pushed.
+// The program changes a little of everything each frame: a work-RAM counter
+// and table, a nametable byte and a CHR-RAM byte from the NMI handler.
+class RewindTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    auto cart = program().cartridge();
+    ASSERT_TRUE(cart);
+    bus.insert_cartridge(cart);
+    bus.reset();
+    dbg.reset_to_vector();
+  }
+
+  // 16KB PRG, CHR-RAM, mapper 0.
+  static TestRom program() {
+    TestRom rom(1, 0);
+    rom.emit({0x78, 0xA2, 0xFF, 0x9A});              // SEI; LDX #$FF; TXS
+    rom.emit({0xA9, 0x80, 0x8D, 0x00, 0x20});        // LDA #$80; STA $2000 (NMI on)
+    rom.emit({0xA9, 0x1E, 0x8D, 0x01, 0x20});        // LDA #$1E; STA $2001 (rendering on)
+    const u16 loop = rom.pc();
+    rom.emit({0xE6, 0x00, 0xA6, 0x00, 0x8A});        // INC $00; LDX $00; TXA
+    rom.emit({0x9D, 0x00, 0x04});                    // STA $0400,X
+    rom.emit({0x4C, static_cast<u8>(loop), static_cast<u8>(loop >> 8)});  // JMP loop
+    const u16 nmi = rom.pc();
+    rom.emit({0xE6, 0x01});                          // INC $01
+    rom.emit({0xA9, 0x20, 0x8D, 0x06, 0x20});        // LDA #$20; STA $2006
+    rom.emit({0xA5, 0x01, 0x8D, 0x06, 0x20});        // LDA $01; STA $2006
+    rom.emit({0x8D, 0x07, 0x20});                    // STA $2007 (nametable)
+    rom.emit({0xA9, 0x00, 0x8D, 0x06, 0x20});        // LDA #$00; STA $2006
+    rom.emit({0xA5, 0x01, 0x8D, 0x06, 0x20});        // LDA $01; STA $2006
+    rom.emit({0x8D, 0x07, 0x20});                    // STA $2007 (CHR-RAM)
+    rom.emit({0xA9, 0x00, 0x8D, 0x05, 0x20});        // LDA #$00; STA $2005
+    rom.emit({0x8D, 0x05, 0x20, 0x40});              // STA $2005; RTI
+    rom.vectors(nmi, 0xC000, 0xC000);
+    return rom;
+  }
+
+  // Run `frames` frames, pushing after each and keeping every state.
+  void play(Rewind& rewind, int frames) {
+    for (int i = 0; i < frames; i++) {
+      dbg.run_frame();
+      ASSERT_TRUE(rewind.push(bus));
+      states.push_back(snapshot(bus));
+    }
+  }
+
+  Bus bus;
+  Debugger dbg{bus.get_cpu(), bus};
+  std::vector<std::vector<u8>> states;
+};
+
+TEST_F(RewindTest, RestoresEarlierFramesAndReplays) {
+  Rewind rewind(1 << 20, 10);
+  play(rewind, 100);
+  EXPECT_EQ(rewind.depth(), 100u);
+  // Deltas of this program are tiny next to the 70+ KB snapshot.
+  EXPECT_LT(rewind.used(), 100 * bus.state_size() / 10);
+
+  EXPECT_EQ(rewind.rewind(bus, 37), 37);
+  EXPECT_EQ(rewind.depth(), 63u);
+  EXPECT_EQ(snapshot(bus), states[62]);
+  EXPECT_EQ(rewind.rewind(bus, 0), 0);
+  EXPECT_EQ(snapshot(bus), states[62]);
+
+  // Play resumes from there exactly as it first did, and the history carries
+  // on from the rewound frame.
+  for (int i = 63; i < 80; i++) {
+    dbg.run_frame();
+    ASSERT_TRUE(rewind.push(bus));
+    ASSERT_EQ(snapshot(bus), states[i]) << "frame " << i;
+  }
+  EXPECT_EQ(rewind.rewind(bus, 1000), 79);  // clamped to the oldest frame
+  EXPECT_EQ(snapshot(bus), states[0]);
+  EXPECT_EQ(rewind.depth(), 1u);
+}
+
+// Far more frames than fit: the ring stays within its budget, drops the
+// oldest frames a keyframe group at a time, and what it keeps still decodes.
+TEST_F(RewindTest, StaysWithinBudget) {
+  Rewind rewind(24 * 1024, 30);
+  play(rewind, 600);
+  EXPECT_LE(rewind.used(), rewind.budget());
+  const u32 depth = rewind.depth();
+  EXPECT_GT(depth, 30u);
+  EXPECT_LT(depth, 600u);
+
+  EXPECT_EQ(rewind.rewind(bus, 45), 45);
+  EXPECT_EQ(snapshot(bus), states[599 - 45]);
+  EXPECT_EQ(rewind.rewind(bus, depth), static_cast<int>(depth - 46));
+  EXPECT_EQ(snapshot(bus), states[600 - depth]);
+}
+
+TEST_F(RewindTest, BudgetTooSmallForAKeyframe) {
+  Rewind rewind(16);
+  dbg.run_frame();
+  EXPECT_FALSE(rewind.push(bus));
+  EXPECT_EQ(rewind.depth(), 0u);
+  EXPECT_EQ(rewind.rewind(bus, 1), -1);
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <vector>
+#include "bus.h"
+#include "debugger.h"
+#include "run_ahead.h"
+#include "test_rom.h"
+
+using namespace nes;
+
+// Run-ahead must leave the machine (and its sound) exactly as if it had never
+// run, while showing the frame the machine would draw N frames later with the
+// same input. The program reads the pad in its NMI handler and, while A is
+// held, advances a counter that it writes to a nametable byte and to the
+// pulse channel's period.
+class RunAheadTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const TestRom rom = program();
+    for (Bus* bus : {&real, &plain, &ahead}) {
+      auto cart = rom.cartridge();
+      ASSERT_TRUE(cart);
+      bus->insert_cartridge(cart);
+      bus->reset();
+    }
+    real_dbg.reset_to_vector();
+    plain_dbg.reset_to_vector();
+  }
+
+  // 16KB PRG + 8KB CHR, mapper 0.
+  static TestRom program() {
+    TestRom rom(1, 1);
+    for (int i = 0; i < rom.chr_size(); i++) rom.chr()[i] = static_cast<u8>(i * 37 + (i >> 8));
+    rom.emit({0x78, 0xA2, 0xFF, 0x9A});              // SEI; LDX #$FF; TXS
+    rom.emit({0xA9, 0x01, 0x8D, 0x15, 0x40});        // LDA #$01; STA $4015 (pulse 1 on)
+    rom.emit({0xA9, 0xBF, 0x8D, 0x00, 0x40});        // LDA #$BF; STA $4000
+    rom.emit({0xA9, 0x08, 0x8D, 0x03, 0x40});        // LDA #$08; STA $4003
+    rom.emit({0xA9, 0x3F, 0x8D, 0x06, 0x20});        // LDA #$3F; STA $2006
+    rom.emit({0xA9, 0x00, 0x8D, 0x06, 0x20});        // LDA #$00; STA $2006
+    for (u8 colour : {0x0F, 0x30, 0x16, 0x27}) {
+      rom.emit({0xA9, colour, 0x8D, 0x07, 0x20});    // LDA #colour; STA $2007 (palette)
+    }
+    rom.emit({0xA9, 0x80, 0x8D, 0x00, 0x20});        // LDA #$80; STA $2000 (NMI on)
+    rom.emit({0xA9, 0x1E, 0x8D, 0x01, 0x20});        // LDA #$1E; STA $2001 (rendering on)
+    const u16 loop = rom.pc();
+    rom.emit({0x4C, static_cast<u8>(loop), static_cast<u8>(loop >> 8)});  // JMP loop
+    const u16 nmi = rom.pc();
+    rom.emit({0xA9, 0x01, 0x8D, 0x16, 0x40});        // LDA #$01; STA $4016 (strobe)
+    rom.emit({0xA9, 0x00, 0x8D, 0x16, 0x40});        // LDA #$00; STA $4016
+    rom.emit({0xAD, 0x16, 0x40, 0x29, 0x01});        // LDA $4016; AND #$01 (A button)
+    rom.emit({0x18, 0x65, 0x01, 0x85, 0x01});        // CLC; ADC $01; STA $01
+    rom.emit({0x8D, 0x02, 0x40});                    // STA $4002 (pulse period)
+    rom.emit({0xA9, 0x20, 0x8D, 0x06, 0x20});        // LDA #$20; STA $2006
+    rom.emit({0xA5, 0x01, 0x8D, 0x06, 0x20});        // LDA $01; STA $2006
+    rom.emit({0x8D, 0x07, 0x20});                    // STA $2007 (nametable)
+    rom.emit({0xA9, 0x00, 0x8D, 0x05, 0x20});        // LDA #$00; STA $2005
+    rom.emit({0x8D, 0x05, 0x20, 0x40});              // STA $2005; RTI
+    rom.vectors(nmi, 0xC000, 0xC000);
+    return rom;
+  }
+
+  static std::vector<float> drain(Bus& bus) {
+    std::vector<float> out(8192);
+    out.resize(bus.get_apu().drain(out.data(), static_cast<int>(out.size())));
+    return out;
+  }
+
+  Bus real, plain, ahead;  // with run-ahead; without; the reference frames ahead
+  Debugger real_dbg{real.get_cpu(), real};
+  Debugger plain_dbg{plain.get_cpu(), plain};
+  Debugger ahead_dbg{ahead.get_cpu(), ahead};
+};
+
+TEST_F(RunAheadTest, ShowsTheFrameAheadAndLeavesTheMachineAlone) {
+  RunAhead run_ahead;
+  run_ahead.set_frames(2);
+  int ahead_of_real = 0;
+  for (int i = 0; i < 40; i++) {
+    const u8 buttons = i % 7 < 3 ? 0x01 : 0x00;
+    real.set_controller(0, buttons);
+    plain.set_controller(0, buttons);
+    ASSERT_EQ(real_dbg.run_frame(), 0);
+    ASSERT_EQ(plain_dbg.run_frame(), 0);
+    run_ahead.run(real);
+    ASSERT_TRUE(run_ahead.shown());
+
+    ASSERT_EQ(snapshot(real), snapshot(plain)) << "frame " << i;
+    ASSERT_EQ(drain(real), drain(plain)) << "frame " << i;  // same sound, no seams
+
+    std::vector<u8> s = snapshot(plain);
+    ASSERT_TRUE(ahead.load_state(s.data(), s.size()));
+    ahead_dbg.run_frame();
+    ahead_dbg.run_frame();
+    ASSERT_EQ(0, std::memcmp(run_ahead.framebuffer(), ahead.get_ppu().framebuffer(), 256 * 240 * 4))
+        << "frame " << i;
+    if (std::memcmp(run_ahead.framebuffer(), real.get_ppu().framebuffer(), 256 * 240 * 4) != 0) ahead_of_real++;
+  }
+  // While A is held the picture ahead shows counts the real frame has not reached.
+  EXPECT_GT(ahead_of_real, 10);
+}
+
+// Restoring the real frame must not cost the next one its unchanged lines.
+TEST_F(RunAheadTest, KeepsReusingUnchangedLines) {
+  RunAhead run_ahead;
+  run_ahead.set_frames(1);
+  for (int i = 0; i < 5; i++) {
+    real_dbg.run_frame();
+    run_ahead.run(real);
+  }
+  const u64 reused = real.get_ppu().lines_reused();
+  const u64 drawn = real.get_ppu().lines_drawn();
+  real_dbg.run_frame();
+  EXPECT_EQ(real.get_ppu().lines_reused() - reused, 240u);
+  EXPECT_EQ(real.get_ppu().lines_drawn(), drawn);
+  for (int i = 0; i < 6; i++) plain_dbg.run_frame();
+  EXPECT_EQ(snapshot(real), snapshot(plain));  // the reused lines are the right ones
+}
+
+TEST_F(RunAheadTest, OffByDefault) {
+  RunAhead run_ahead;
+  real_dbg.run_frame();
+  const std::vector<u8> before = snapshot(real);
+  run_ahead.run(real);
+  EXPECT_FALSE(run_ahead.shown());
+  EXPECT_EQ(snapshot(real), before);
+
+  run_ahead.set_frames(1);
+  run_ahead.run(real);
+  EXPECT_TRUE(run_ahead.shown());
+  run_ahead.discard();
+  EXPECT_FALSE(run_ahead.shown());
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include "mapper_mmc3.h"
+#include "scheduler.h"
+
+using namespace nes;
+
+TEST(SchedulerTest, EmptyHasNoDeadline) {
+  Scheduler s;
+  Scheduler::Event e;
+  EXPECT_EQ(s.next_deadline(), Scheduler::NEVER);
+  EXPECT_FALSE(s.pop_due(Scheduler::NEVER, e));
+}
+
+// Events pop in deadline order, and only once due.
+TEST(SchedulerTest, PopsInDeadlineOrder) {
+  Scheduler s;
+  s.schedule(Scheduler::FRAME_END, 300);
+  s.schedule(Scheduler::VBLANK_NMI, 100);
+  s.schedule(Scheduler::MAPPER_IRQ, 200);
+  EXPECT_EQ(s.next_deadline(), 100u);
+
+  Scheduler::Event e;
+  EXPECT_FALSE(s.pop_due(99, e));
+  ASSERT_TRUE(s.pop_due(250, e));
+  EXPECT_EQ(e, Scheduler::VBLANK_NMI);
+  ASSERT_TRUE(s.pop_due(250, e));
+  EXPECT_EQ(e, Scheduler::MAPPER_IRQ);
+  EXPECT_FALSE(s.pop_due(250, e));
+  EXPECT_EQ(s.next_deadline(), 300u);
+}
+
+// Re-posting moves an event instead of duplicating it; cancel removes it.
+TEST(SchedulerTest, RescheduleAndCancel) {
+  Scheduler s;
+  s.schedule(Scheduler::VBLANK_NMI, 100);
+  s.schedule(Scheduler::MAPPER_IRQ, 200);
+  s.schedule(Scheduler::VBLANK_NMI, 500);
+  EXPECT_EQ(s.next_deadline(), 200u);
+  EXPECT_EQ(s.when(Scheduler::VBLANK_NMI), 500u);
+
+  s.cancel(Scheduler::MAPPER_IRQ);
+  EXPECT_FALSE(s.pending(Scheduler::MAPPER_IRQ));
+  EXPECT_EQ(s.next_deadline(), 500u);
+
+  s.clear();
+  EXPECT_EQ(s.next_deadline(), Scheduler::NEVER);
+}
+
+// The MMC3 prediction agrees with actually pulsing the counter.
+TEST(SchedulerTest, Mmc3PredictsTheFiringScanline) {
+  for (u8 latch : {0, 1, 5, 255}) {
+    MapperMMC3 m(2, 1);
+    u32 unused;
+    m.cpu_write(0xC000, latch, unused);  // latch
+    m.cpu_write(0xC001, 0, unused);      // reload
+    m.cpu_write(0xE001, 0, unused);      // enable
+    for (int round = 0; round < 3; round++) {
+      const int predicted = m.scanlines_until_irq();
+      ASSERT_GT(predicted, 0);
+      for (int line = 1; line <= predicted; line++) {
+        EXPECT_FALSE(m.irq_pending()) << "latch " << int(latch) << " line " << line;
+        m.scanline();
+      }
+      EXPECT_TRUE(m.irq_pending()) << "latch " << int(latch);
+      m.irq_clear();
+    }
+  }
+  MapperMMC3 disabled(2, 1);
+  EXPECT_EQ(disabled.scanlines_until_irq(), 0);
+}
@@ -36,6 +36,13 @@ class MockCartridge : public nes::Cartridge {
     return false;
   }
 
+  // Reads of $8000-$FFFF come straight from the flat memory; writes keep
+  // going through cpu_write() above.
+  const u8* cpu_read_page(u16 address) const override {
+    return address >= 0x8000 ? &_mem[address & 0xFC00] : nullptr;
+  }
+  u8* cpu_write_page(u16 /*address*/) override { return nullptr; }
+
  private:
   std::array<u8, 0x10000> _mem{};
 };
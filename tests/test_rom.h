@@ -0,0 +1,66 @@
+#pragma once
+#include <initializer_list>
+#include <memory>
+#include <vector>
+#include "bus.h"
+#include "cartridge.h"
+
+namespace nes {
+
+// iNES image for tests that run a small program on a real board. The header
+// comes from the bank counts (no CHR banks = CHR-RAM) and the mapper number.
+// emit() assembles at pc(), which starts at $C000 (org() moves it); code and
+// vectors live in $C000-$FFFF, the last 16KB of PRG, which mappers 0 and 4
+// keep mapped there.
+class TestRom {
+ public:
+  TestRom(u8 prg_banks, u8 chr_banks, u8 mapper = 0)
+    : _prg_size(prg_banks * 0x4000), _chr_size(chr_banks * 0x2000), _image(16 + _prg_size + _chr_size, 0) {
+    _image[0] = 'N'; _image[1] = 'E'; _image[2] = 'S'; _image[3] = 0x1A;
+    _image[4] = prg_banks;  // 16KB PRG banks
+    _image[5] = chr_banks;  // 8KB CHR banks
+    _image[6] = static_cast<u8>((mapper & 0x0F) << 4);
+    _image[7] = static_cast<u8>(mapper & 0xF0);
+  }
+
+  u16 pc() const { return _pc; }
+  void org(u16 address) { _pc = address; }
+  void emit(std::initializer_list<u8> bytes) {
+    for (u8 b : bytes) prg(_pc++) = b;
+  }
+
+  void vectors(u16 nmi, u16 reset, u16 irq) {
+    const u16 targets[3] = {nmi, reset, irq};
+    for (int i = 0; i < 3; i++) {
+      prg(static_cast<u16>(0xFFFA + 2 * i)) = static_cast<u8>(targets[i]);
+      prg(static_cast<u16>(0xFFFB + 2 * i)) = static_cast<u8>(targets[i] >> 8);
+    }
+  }
+
+  u8* chr() { return _image.data() + 16 + _prg_size; }
+  int chr_size() const { return _chr_size; }
+  const std::vector<u8>& image() const { return _image; }
+
+  // A fresh cartridge each call, so several machines can run the same image.
+  std::shared_ptr<Cartridge> cartridge() const {
+    int status = -1;
+    return Cartridge::from_ines(_image, status);
+  }
+
+ private:
+  u8& prg(u16 address) { return _image[16 + _prg_size - 0x10000 + address]; }
+
+  int _prg_size;
+  int _chr_size;
+  u16 _pc = 0xC000;
+  std::vector<u8> _image;
+};
+
+// The machine's save_state() snapshot, for comparing whole machines.
+inline std::vector<u8> snapshot(Bus& bus) {
+  std::vector<u8> s(bus.state_size());
+  bus.save_state(s.data());
+  return s;
+}
+
+}  // namespace nes
@@ -29,6 +29,7 @@ function makeCtx(overrides: Partial<EmulatorContextValue> = {}): EmulatorContext
     loadRom: vi.fn(() => 0),
     loadOpcodes: vi.fn(),
     setController: vi.fn(),
+    setRewinding: vi.fn(),
     playMovie: vi.fn(),
     stopMovie: vi.fn(),
     connectLiveAgent: vi.fn(),
@@ -25,7 +25,7 @@ export function AppShell(): JSX.Element {
   // Capture the keyboard for player 1 whenever the core is running — in the
   // cockpit (Toolbar "Run") as well as in the full-screen Play overlay. Without
   // this, a game launched from the cockpit could not be controlled at all.
-  useController(actions.setController, running || play);
+  useController(actions.setController, running || play, actions.setRewinding);
   useEffect(() => {
     if (play) actions.run();
     else actions.stop();
@@ -31,6 +31,7 @@ function makeContext(
     loadRom: vi.fn(() => 0),
     loadOpcodes: vi.fn(),
     setController: vi.fn(),
+    setRewinding: vi.fn(),
     playMovie: vi.fn(),
     stopMovie: vi.fn(),
     connectLiveAgent: vi.fn(),
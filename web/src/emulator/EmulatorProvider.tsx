@@ -19,6 +19,15 @@ import { parseMovie } from "./movie";
 import { DEFAULT_GAME, romUrl } from "../games/catalog";
 import { useToast } from "../components/toast/ToastProvider";
 
+// Rewind history kept by the core (see nes::Rewind): a few hundred bytes to a
+// few KB a frame, so this holds half a minute to a few minutes of play.
+const REWIND_BUDGET = 4 << 20;
+
+// Frames of run-ahead while playing (see Debugger.setRunAhead), for kiosk
+// builds where input latency matters more than CPU: VITE_RUN_AHEAD=1 or 2.
+const RUN_AHEAD =
+  Number(import.meta.env.VITE_RUN_AHEAD as string | undefined) || 0;
+
 // The live-agent server (python -m nesenv.live) streams Server-Sent Events to here.
 // This is a local dev / research feature: in production the default points at the
 // visitor's own machine (and an HTTPS page blocks plain-http localhost anyway), so
@@ -47,6 +56,7 @@ export interface EmulatorActions {
   loadRom(data: Uint8Array): number;
   loadOpcodes(text: string): void;
   setController(state: number, port?: number): void;
+  setRewinding(on: boolean): void;
   playMovie(data: Uint8Array): void;
   stopMovie(): void;
   connectLiveAgent(url?: string): void;
@@ -107,6 +117,20 @@ export function EmulatorProvider(props: {
   }, [addToast]);
 
   const audioRef = useRef(new NesAudio());
+  const audioRateRef = useRef(0);
+  // Unlock WebAudio (call from a user gesture) and have the core make samples
+  // at the context's rate. Setting the rate empties the queue, so only when
+  // it changes.
+  const resumeAudio = useCallback((bridge: Debugger) => {
+    const audio = audioRef.current;
+    audio.resume();
+    if (audio.sampleRate && audio.sampleRate !== audioRateRef.current) {
+      bridge.setAudioOutput(audio.sampleRate);
+      audioRateRef.current = audio.sampleRate;
+    }
+  }, []);
+  const rewindingRef = useRef(false);
+  const isRewinding = useCallback(() => rewindingRef.current, []);
 
   const handleFrame = useCallback((fb: Uint8ClampedArray) => {
     // Copy out of the WASM heap view so React state holds a stable buffer
@@ -136,6 +160,8 @@ export function EmulatorProvider(props: {
     onSnapshot: publishSnapshot,
     onBreak: handleBreak,
     onBrk: handleBrk,
+    rewinding: isRewinding,
+    runAhead: RUN_AHEAD,
   });
 
   useEffect(() => {
@@ -144,6 +170,7 @@ export function EmulatorProvider(props: {
       .then((module) => {
         if (cancelled) return;
         const bridge = createBridge(module);
+        bridge.rewindEnable(REWIND_BUDGET);
         dbgRef.current = bridge;
         setDbg(bridge);
         setSnapshot(bridge.getSnapshot());
@@ -211,10 +238,10 @@ export function EmulatorProvider(props: {
     const bridge = dbgRef.current;
     if (!bridge) return;
     bridge.run();
-    audioRef.current.resume();  // user-gesture-initiated; unlocks WebAudio
+    resumeAudio(bridge);
     addToast("Execution started", "info");
     startLoop();
-  }, [addToast, startLoop]);
+  }, [addToast, startLoop, resumeAudio]);
 
   const stopMovie = useCallback(() => {
     if (movieRafRef.current !== null) {
@@ -275,7 +302,7 @@ export function EmulatorProvider(props: {
         addToast("Movie ROM was rejected", "danger");
         return;
       }
-      audioRef.current.resume(); // user-gesture-initiated; unlocks WebAudio
+      resumeAudio(bridge);
       const inputs = parsed.inputs;
       setMovie({ playing: true, frame: 0, total: inputs.length });
       addToast(`Playing movie — ${inputs.length} frames`, "info");
@@ -306,7 +333,7 @@ export function EmulatorProvider(props: {
       };
       movieRafRef.current = requestAnimationFrame(tick);
     },
-    [addToast, stopLoop],
+    [addToast, stopLoop, resumeAudio],
   );
 
   // Watch a live agent: connect to the SSE stream and re-simulate the streamed
@@ -319,7 +346,7 @@ export function EmulatorProvider(props: {
       stopLoop();
       stopMovie();
       disconnectLiveAgent();
-      audioRef.current.resume();
+      resumeAudio(bridge);
 
       let frames = 0;
       const es = new EventSource(url);
@@ -352,7 +379,7 @@ export function EmulatorProvider(props: {
         disconnectLiveAgent();
       };
     },
-    [addToast, stopLoop, stopMovie, disconnectLiveAgent],
+    [addToast, stopLoop, stopMovie, disconnectLiveAgent, resumeAudio],
   );
 
   // BRK (opcode 0x00) handling: the C++ core dispatches `nes-brk-encountered`
@@ -461,6 +488,10 @@ export function EmulatorProvider(props: {
     dbgRef.current?.setController(state, port);
   }, []);
 
+  const setRewinding = useCallback((on: boolean) => {
+    rewindingRef.current = on;
+  }, []);
+
   const actions = useMemo<EmulatorActions>(
     () => ({
       step,
@@ -475,6 +506,7 @@ export function EmulatorProvider(props: {
       loadRom,
       loadOpcodes,
       setController,
+      setRewinding,
       playMovie,
       stopMovie,
       connectLiveAgent,
@@ -493,6 +525,7 @@ export function EmulatorProvider(props: {
       loadRom,
       loadOpcodes,
       setController,
+      setRewinding,
       playMovie,
       stopMovie,
       connectLiveAgent,
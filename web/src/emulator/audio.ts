@@ -1,13 +1,18 @@
-// WebAudio sink for the emulator. Samples are generated by the core at 44.1kHz
-// and pushed each frame; we queue them as small AudioBuffers scheduled
-// back-to-back so playback stays gapless without a ScriptProcessor/Worklet.
-const SAMPLE_RATE = 44100;
+// WebAudio sink for the emulator. The core makes samples at the context's own
+// rate (see sampleRate) and they are pushed each frame; we queue them as small
+// AudioBuffers scheduled back-to-back so playback stays gapless without a
+// ScriptProcessor/Worklet.
 
 export class NesAudio {
   private ctx: AudioContext | null = null;
   private gain: GainNode | null = null;
   private next = 0; // scheduled end time of the last queued buffer
 
+  /** The device rate the core should produce, or 0 before resume(). */
+  get sampleRate(): number {
+    return this.ctx?.sampleRate ?? 0;
+  }
+
   /** Create/resume the context. Must be called from a user gesture. */
   resume(): void {
     if (!this.ctx) {
@@ -29,8 +34,8 @@ export class NesAudio {
   pump(samples: Float32Array): void {
     const ctx = this.ctx;
     if (!ctx || !this.gain || samples.length === 0) return;
-    // The core targets 44.1kHz; WebAudio resamples to the device rate.
-    const buf = ctx.createBuffer(1, samples.length, SAMPLE_RATE);
+    // The core produces at ctx.sampleRate, so no resampling happens here.
+    const buf = ctx.createBuffer(1, samples.length, ctx.sampleRate);
     // set() takes ArrayLike<number>, sidestepping Float32Array buffer-generic variance.
     buf.getChannelData(0).set(samples);
     const src = ctx.createBufferSource();
@@ -40,7 +45,7 @@ export class NesAudio {
     // Resync if we have fallen behind (or on first push), keeping a small lead.
     if (this.next < now + 0.02) this.next = now + 0.08;
     src.start(this.next);
-    this.next += samples.length / SAMPLE_RATE;
+    this.next += samples.length / ctx.sampleRate;
   }
 
   suspend(): void {
@@ -20,8 +20,11 @@ export const CONTROL_HINTS: Array<{ keys: string; label: string }> = [
   { keys: "Z", label: "B" },
   { keys: "Enter", label: "Start" },
   { keys: "Shift", label: "Select" },
+  { keys: "Backspace", label: "Rewind (hold)" },
 ];
 
+const REWIND_KEY = "Backspace";
+
 // Don't steal controller keys (Enter / arrows / X-Z) while the user is typing
 // into a debugger field — the cockpit runs the game alongside editable inputs.
 function isEditableTarget(target: EventTarget | null): boolean {
@@ -41,10 +44,12 @@ function isEditableTarget(target: EventTarget | null): boolean {
  * button bitmask into the core on every key edge. Game keys are captured
  * (preventDefault) so arrows don't scroll the page during play — except while a
  * debugger text field is focused, where the keystroke is left to the input.
+ * Holding Backspace rewinds, through `setRewinding`.
  */
 export function useController(
   setController: (state: number, port?: number) => void,
   enabled: boolean,
+  setRewinding?: (on: boolean) => void,
 ): void {
   const maskRef = useRef(0);
 
@@ -52,9 +57,15 @@ export function useController(
     if (!enabled) {
       maskRef.current = 0;
       setController(0);
+      setRewinding?.(false);
       return;
     }
     const onDown = (e: KeyboardEvent) => {
+      if (e.code === REWIND_KEY && setRewinding && !isEditableTarget(e.target)) {
+        e.preventDefault();
+        setRewinding(true);
+        return;
+      }
       const bit = KEYMAP[e.code];
       if (bit === undefined || e.repeat) return;
       if (isEditableTarget(e.target)) return;
@@ -63,6 +74,10 @@ export function useController(
       setController(maskRef.current);
     };
     const onUp = (e: KeyboardEvent) => {
+      if (e.code === REWIND_KEY && setRewinding) {
+        setRewinding(false);
+        return;
+      }
       const bit = KEYMAP[e.code];
       if (bit === undefined) return;
       if (isEditableTarget(e.target)) return;
@@ -77,6 +92,7 @@ export function useController(
       window.removeEventListener("keyup", onUp);
       maskRef.current = 0;
       setController(0);
+      setRewinding?.(false);
     };
-  }, [enabled, setController]);
+  }, [enabled, setController, setRewinding]);
 }
@@ -11,6 +11,8 @@ import type { Debugger } from "../wasm/bridge";
 
 interface FakeBridge extends Debugger {
   frames: number;
+  rewound: number;
+  runAhead: number;
 }
 
 function makeFakeBridge(opts?: {
@@ -22,6 +24,15 @@ function makeFakeBridge(opts?: {
   const reason = opts?.reason ?? RUN_FRAME_OK;
   const bridge = {
     frames: 0,
+    rewound: 0,
+    runAhead: 0,
+    setRunAhead(n: number) {
+      bridge.runAhead = n;
+    },
+    rewind(n: number) {
+      bridge.rewound += n;
+      return n;
+    },
     runFrame() {
       frames += 1;
       bridge.frames = frames;
@@ -271,6 +282,52 @@ describe("useFrameLoop", () => {
     expect(dbg.frames).toBe(before);
   });
 
+  it("rewinds instead of running while rewinding() is true", () => {
+    const dbg = makeFakeBridge();
+    const onFrame = vi.fn();
+    let rewinding = false;
+    const { result } = renderHook(() =>
+      useFrameLoop({
+        dbg,
+        onFrame,
+        onSnapshot: () => {},
+        onBreak: () => {},
+        onBrk: () => {},
+        rewinding: () => rewinding,
+      }),
+    );
+    act(() => result.current.start());
+    act(() => flushFrame());
+    rewinding = true;
+    act(() => flushFrame());
+    act(() => flushFrame());
+    expect(dbg.frames).toBe(1);
+    expect(dbg.rewound).toBe(2);
+    expect(onFrame).toHaveBeenCalledTimes(3); // the rewound frames are shown
+    rewinding = false;
+    act(() => flushFrame());
+    expect(dbg.frames).toBe(2);
+  });
+
+  it("turns run-ahead on while running and off when stopped", () => {
+    const dbg = makeFakeBridge();
+    const { result } = renderHook(() =>
+      useFrameLoop({
+        dbg,
+        onFrame: () => {},
+        onSnapshot: () => {},
+        onBreak: () => {},
+        onBrk: () => {},
+        runAhead: 2,
+      }),
+    );
+    expect(dbg.runAhead).toBe(0);
+    act(() => result.current.start());
+    expect(dbg.runAhead).toBe(2);
+    act(() => result.current.stop());
+    expect(dbg.runAhead).toBe(0);
+  });
+
   it("does nothing when dbg is null", () => {
     const { result } = renderHook(() =>
       useFrameLoop({
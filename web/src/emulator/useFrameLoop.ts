@@ -18,8 +18,16 @@ export function useFrameLoop(args: {
   onSnapshot: (s: EmulatorSnapshot) => void;
   onBreak: () => void;
   onBrk: () => void;
+  // While true, each animation frame steps one recorded frame back (see
+  // Debugger.rewind) instead of emulating one forward.
+  rewinding?: () => boolean;
+  // Frames of run-ahead while the loop runs (see Debugger.setRunAhead); the
+  // core is set back to 0 when it stops, so single steps and movie playback
+  // show the real frame.
+  runAhead?: number;
 }): { start(): void; stop(): void; running: boolean } {
-  const { dbg, onFrame, onSnapshot, onBreak, onBrk } = args;
+  const { dbg, onFrame, onSnapshot, onBreak, onBrk, rewinding, runAhead = 0 } =
+    args;
   const [running, setRunning] = useState(false);
   const rafRef = useRef<number | null>(null);
   const lastSnapshotRef = useRef(-Infinity);
@@ -29,11 +37,13 @@ export function useFrameLoop(args: {
   const onSnapshotRef = useRef(onSnapshot);
   const onBreakRef = useRef(onBreak);
   const onBrkRef = useRef(onBrk);
+  const rewindingRef = useRef(rewinding);
   const dbgRef = useRef(dbg);
   onFrameRef.current = onFrame;
   onSnapshotRef.current = onSnapshot;
   onBreakRef.current = onBreak;
   onBrkRef.current = onBrk;
+  rewindingRef.current = rewinding;
   dbgRef.current = dbg;
 
   const cancel = useCallback(() => {
@@ -48,6 +58,12 @@ export function useFrameLoop(args: {
     setRunning(false);
   }, [cancel]);
 
+  useEffect(() => {
+    if (!dbg || !running || runAhead <= 0) return;
+    dbg.setRunAhead(runAhead);
+    return () => dbg.setRunAhead(0);
+  }, [dbg, running, runAhead]);
+
   const frame = useCallback(() => {
     const bridge = dbgRef.current;
     if (!bridge) {
@@ -56,7 +72,9 @@ export function useFrameLoop(args: {
       return;
     }
 
-    const reason = bridge.runFrame();
+    let reason = RUN_FRAME_OK;
+    if (rewindingRef.current?.()) bridge.rewind(1);
+    else reason = bridge.runFrame();
     onFrameRef.current(bridge.getFramebuffer());
 
     const t = performance.now();
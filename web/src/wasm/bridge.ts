@@ -59,8 +59,16 @@ export interface Debugger {
   getPaletteRam(): Uint8Array;
   getOam(): Uint8Array;
   setController(state: number, port?: number): void;
+  setAudioOutput(sampleRate: number, capacity?: number): void;
   audioAvailable(): number;
   audioDrain(max: number): Float32Array;
+  audioCapacity(): number;
+  audioOverruns(): number;
+  audioUnderruns(): number;
+  rewindEnable(budgetBytes: number, keyframeInterval?: number): void;
+  rewind(frames: number): number;
+  rewindDepth(): number;
+  setRunAhead(frames: number): void;
   ppuState(): { ctrl: number; mask: number; status: number; scanline: number };
 }
 
@@ -168,6 +176,10 @@ export function createBridge(module: WasmModule): Debugger {
     "number",
     "number",
   ]) as (port: number, buttons: number) => void;
+  const setAudioOutputRaw = module.cwrap("set_audio_output", null, [
+    "number",
+    "number",
+  ]) as (rate: number, capacity: number) => void;
   const audioAvailableRaw = module.cwrap(
     "audio_available",
     "number",
@@ -177,9 +189,39 @@ export function createBridge(module: WasmModule): Debugger {
     "number",
     "number",
   ]) as (ptr: number, max: number) => number;
-  // Reusable heap buffer for draining audio samples (one frame is ~735 samples).
+  const audioCapacity = module.cwrap(
+    "audio_capacity",
+    "number",
+    [],
+  ) as () => number;
+  const audioOverruns = module.cwrap(
+    "audio_overruns",
+    "number",
+    [],
+  ) as () => number;
+  const audioUnderruns = module.cwrap(
+    "audio_underruns",
+    "number",
+    [],
+  ) as () => number;
+  // Reusable heap buffer for draining audio samples (one frame is ~800 at 48kHz).
   const AUDIO_BUF = 4096;
   const audioBufPtr = module._malloc(AUDIO_BUF * 4);
+  const rewindEnableRaw = module.cwrap("rewind_enable", null, [
+    "number",
+    "number",
+  ]) as (budget: number, keyframeInterval: number) => void;
+  const rewindRaw = module.cwrap("rewind_frames", "number", ["number"]) as (
+    frames: number,
+  ) => number;
+  const rewindDepth = module.cwrap(
+    "rewind_depth",
+    "number",
+    [],
+  ) as () => number;
+  const setRunAheadRaw = module.cwrap("set_run_ahead", null, ["number"]) as (
+    frames: number,
+  ) => void;
   const ppuGetCtrl = module.cwrap("ppu_get_ctrl", "number", []) as () => number;
   const ppuGetMask = module.cwrap("ppu_get_mask", "number", []) as () => number;
   const ppuGetStatus = module.cwrap(
@@ -356,6 +398,12 @@ export function createBridge(module: WasmModule): Debugger {
     setControllerRaw(port, state & 0xff);
   }
 
+  // Make samples at the rate the AudioContext plays (so WebAudio need not
+  // resample) into a queue of `capacity`. Starts an empty queue.
+  function setAudioOutput(sampleRate: number, capacity = 8192): void {
+    setAudioOutputRaw(Math.round(sampleRate), capacity);
+  }
+
   function audioAvailable(): number {
     return audioAvailableRaw();
   }
@@ -369,6 +417,23 @@ export function createBridge(module: WasmModule): Debugger {
     ).slice();
   }
 
+  // Completed runFrame()s are recorded in a ring of budgetBytes (0 = off);
+  // rewind() steps back that many of them and returns how many it went.
+  function rewindEnable(budgetBytes: number, keyframeInterval = 60): void {
+    rewindEnableRaw(budgetBytes, keyframeInterval);
+  }
+
+  function rewind(frames: number): number {
+    return rewindRaw(frames);
+  }
+
+  // After each runFrame(), emulate `frames` more with the same input and show
+  // that picture instead (the machine itself stays on the real frame). Hides
+  // that many frames of the game's input lag; 0 = off.
+  function setRunAhead(frames: number): void {
+    setRunAheadRaw(Math.max(0, frames | 0));
+  }
+
   function ppuState(): {
     ctrl: number;
     mask: number;
@@ -412,8 +477,16 @@ export function createBridge(module: WasmModule): Debugger {
     getPaletteRam,
     getOam,
     setController,
+    setAudioOutput,
     audioAvailable,
     audioDrain,
+    audioCapacity,
+    audioOverruns,
+    audioUnderruns,
+    rewindEnable,
+    rewind,
+    rewindDepth,
+    setRunAhead,
     ppuState,
   };
 }
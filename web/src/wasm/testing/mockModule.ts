@@ -216,10 +216,25 @@ export function createMockModule(opts?: {
         return OAM_PTR;
       case "set_controller":
         return;  // no-op in the mock (input is exercised via the real core)
+      case "set_audio_output":
+        return;
       case "audio_available":
         return 0;  // the mock produces no audio
       case "audio_drain":
         return 0;
+      case "audio_capacity":
+        return 8192;
+      case "audio_overruns":
+      case "audio_underruns":
+        return 0;
+      case "rewind_enable":
+        return;  // the mock keeps no history
+      case "rewind_frames":
+        return -1;
+      case "rewind_depth":
+        return 0;
+      case "set_run_ahead":
+        return;  // the mock always shows the real frame
       case "ppu_get_ctrl":
         return state.ppu.ctrl;
       case "ppu_get_mask":